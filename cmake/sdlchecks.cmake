@@ -836,23 +836,26 @@ endmacro()
 # Requires:
 # - n/a
 macro(CheckMali)
-  if(VIDEO_MALI)
+  if(SDL_MALI)
     check_c_source_compiles("
         #define LINUX
         #define EGL_API_FB
         #include <EGL/egl.h>
-        int main(int argc, char** argv) {}" HAVE_VIDEO_MALI_EGL_FB)
+        int main(int argc, char** argv) { return 0; }" HAVE_VIDEO_MALI_EGL_FB)
     if(HAVE_VIDEO_MALI_EGL_FB)
       set(HAVE_VIDEO_MALI TRUE)
       set(HAVE_SDL_VIDEO TRUE)
 
       file(GLOB MALI_SOURCES ${SDL2_SOURCE_DIR}/src/video/mali-fbdev/*.c)
-      set(SOURCE_FILES ${SOURCE_FILES} ${MALI_SOURCES})
+      list(APPEND SOURCE_FILES ${MALI_SOURCES})
       set(SDL_VIDEO_DRIVER_MALI 1)
-      set(SDL_CFLAGS "${SDL_CFLAGS} -DLINUX -DEGL_API_FB")
+      if(SDL_MALI_SIM)
+        set(SDL_VIDEO_DRIVER_MALI_SIM 1)
+      endif()
+      list(APPEND SDL_CFLAGS -DLINUX -DEGL_API_FB)
       list(APPEND EXTRA_LIBS EGL)
-    endif(HAVE_VIDEO_MALI_EGL_MALI)
-  endif(VIDEO_MALI)
+    endif()
+  endif()
 endmacro(CheckMali)
 
 # Requires:
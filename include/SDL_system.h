@@ -183,6 +183,166 @@ extern DECLSPEC int SDLCALL SDL_LinuxSetThreadPriority(Sint64 threadID, int prio
  */
 extern DECLSPEC int SDLCALL SDL_LinuxSetThreadPriorityAndPolicy(Sint64 threadID, int sdlPriority, int schedPolicy);
  
+#endif /* __LINUX__ */
+
+/* Platform specific functions for the Mali fbdev video driver */
+#ifdef __LINUX__
+
+/**
+ * Timing of one stage of the mali-fbdev swap pipeline, in microseconds.
+ */
+typedef struct SDL_MaliTiming
+{
+    Uint32 min;
+    Uint32 avg;
+    Uint32 p99;
+} SDL_MaliTiming;
+
+/**
+ * Frame statistics of a window, see SDL_MaliGetFrameStats().
+ */
+typedef struct SDL_MaliFrameStats
+{
+    Uint32 submitted;        /**< Frames submitted with SDL_GL_SwapWindow() */
+    Uint32 presented;        /**< Frames presented to the display */
+    Uint32 dropped;          /**< Frames replaced by a newer one before being presented */
+    Uint32 samples;          /**< Number of recent frames the timings below cover */
+    SDL_MaliTiming fence;    /**< Fence creation until the blitter saw it signaled */
+    SDL_MaliTiming present;  /**< Blit start until eglSwapBuffers() returned */
+    SDL_MaliTiming latency;  /**< Swap submission until eglSwapBuffers() returned */
+    SDL_MaliTiming interval; /**< Time between two consecutive presentations */
+} SDL_MaliFrameStats;
+
+/**
+ * Get the frame timing statistics of a window on the mali-fbdev driver.
+ *
+ * The driver timestamps every frame going through the blitter and keeps the
+ * most recent ones, the amount is set by the "SDL_MALI_STATS_FRAMES" hint
+ * before the window is created.
+ *
+ * \param window the window to query
+ * \param stats a pointer filled in with the statistics
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ */
+extern DECLSPEC int SDLCALL SDL_MaliGetFrameStats(SDL_Window *window, SDL_MaliFrameStats *stats);
+
+/**
+ * Tell the mali-fbdev driver which parts of the next frame changed.
+ *
+ * Applies to the next SDL_GL_SwapWindow() only. The frame must still be
+ * rendered in full, the hint lets the blitter restrict its work to the
+ * changed region of the screen when the EGL implementation reports buffer
+ * ages. A swap with no changed rects at all is skipped, the previous frame
+ * stays on screen.
+ *
+ * \param window the window the next swap is made on
+ * \param rects an array of rects in drawable pixels, see
+ *              SDL_GL_GetDrawableSize(), may be NULL if `numrects` is 0
+ * \param numrects the number of rects in `rects`
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ */
+extern DECLSPEC int SDLCALL SDL_MaliSetSwapDamage(SDL_Window *window, const SDL_Rect *rects, int numrects);
+
+/**
+ * Get the vblank timing of the display a window is on with the mali-fbdev
+ * driver.
+ *
+ * The refresh period comes from the display mode timings, unlike the
+ * rounded refresh rate of SDL_DisplayMode. Vblanks are timestamped with
+ * FBIO_WAITFORVSYNC where the framebuffer driver supports it, otherwise
+ * with the times the driver's swaps return while vsync is enabled.
+ *
+ * Both values are in SDL_GetPerformanceCounter() ticks.
+ *
+ * \param window the window to query
+ * \param timestamp filled in with the time of the most recent vblank, 0 if
+ *                  none was seen yet; may be NULL
+ * \param interval filled in with the time between two vblanks; may be NULL
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ */
+extern DECLSPEC int SDLCALL SDL_MaliGetVblank(SDL_Window *window, Uint64 *timestamp, Uint64 *interval);
+
+/**
+ * Let the mali-fbdev driver scale the render size of an OpenGL ES window
+ * with the GPU load.
+ *
+ * When frames take too long to render for the display's refresh rate, the
+ * buffers the application draws into shrink, down to the given minimum, and
+ * grow back to the window size once there's time to spare. The blitter
+ * scales them to the screen. The window size itself doesn't change: query
+ * the current render size with SDL_GL_GetDrawableSize(), which the driver
+ * signals changes of with SDL_WINDOWEVENT_SIZE_CHANGED.
+ *
+ * Call this from the thread rendering to the window.
+ *
+ * \param window the window to scale
+ * \param min_w the smallest render width, 0 to disable dynamic resolution
+ * \param min_h the smallest render height, 0 to disable dynamic resolution
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ */
+extern DECLSPEC int SDLCALL SDL_MaliSetDynamicResolution(SDL_Window *window, int min_w, int min_h);
+
+/**
+ * Record the frames the mali-fbdev driver presents on a window.
+ *
+ * Frames are copied off the screen buffers by a background thread and written
+ * to `path`, a file or a named pipe; opening a named pipe waits for a reader.
+ * Paths ending in ".y4m" get a YUV4MPEG2 stream, 4:2:0 at the display's
+ * refresh rate, any other path gets the raw frames back to back in the pixel
+ * format of the window buffers. Presenting never waits for the recording:
+ * frames that come in while the previous one is still being written are
+ * skipped. Any capture already running on the window is stopped first.
+ *
+ * The SDL_MALI_CAPTURE environment variable or hint starts a capture to the
+ * path it's set to when a window is created, unless another window is still
+ * recording there from it.
+ *
+ * \param window the window to record
+ * \param path the file or named pipe to write the frames to
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \sa SDL_MaliStopCapture
+ */
+extern DECLSPEC int SDLCALL SDL_MaliStartCapture(SDL_Window *window, const char *path);
+
+/**
+ * Stop recording the frames of a window, see SDL_MaliStartCapture().
+ *
+ * Waits for the frame being written, then closes the file.
+ *
+ * \param window the window to stop recording
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ */
+extern DECLSPEC int SDLCALL SDL_MaliStopCapture(SDL_Window *window);
+
+/**
+ * Show a surface above the window on the mali-fbdev driver.
+ *
+ * The blitter composites overlay layers over every frame it presents, at the
+ * display's resolution and orientation, independently of how the window is
+ * scaled: use them for OSD elements such as FPS counters or volume bars that
+ * shouldn't go through the application's own rendering. The surface is copied,
+ * call this again to update its contents or move it. The mouse cursor is
+ * drawn above all layers.
+ *
+ * \param window the window to show the layer over
+ * \param layer the layer to set, from 0 to 3; higher layers go on top
+ * \param surface the contents of the layer, blended by their alpha channel;
+ *                NULL to hide the layer
+ * \param dst where to show the surface in display coordinates; its size is
+ *            the surface's when empty, and NULL places it at the top left
+ *            corner
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ */
+extern DECLSPEC int SDLCALL SDL_MaliSetOverlay(SDL_Window *window, int layer, SDL_Surface *surface, const SDL_Rect *dst);
+
 #endif /* __LINUX__ */
 	
 /* Platform specific functions for iOS */
@@ -902,3 +902,10 @@
 #define SDL_GDKSuspendComplete SDL_GDKSuspendComplete_REAL
 #define SDL_HasWindowSurface SDL_HasWindowSurface_REAL
 #define SDL_DestroyWindowSurface SDL_DestroyWindowSurface_REAL
+#define SDL_MaliGetFrameStats SDL_MaliGetFrameStats_REAL
+#define SDL_MaliSetSwapDamage SDL_MaliSetSwapDamage_REAL
+#define SDL_MaliGetVblank SDL_MaliGetVblank_REAL
+#define SDL_MaliSetDynamicResolution SDL_MaliSetDynamicResolution_REAL
+#define SDL_MaliStartCapture SDL_MaliStartCapture_REAL
+#define SDL_MaliStopCapture SDL_MaliStopCapture_REAL
+#define SDL_MaliSetOverlay SDL_MaliSetOverlay_REAL
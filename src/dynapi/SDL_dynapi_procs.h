@@ -987,3 +987,12 @@ SDL_DYNAPI_PROC(void,SDL_GDKSuspendComplete,(void),(),)
 #endif
 SDL_DYNAPI_PROC(SDL_bool,SDL_HasWindowSurface,(SDL_Window *a),(a),return)
 SDL_DYNAPI_PROC(int,SDL_DestroyWindowSurface,(SDL_Window *a),(a),return)
+#ifdef __LINUX__
+SDL_DYNAPI_PROC(int,SDL_MaliGetFrameStats,(SDL_Window *a, SDL_MaliFrameStats *b),(a,b),return)
+SDL_DYNAPI_PROC(int,SDL_MaliSetSwapDamage,(SDL_Window *a, const SDL_Rect *b, int c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_MaliGetVblank,(SDL_Window *a, Uint64 *b, Uint64 *c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_MaliSetDynamicResolution,(SDL_Window *a, int b, int c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_MaliStartCapture,(SDL_Window *a, const char *b),(a,b),return)
+SDL_DYNAPI_PROC(int,SDL_MaliStopCapture,(SDL_Window *a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_MaliSetOverlay,(SDL_Window *a, int b, SDL_Surface *c, const SDL_Rect *d),(a,b,c,d),return)
+#endif
@@ -28,6 +28,9 @@
 #include "../SDL_sysrender.h"
 #include "../../video/SDL_blit.h"
 #include "SDL_shaders_gles2.h"
+#if SDL_VIDEO_DRIVER_MALI
+#include "../../video/mali-fbdev/SDL_malistream.h"
+#endif
 
 /* WebGL doesn't offer client-side arrays, so use Vertex Buffer Objects
    on Emscripten, which converts GLES2 into WebGL calls.
@@ -75,6 +78,9 @@ typedef struct GLES2_TextureData
     GLuint texture_u;
 #endif
     GLES2_FBOList *fbo;
+#if SDL_VIDEO_DRIVER_MALI
+    MALI_Stream *stream; /* streaming pixels live in dma-buf memory, see SDL_malistream.c */
+#endif
 } GLES2_TextureData;
 
 typedef struct GLES2_ProgramCacheEntry
@@ -1017,18 +1023,38 @@ static int SetDrawState(GLES2_RenderData *data, const SDL_RenderCommand *cmd, co
     return 0;
 }
 
+/* The format the shaders see the texture in, which isn't always the one it was uploaded as */
+static Uint32 GLES2_GetSampledFormat(SDL_Texture *texture)
+{
+#if SDL_VIDEO_DRIVER_MALI
+    GLES2_TextureData *tdata = (GLES2_TextureData *)texture->driverdata;
+
+    /* dma-buf imports sample in the right channel order, no swizzling needed */
+    if (tdata->stream) {
+        switch (texture->format) {
+        case SDL_PIXELFORMAT_ARGB8888:
+            return SDL_PIXELFORMAT_ABGR8888;
+        case SDL_PIXELFORMAT_RGB888:
+            return SDL_PIXELFORMAT_BGR888;
+        }
+    }
+#endif
+    return texture->format;
+}
+
 static int SetCopyState(SDL_Renderer *renderer, const SDL_RenderCommand *cmd, void *vertices)
 {
     GLES2_RenderData *data = (GLES2_RenderData *)renderer->driverdata;
     GLES2_ImageSource sourceType = GLES2_IMAGESOURCE_TEXTURE_ABGR;
     SDL_Texture *texture = cmd->data.draw.texture;
+    Uint32 format = GLES2_GetSampledFormat(texture);
     int ret;
 
     /* Pick an appropriate shader */
     if (renderer->target) {
         /* Check if we need to do color mapping between the source and render target textures */
-        if (renderer->target->format != texture->format) {
-            switch (texture->format) {
+        if (renderer->target->format != format) {
+            switch (format) {
             case SDL_PIXELFORMAT_ARGB8888:
                 switch (renderer->target->format) {
                 case SDL_PIXELFORMAT_ABGR8888:
@@ -1099,7 +1125,7 @@ static int SetCopyState(SDL_Renderer *renderer, const SDL_RenderCommand *cmd, vo
             sourceType = GLES2_IMAGESOURCE_TEXTURE_ABGR; /* Texture formats match, use the non color mapping shader (even if the formats are not ABGR) */
         }
     } else {
-        switch (texture->format) {
+        switch (format) {
         case SDL_PIXELFORMAT_ARGB8888:
             sourceType = GLES2_IMAGESOURCE_TEXTURE_ARGB;
             break;
@@ -1474,6 +1500,19 @@ static int GLES2_CreateTexture(SDL_Renderer *renderer, SDL_Texture *texture)
 #endif
     scaleMode = (texture->scaleMode == SDL_ScaleModeNearest) ? GL_NEAREST : GL_LINEAR;
 
+#if SDL_VIDEO_DRIVER_MALI
+    /* Lock streaming textures straight in memory the GPU samples, if the driver can */
+    if (texture->access == SDL_TEXTUREACCESS_STREAMING) {
+        data->stream = MALI_CreateStream(texture->format, texture->w, texture->h);
+        if (data->stream) {
+            data->texture = MALI_GetStreamTexture(data->stream);
+            MALI_SetStreamFilter(data->stream, scaleMode);
+            texture->driverdata = data;
+            return GL_CheckError("", renderer);
+        }
+    }
+#endif
+
     /* Allocate a blob for image renderdata */
     if (texture->access == SDL_TEXTUREACCESS_STREAMING) {
         size_t size;
@@ -1645,6 +1684,25 @@ static int GLES2_UpdateTexture(SDL_Renderer *renderer, SDL_Texture *texture, con
         return 0;
     }
 
+#if SDL_VIDEO_DRIVER_MALI
+    if (tdata->stream) {
+        const Uint8 *src = (const Uint8 *)pixels;
+        const size_t length = (size_t)rect->w * SDL_BYTESPERPIXEL(texture->format);
+        Uint8 *dst;
+        int dst_pitch, y;
+
+        dst = (Uint8 *)MALI_LockStream(tdata->stream, rect, &dst_pitch);
+        for (y = 0; y < rect->h; y++) {
+            SDL_memcpy(dst, src, length);
+            src += pitch;
+            dst += dst_pitch;
+        }
+        tdata->texture = MALI_UnlockStream(tdata->stream);
+        data->drawstate.texture = NULL;
+        return 0;
+    }
+#endif
+
     data->drawstate.texture = NULL; /* we trash this state. */
 
     /* Create a texture subimage with the supplied data */
@@ -1807,6 +1865,15 @@ static int GLES2_LockTexture(SDL_Renderer *renderer, SDL_Texture *texture, const
 {
     GLES2_TextureData *tdata = (GLES2_TextureData *)texture->driverdata;
 
+#if SDL_VIDEO_DRIVER_MALI
+    if (tdata->stream) {
+        /* The fence set on the shown buffer needs the renderer's context */
+        GLES2_ActivateRenderer(renderer);
+        *pixels = MALI_LockStream(tdata->stream, rect, pitch);
+        return 0;
+    }
+#endif
+
     /* Retrieve the buffer/pitch for the specified region */
     *pixels = (Uint8 *)tdata->pixel_data +
               (tdata->pitch * rect->y) +
@@ -1821,6 +1888,18 @@ static void GLES2_UnlockTexture(SDL_Renderer *renderer, SDL_Texture *texture)
     GLES2_TextureData *tdata = (GLES2_TextureData *)texture->driverdata;
     SDL_Rect rect;
 
+#if SDL_VIDEO_DRIVER_MALI
+    if (tdata->stream) {
+        GLES2_RenderData *data = (GLES2_RenderData *)renderer->driverdata;
+
+        /* Nothing to upload, draws just sample the buffer that was written to */
+        GLES2_ActivateRenderer(renderer);
+        tdata->texture = MALI_UnlockStream(tdata->stream);
+        data->drawstate.texture = NULL;
+        return;
+    }
+#endif
+
     /* We do whole texture updates, at least for now */
     rect.x = 0;
     rect.y = 0;
@@ -1835,6 +1914,14 @@ static void GLES2_SetTextureScaleMode(SDL_Renderer *renderer, SDL_Texture *textu
     GLES2_TextureData *data = (GLES2_TextureData *)texture->driverdata;
     GLenum glScaleMode = (scaleMode == SDL_ScaleModeNearest) ? GL_NEAREST : GL_LINEAR;
 
+#if SDL_VIDEO_DRIVER_MALI
+    if (data->stream) {
+        MALI_SetStreamFilter(data->stream, glScaleMode);
+        renderdata->drawstate.texture = NULL;
+        return;
+    }
+#endif
+
 #if SDL_HAVE_YUV
     if (data->yuv) {
         renderdata->glActiveTexture(GL_TEXTURE2);
@@ -1900,6 +1987,13 @@ static void GLES2_DestroyTexture(SDL_Renderer *renderer, SDL_Texture *texture)
 
     /* Destroy the texture */
     if (tdata) {
+#if SDL_VIDEO_DRIVER_MALI
+        if (tdata->stream) {
+            /* The stream owns the texture names */
+            MALI_DestroyStream(tdata->stream);
+            tdata->texture = 0;
+        }
+#endif
         data->glDeleteTextures(1, &tdata->texture);
 #if SDL_HAVE_YUV
         if (tdata->texture_v) {
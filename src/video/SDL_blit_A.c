@@ -25,6 +25,24 @@
 #include "SDL_video.h"
 #include "SDL_blit.h"
 
+/* Intrinsics blitters, chosen at runtime */
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#if (defined(__i386__) || defined(__x86_64__)) && (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ >= 5))) && !defined(SDL_DISABLE_IMMINTRIN_H)
+#include <immintrin.h>
+#define HAVE_SSE41_INTRINSICS 1
+#define HAVE_AVX2_INTRINSICS  1
+#define BLIT_TARGET(x)        __attribute__((target(x)))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64)) && !defined(SDL_DISABLE_IMMINTRIN_H)
+#include <immintrin.h>
+#define HAVE_SSE41_INTRINSICS 1
+#define HAVE_AVX2_INTRINSICS  1
+#define BLIT_TARGET(x)
+#endif
+#if defined(__ARM_NEON) && !defined(SDL_DISABLE_ARM_NEON_H)
+#define HAVE_NEON_INTRINSICS 1
+#endif
+#endif
+
 /* Functions to perform alpha blended blitting */
 
 /* N->1 blending with per-surface alpha */
@@ -1417,6 +1435,841 @@ static void BlitNtoNPixelAlpha(SDL_BlitInfo *info)
     }
 }
 
+#if defined(HAVE_SSE41_INTRINSICS) || defined(HAVE_NEON_INTRINSICS)
+/*
+ * The vector blitters below reproduce the arithmetic of the C blitters
+ * above exactly, including their rounding, so the results are the same bit
+ * for bit. They handle the pixels of each row that fill whole vectors and
+ * leave the rest of the row to the C blitter they stand in for.
+ */
+static void BlitAlphaTail(SDL_BlitInfo *info, int n, SDL_BlitFunc blit)
+{
+    SDL_BlitInfo tail = *info;
+    int srcbpp = info->src_fmt->BytesPerPixel;
+    int dstbpp = info->dst_fmt->BytesPerPixel;
+
+    if (n < info->dst_w) {
+        tail.src += n * srcbpp;
+        tail.src_w -= n;
+        tail.src_skip += n * srcbpp;
+        tail.dst += n * dstbpp;
+        tail.dst_w -= n;
+        tail.dst_skip += n * dstbpp;
+        blit(&tail);
+    }
+}
+
+/* The vector N->N blitters work on formats with 8-bit channels */
+static SDL_bool Is8888(const SDL_PixelFormat *fmt)
+{
+    return fmt->BytesPerPixel == 4 &&
+           fmt->Rloss == 0 && fmt->Gloss == 0 && fmt->Bloss == 0 &&
+           (fmt->Amask == 0 || fmt->Aloss == 0);
+}
+
+/* How ALPHA_BLEND_RGBA applies to the bytes of 32-bit pixels */
+typedef struct BlendNtoN
+{
+    Uint8 shuffle[4];  /* source byte for each destination byte */
+    Uint8 alpha_byte;  /* source byte holding the alpha, with pixel alpha */
+    Uint32 alpha_mask; /* destination alpha channel, composited instead of blended */
+    Uint32 rgb_mask;   /* destination bytes kept, the others are cleared */
+    SDL_bool pixel_alpha;
+    SDL_bool keyed;
+    SDL_BlitFunc blit; /* C blitter for the rest of each row */
+} BlendNtoN;
+
+static void GetBlendNtoN(SDL_BlitInfo *info, SDL_bool pixel_alpha, SDL_bool keyed, SDL_BlitFunc blit, BlendNtoN *b)
+{
+    SDL_PixelFormat *srcfmt = info->src_fmt;
+    SDL_PixelFormat *dstfmt = info->dst_fmt;
+    int i;
+
+    b->alpha_byte = srcfmt->Ashift / 8;
+    for (i = 0; i < 4; i++) {
+        Uint32 mask = 0xFFu << (i * 8);
+        if (dstfmt->Rmask == mask) {
+            b->shuffle[i] = srcfmt->Rshift / 8;
+        } else if (dstfmt->Gmask == mask) {
+            b->shuffle[i] = srcfmt->Gshift / 8;
+        } else if (dstfmt->Bmask == mask) {
+            b->shuffle[i] = srcfmt->Bshift / 8;
+        } else {
+            b->shuffle[i] = b->alpha_byte;
+        }
+    }
+    b->alpha_mask = dstfmt->Amask;
+    b->rgb_mask = dstfmt->Rmask | dstfmt->Gmask | dstfmt->Bmask | dstfmt->Amask;
+    b->pixel_alpha = pixel_alpha;
+    b->keyed = keyed;
+    b->blit = blit;
+}
+#endif /* HAVE_SSE41_INTRINSICS || HAVE_NEON_INTRINSICS */
+
+#if defined(HAVE_SSE41_INTRINSICS)
+/* x / 255 for 0 <= x <= 255 * 255 */
+static SDL_INLINE __m128i BLIT_TARGET("sse4.1") Div255SSE41(__m128i x)
+{
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)), 8);
+}
+
+/* ALPHA_BLEND_RGBA on 16-bit channels: d + (s - d) * a / 255 for colors, a + d - a * d / 255 for alpha */
+static SDL_INLINE __m128i BLIT_TARGET("sse4.1") BlendColor16SSE41(__m128i s, __m128i a, __m128i d)
+{
+    __m128i diff = _mm_sub_epi16(s, d);
+    return _mm_add_epi16(d, _mm_sign_epi16(Div255SSE41(_mm_mullo_epi16(_mm_abs_epi16(diff), a)), diff));
+}
+
+static SDL_INLINE __m128i BLIT_TARGET("sse4.1") BlendAlpha16SSE41(__m128i a, __m128i d)
+{
+    return _mm_sub_epi16(_mm_add_epi16(a, d), Div255SSE41(_mm_mullo_epi16(a, d)));
+}
+
+static void BLIT_TARGET("sse4.1") BlitNtoNBlendSSE41(SDL_BlitInfo *info, const BlendNtoN *b)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    int n = width & ~3;
+    Uint8 *src = info->src;
+    int srcskip = width * 4 + info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = width * 4 + info->dst_skip;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i shuffle = _mm_set_epi8(12 + b->shuffle[3], 12 + b->shuffle[2], 12 + b->shuffle[1], 12 + b->shuffle[0],
+                                         8 + b->shuffle[3], 8 + b->shuffle[2], 8 + b->shuffle[1], 8 + b->shuffle[0],
+                                         4 + b->shuffle[3], 4 + b->shuffle[2], 4 + b->shuffle[1], 4 + b->shuffle[0],
+                                         b->shuffle[3], b->shuffle[2], b->shuffle[1], b->shuffle[0]);
+    const __m128i alpha_shuffle = _mm_set_epi8(12 + b->alpha_byte, 12 + b->alpha_byte, 12 + b->alpha_byte, 12 + b->alpha_byte,
+                                               8 + b->alpha_byte, 8 + b->alpha_byte, 8 + b->alpha_byte, 8 + b->alpha_byte,
+                                               4 + b->alpha_byte, 4 + b->alpha_byte, 4 + b->alpha_byte, 4 + b->alpha_byte,
+                                               b->alpha_byte, b->alpha_byte, b->alpha_byte, b->alpha_byte);
+    const __m128i alpha_mask = _mm_set1_epi32((int)b->alpha_mask);
+    const __m128i rgb_mask = _mm_set1_epi32((int)b->rgb_mask);
+    const __m128i ckey = _mm_set1_epi32((int)info->colorkey);
+    __m128i surface_alpha = _mm_set1_epi8((char)info->a);
+    __m128i pixels, s, a, d, colors, alphas, skip;
+    int x;
+
+    while (height--) {
+        for (x = 0; x < n; x += 4) {
+            pixels = _mm_loadu_si128((const __m128i *)(src + x * 4));
+            d = _mm_loadu_si128((const __m128i *)(dst + x * 4));
+            s = _mm_shuffle_epi8(pixels, shuffle);
+            a = b->pixel_alpha ? _mm_shuffle_epi8(pixels, alpha_shuffle) : surface_alpha;
+            colors = _mm_packus_epi16(BlendColor16SSE41(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(d, zero)),
+                                      BlendColor16SSE41(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(d, zero)));
+            alphas = _mm_packus_epi16(BlendAlpha16SSE41(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(d, zero)),
+                                      BlendAlpha16SSE41(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(d, zero)));
+            colors = _mm_and_si128(_mm_blendv_epi8(colors, alphas, alpha_mask), rgb_mask);
+            /* The C blitters leave the pixels with no alpha or matching the colorkey alone */
+            skip = _mm_cmpeq_epi8(a, zero);
+            if (b->keyed) {
+                skip = _mm_or_si128(skip, _mm_cmpeq_epi32(pixels, ckey));
+            }
+            _mm_storeu_si128((__m128i *)(dst + x * 4), _mm_blendv_epi8(colors, d, skip));
+        }
+        src += srcskip;
+        dst += dstskip;
+    }
+    BlitAlphaTail(info, n, b->blit);
+}
+
+static void BlitNtoNPixelAlphaSSE41(SDL_BlitInfo *info)
+{
+    BlendNtoN b;
+
+    GetBlendNtoN(info, SDL_TRUE, SDL_FALSE, BlitNtoNPixelAlpha, &b);
+    BlitNtoNBlendSSE41(info, &b);
+}
+
+static void BlitNtoNSurfaceAlphaSSE41(SDL_BlitInfo *info)
+{
+    BlendNtoN b;
+
+    GetBlendNtoN(info, SDL_FALSE, SDL_FALSE, BlitNtoNSurfaceAlpha, &b);
+    BlitNtoNBlendSSE41(info, &b);
+}
+
+static void BlitNtoNSurfaceAlphaKeySSE41(SDL_BlitInfo *info)
+{
+    BlendNtoN b;
+
+    GetBlendNtoN(info, SDL_FALSE, SDL_TRUE, BlitNtoNSurfaceAlphaKey, &b);
+    BlitNtoNBlendSSE41(info, &b);
+}
+
+/* BlitRGBtoRGBPixelAlpha, or BlitRGBtoBGRPixelAlpha with swap, on 32-bit lanes */
+static void BLIT_TARGET("sse4.1") BlitARGBPixelAlphaSSE41(SDL_BlitInfo *info, SDL_bool swap)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    int n = width & ~3;
+    Uint32 *srcp = (Uint32 *)info->src;
+    int srcskip = width + (info->src_skip >> 2);
+    Uint32 *dstp = (Uint32 *)info->dst;
+    int dstskip = width + (info->dst_skip >> 2);
+    const __m128i rb_mask = _mm_set1_epi32(0x00ff00ff);
+    const __m128i g_mask = _mm_set1_epi32(0x0000ff00);
+    const __m128i a_mask = _mm_set1_epi32((int)0xff000000);
+    const __m128i opaque = _mm_set1_epi32(SDL_ALPHA_OPAQUE);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i s, d, alpha, s1, d1, dalpha;
+    int x;
+
+    while (height--) {
+        for (x = 0; x < n; x += 4) {
+            s = _mm_loadu_si128((const __m128i *)(srcp + x));
+            d = _mm_loadu_si128((const __m128i *)(dstp + x));
+            alpha = _mm_srli_epi32(s, 24);
+            s1 = _mm_and_si128(s, rb_mask);
+            if (swap) {
+                s1 = _mm_or_si128(_mm_srli_epi32(s1, 16), _mm_slli_epi32(s1, 16));
+            }
+            /* the opaque result: the (swapped) source */
+            s = _mm_or_si128(s1, _mm_and_si128(s, _mm_or_si128(g_mask, a_mask)));
+            d1 = _mm_and_si128(d, rb_mask);
+            d1 = _mm_and_si128(_mm_add_epi32(d1, _mm_srli_epi32(_mm_mullo_epi32(_mm_sub_epi32(s1, d1), alpha), 8)), rb_mask);
+            dalpha = _mm_add_epi32(alpha, _mm_srli_epi32(_mm_mullo_epi32(_mm_srli_epi32(d, 24), _mm_xor_si128(alpha, opaque)), 8));
+            s1 = _mm_and_si128(s, g_mask);
+            d = _mm_and_si128(d, g_mask);
+            d = _mm_and_si128(_mm_add_epi32(d, _mm_srli_epi32(_mm_mullo_epi32(_mm_sub_epi32(s1, d), alpha), 8)), g_mask);
+            d = _mm_or_si128(_mm_or_si128(d1, d), _mm_slli_epi32(dalpha, 24));
+            d = _mm_blendv_epi8(d, s, _mm_cmpeq_epi32(alpha, opaque));
+            d = _mm_blendv_epi8(d, _mm_loadu_si128((const __m128i *)(dstp + x)), _mm_cmpeq_epi32(alpha, zero));
+            _mm_storeu_si128((__m128i *)(dstp + x), d);
+        }
+        srcp += srcskip;
+        dstp += dstskip;
+    }
+    BlitAlphaTail(info, n, swap ? BlitRGBtoBGRPixelAlpha : BlitRGBtoRGBPixelAlpha);
+}
+
+static void BlitRGBtoRGBPixelAlphaSSE41(SDL_BlitInfo *info)
+{
+    BlitARGBPixelAlphaSSE41(info, SDL_FALSE);
+}
+
+static void BlitRGBtoBGRPixelAlphaSSE41(SDL_BlitInfo *info)
+{
+    BlitARGBPixelAlphaSSE41(info, SDL_TRUE);
+}
+
+static void BLIT_TARGET("sse4.1") BlitRGBtoRGBSurfaceAlphaSSE41(SDL_BlitInfo *info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    int n = width & ~3;
+    Uint32 *srcp = (Uint32 *)info->src;
+    int srcskip = width + (info->src_skip >> 2);
+    Uint32 *dstp = (Uint32 *)info->dst;
+    int dstskip = width + (info->dst_skip >> 2);
+    const __m128i rb_mask = _mm_set1_epi32(0x00ff00ff);
+    const __m128i g_mask = _mm_set1_epi32(0x0000ff00);
+    const __m128i a_mask = _mm_set1_epi32((int)0xff000000);
+    const __m128i half_mask = _mm_set1_epi32(0x00fefefe);
+    const __m128i low_mask = _mm_set1_epi32(0x00010101);
+    const __m128i alpha = _mm_set1_epi32(info->a);
+    __m128i s, d, s1, d1;
+    int x;
+
+    while (height--) {
+        for (x = 0; x < n; x += 4) {
+            s = _mm_loadu_si128((const __m128i *)(srcp + x));
+            d = _mm_loadu_si128((const __m128i *)(dstp + x));
+            if (info->a == 128) {
+                d1 = _mm_srli_epi32(_mm_add_epi32(_mm_and_si128(s, half_mask), _mm_and_si128(d, half_mask)), 1);
+                d = _mm_add_epi32(d1, _mm_and_si128(_mm_and_si128(s, d), low_mask));
+            } else {
+                s1 = _mm_and_si128(s, rb_mask);
+                d1 = _mm_and_si128(d, rb_mask);
+                d1 = _mm_and_si128(_mm_add_epi32(d1, _mm_srli_epi32(_mm_mullo_epi32(_mm_sub_epi32(s1, d1), alpha), 8)), rb_mask);
+                s = _mm_and_si128(s, g_mask);
+                d = _mm_and_si128(d, g_mask);
+                d = _mm_and_si128(_mm_add_epi32(d, _mm_srli_epi32(_mm_mullo_epi32(_mm_sub_epi32(s, d), alpha), 8)), g_mask);
+                d = _mm_or_si128(d1, d);
+            }
+            _mm_storeu_si128((__m128i *)(dstp + x), _mm_or_si128(d, a_mask));
+        }
+        srcp += srcskip;
+        dstp += dstskip;
+    }
+    BlitAlphaTail(info, n, BlitRGBtoRGBSurfaceAlpha);
+}
+
+/* BlitARGBto565PixelAlpha, or BlitARGBto555PixelAlpha, on 4 pixels in 32-bit lanes */
+static SDL_INLINE __m128i BLIT_TARGET("sse4.1") BlendARGBto16SSE41(__m128i s, __m128i d, SDL_bool rgb565)
+{
+    const __m128i mask = _mm_set1_epi32(rgb565 ? 0x07e0f81f : 0x03e07c1f);
+    const __m128i b_mask = _mm_set1_epi32(0x1f);
+    const __m128i rshift = _mm_cvtsi32_si128(rgb565 ? 8 : 9);
+    const __m128i gshift = _mm_cvtsi32_si128(rgb565 ? 5 : 6);
+    const __m128i r_mask = _mm_set1_epi32(rgb565 ? 0xf800 : 0x7c00);
+    const __m128i g_mask = _mm_set1_epi32(rgb565 ? 0x7e0 : 0x3e0);
+    __m128i alpha = _mm_srli_epi32(s, 27);
+    __m128i opaque, sx, dx;
+
+    opaque = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(_mm_srl_epi32(s, rshift), r_mask),
+                                         _mm_and_si128(_mm_srl_epi32(s, gshift), g_mask)),
+                           _mm_and_si128(_mm_srli_epi32(s, 3), b_mask));
+    if (rgb565) {
+        sx = _mm_slli_epi32(_mm_and_si128(s, _mm_set1_epi32(0xfc00)), 11);
+    } else {
+        sx = _mm_slli_epi32(_mm_and_si128(s, _mm_set1_epi32(0xf800)), 10);
+    }
+    sx = _mm_add_epi32(_mm_add_epi32(sx, _mm_and_si128(_mm_srl_epi32(s, rshift), r_mask)),
+                       _mm_and_si128(_mm_srli_epi32(s, 3), b_mask));
+    dx = _mm_and_si128(_mm_or_si128(d, _mm_slli_epi32(d, 16)), mask);
+    dx = _mm_and_si128(_mm_add_epi32(dx, _mm_srli_epi32(_mm_mullo_epi32(_mm_sub_epi32(sx, dx), alpha), 5)), mask);
+    dx = _mm_and_si128(_mm_or_si128(dx, _mm_srli_epi32(dx, 16)), _mm_set1_epi32(0xffff));
+    dx = _mm_blendv_epi8(dx, opaque, _mm_cmpeq_epi32(alpha, b_mask));
+    return _mm_blendv_epi8(dx, d, _mm_cmpeq_epi32(alpha, _mm_setzero_si128()));
+}
+
+static void BLIT_TARGET("sse4.1") BlitARGBto16PixelAlphaSSE41(SDL_BlitInfo *info, SDL_bool rgb565)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    int n = width & ~7;
+    Uint32 *srcp = (Uint32 *)info->src;
+    int srcskip = width + (info->src_skip >> 2);
+    Uint16 *dstp = (Uint16 *)info->dst;
+    int dstskip = width + (info->dst_skip >> 1);
+    __m128i d;
+    int x;
+
+    while (height--) {
+        for (x = 0; x < n; x += 8) {
+            d = _mm_loadu_si128((const __m128i *)(dstp + x));
+            d = _mm_packus_epi32(BlendARGBto16SSE41(_mm_loadu_si128((const __m128i *)(srcp + x)), _mm_cvtepu16_epi32(d), rgb565),
+                                 BlendARGBto16SSE41(_mm_loadu_si128((const __m128i *)(srcp + x + 4)), _mm_cvtepu16_epi32(_mm_srli_si128(d, 8)), rgb565));
+            _mm_storeu_si128((__m128i *)(dstp + x), d);
+        }
+        srcp += srcskip;
+        dstp += dstskip;
+    }
+    BlitAlphaTail(info, n, rgb565 ? BlitARGBto565PixelAlpha : BlitARGBto555PixelAlpha);
+}
+
+static void BlitARGBto565PixelAlphaSSE41(SDL_BlitInfo *info)
+{
+    BlitARGBto16PixelAlphaSSE41(info, SDL_TRUE);
+}
+
+static void BlitARGBto555PixelAlphaSSE41(SDL_BlitInfo *info)
+{
+    BlitARGBto16PixelAlphaSSE41(info, SDL_FALSE);
+}
+
+/* Blit565to565SurfaceAlpha, or Blit555to555SurfaceAlpha, on 4 pixels in 32-bit lanes */
+static SDL_INLINE __m128i BLIT_TARGET("sse4.1") Blend16to16SSE41(__m128i s, __m128i d, __m128i alpha, __m128i mask)
+{
+    s = _mm_and_si128(_mm_or_si128(s, _mm_slli_epi32(s, 16)), mask);
+    d = _mm_and_si128(_mm_or_si128(d, _mm_slli_epi32(d, 16)), mask);
+    d = _mm_and_si128(_mm_add_epi32(d, _mm_srli_epi32(_mm_mullo_epi32(_mm_sub_epi32(s, d), alpha), 5)), mask);
+    return _mm_and_si128(_mm_or_si128(d, _mm_srli_epi32(d, 16)), _mm_set1_epi32(0xffff));
+}
+
+static void BLIT_TARGET("sse4.1") Blit16to16SurfaceAlphaSSE41(SDL_BlitInfo *info, SDL_bool rgb565)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    int n = width & ~7;
+    Uint16 *srcp = (Uint16 *)info->src;
+    int srcskip = width + (info->src_skip >> 1);
+    Uint16 *dstp = (Uint16 *)info->dst;
+    int dstskip = width + (info->dst_skip >> 1);
+    const __m128i half_mask = _mm_set1_epi16((short)(rgb565 ? 0xf7de : 0xfbde));
+    const __m128i mask = _mm_set1_epi32(rgb565 ? 0x07e0f81f : 0x03e07c1f);
+    const __m128i alpha = _mm_set1_epi32(info->a >> 3); /* downscale alpha to 5 bits */
+    __m128i s, d;
+    int x;
+
+    while (height--) {
+        for (x = 0; x < n; x += 8) {
+            s = _mm_loadu_si128((const __m128i *)(srcp + x));
+            d = _mm_loadu_si128((const __m128i *)(dstp + x));
+            if (info->a == 128) {
+                /* BLEND16_50 */
+                d = _mm_add_epi16(_mm_add_epi16(_mm_srli_epi16(_mm_and_si128(s, half_mask), 1), _mm_srli_epi16(_mm_and_si128(d, half_mask), 1)),
+                                  _mm_andnot_si128(half_mask, _mm_and_si128(s, d)));
+            } else {
+                d = _mm_packus_epi32(Blend16to16SSE41(_mm_cvtepu16_epi32(s), _mm_cvtepu16_epi32(d), alpha, mask),
+                                     Blend16to16SSE41(_mm_cvtepu16_epi32(_mm_srli_si128(s, 8)), _mm_cvtepu16_epi32(_mm_srli_si128(d, 8)), alpha, mask));
+            }
+            _mm_storeu_si128((__m128i *)(dstp + x), d);
+        }
+        srcp += srcskip;
+        dstp += dstskip;
+    }
+    BlitAlphaTail(info, n, rgb565 ? Blit565to565SurfaceAlpha : Blit555to555SurfaceAlpha);
+}
+
+static void Blit565to565SurfaceAlphaSSE41(SDL_BlitInfo *info)
+{
+    Blit16to16SurfaceAlphaSSE41(info, SDL_TRUE);
+}
+
+static void Blit555to555SurfaceAlphaSSE41(SDL_BlitInfo *info)
+{
+    Blit16to16SurfaceAlphaSSE41(info, SDL_FALSE);
+}
+#endif /* HAVE_SSE41_INTRINSICS */
+
+#if defined(HAVE_AVX2_INTRINSICS)
+static SDL_INLINE __m256i BLIT_TARGET("avx2") Div255AVX2(__m256i x)
+{
+    return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(x, _mm256_set1_epi16(1)), _mm256_srli_epi16(x, 8)), 8);
+}
+
+static SDL_INLINE __m256i BLIT_TARGET("avx2") BlendColor16AVX2(__m256i s, __m256i a, __m256i d)
+{
+    __m256i diff = _mm256_sub_epi16(s, d);
+    return _mm256_add_epi16(d, _mm256_sign_epi16(Div255AVX2(_mm256_mullo_epi16(_mm256_abs_epi16(diff), a)), diff));
+}
+
+static SDL_INLINE __m256i BLIT_TARGET("avx2") BlendAlpha16AVX2(__m256i a, __m256i d)
+{
+    return _mm256_sub_epi16(_mm256_add_epi16(a, d), Div255AVX2(_mm256_mullo_epi16(a, d)));
+}
+
+/* As BlitNtoNBlendSSE41, the unpacking and packing stay within each 128-bit lane */
+static void BLIT_TARGET("avx2") BlitNtoNBlendAVX2(SDL_BlitInfo *info, const BlendNtoN *b)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    int n = width & ~7;
+    Uint8 *src = info->src;
+    int srcskip = width * 4 + info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = width * 4 + info->dst_skip;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_set_epi8(12 + b->shuffle[3], 12 + b->shuffle[2], 12 + b->shuffle[1], 12 + b->shuffle[0],
+                                                                     8 + b->shuffle[3], 8 + b->shuffle[2], 8 + b->shuffle[1], 8 + b->shuffle[0],
+                                                                     4 + b->shuffle[3], 4 + b->shuffle[2], 4 + b->shuffle[1], 4 + b->shuffle[0],
+                                                                     b->shuffle[3], b->shuffle[2], b->shuffle[1], b->shuffle[0]));
+    const __m256i alpha_shuffle = _mm256_broadcastsi128_si256(_mm_set_epi8(12 + b->alpha_byte, 12 + b->alpha_byte, 12 + b->alpha_byte, 12 + b->alpha_byte,
+                                                                           8 + b->alpha_byte, 8 + b->alpha_byte, 8 + b->alpha_byte, 8 + b->alpha_byte,
+                                                                           4 + b->alpha_byte, 4 + b->alpha_byte, 4 + b->alpha_byte, 4 + b->alpha_byte,
+                                                                           b->alpha_byte, b->alpha_byte, b->alpha_byte, b->alpha_byte));
+    const __m256i alpha_mask = _mm256_set1_epi32((int)b->alpha_mask);
+    const __m256i rgb_mask = _mm256_set1_epi32((int)b->rgb_mask);
+    const __m256i ckey = _mm256_set1_epi32((int)info->colorkey);
+    __m256i surface_alpha = _mm256_set1_epi8((char)info->a);
+    __m256i pixels, s, a, d, colors, alphas, skip;
+    int x;
+
+    while (height--) {
+        for (x = 0; x < n; x += 8) {
+            pixels = _mm256_loadu_si256((const __m256i *)(src + x * 4));
+            d = _mm256_loadu_si256((const __m256i *)(dst + x * 4));
+            s = _mm256_shuffle_epi8(pixels, shuffle);
+            a = b->pixel_alpha ? _mm256_shuffle_epi8(pixels, alpha_shuffle) : surface_alpha;
+            colors = _mm256_packus_epi16(BlendColor16AVX2(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(d, zero)),
+                                         BlendColor16AVX2(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(d, zero)));
+            alphas = _mm256_packus_epi16(BlendAlpha16AVX2(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(d, zero)),
+                                         BlendAlpha16AVX2(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(d, zero)));
+            colors = _mm256_and_si256(_mm256_blendv_epi8(colors, alphas, alpha_mask), rgb_mask);
+            skip = _mm256_cmpeq_epi8(a, zero);
+            if (b->keyed) {
+                skip = _mm256_or_si256(skip, _mm256_cmpeq_epi32(pixels, ckey));
+            }
+            _mm256_storeu_si256((__m256i *)(dst + x * 4), _mm256_blendv_epi8(colors, d, skip));
+        }
+        src += srcskip;
+        dst += dstskip;
+    }
+    BlitAlphaTail(info, n, b->blit);
+}
+
+static void BlitNtoNPixelAlphaAVX2(SDL_BlitInfo *info)
+{
+    BlendNtoN b;
+
+    GetBlendNtoN(info, SDL_TRUE, SDL_FALSE, BlitNtoNPixelAlpha, &b);
+    BlitNtoNBlendAVX2(info, &b);
+}
+
+static void BlitNtoNSurfaceAlphaAVX2(SDL_BlitInfo *info)
+{
+    BlendNtoN b;
+
+    GetBlendNtoN(info, SDL_FALSE, SDL_FALSE, BlitNtoNSurfaceAlpha, &b);
+    BlitNtoNBlendAVX2(info, &b);
+}
+
+static void BlitNtoNSurfaceAlphaKeyAVX2(SDL_BlitInfo *info)
+{
+    BlendNtoN b;
+
+    GetBlendNtoN(info, SDL_FALSE, SDL_TRUE, BlitNtoNSurfaceAlphaKey, &b);
+    BlitNtoNBlendAVX2(info, &b);
+}
+
+static void BLIT_TARGET("avx2") BlitARGBPixelAlphaAVX2(SDL_BlitInfo *info, SDL_bool swap)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    int n = width & ~7;
+    Uint32 *srcp = (Uint32 *)info->src;
+    int srcskip = width + (info->src_skip >> 2);
+    Uint32 *dstp = (Uint32 *)info->dst;
+    int dstskip = width + (info->dst_skip >> 2);
+    const __m256i rb_mask = _mm256_set1_epi32(0x00ff00ff);
+    const __m256i g_mask = _mm256_set1_epi32(0x0000ff00);
+    const __m256i a_mask = _mm256_set1_epi32((int)0xff000000);
+    const __m256i opaque = _mm256_set1_epi32(SDL_ALPHA_OPAQUE);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i s, d, alpha, s1, d1, dalpha;
+    int x;
+
+    while (height--) {
+        for (x = 0; x < n; x += 8) {
+            s = _mm256_loadu_si256((const __m256i *)(srcp + x));
+            d = _mm256_loadu_si256((const __m256i *)(dstp + x));
+            alpha = _mm256_srli_epi32(s, 24);
+            s1 = _mm256_and_si256(s, rb_mask);
+            if (swap) {
+                s1 = _mm256_or_si256(_mm256_srli_epi32(s1, 16), _mm256_slli_epi32(s1, 16));
+            }
+            s = _mm256_or_si256(s1, _mm256_and_si256(s, _mm256_or_si256(g_mask, a_mask)));
+            d1 = _mm256_and_si256(d, rb_mask);
+            d1 = _mm256_and_si256(_mm256_add_epi32(d1, _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(s1, d1), alpha), 8)), rb_mask);
+            dalpha = _mm256_add_epi32(alpha, _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(d, 24), _mm256_xor_si256(alpha, opaque)), 8));
+            s1 = _mm256_and_si256(s, g_mask);
+            d = _mm256_and_si256(d, g_mask);
+            d = _mm256_and_si256(_mm256_add_epi32(d, _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(s1, d), alpha), 8)), g_mask);
+            d = _mm256_or_si256(_mm256_or_si256(d1, d), _mm256_slli_epi32(dalpha, 24));
+            d = _mm256_blendv_epi8(d, s, _mm256_cmpeq_epi32(alpha, opaque));
+            d = _mm256_blendv_epi8(d, _mm256_loadu_si256((const __m256i *)(dstp + x)), _mm256_cmpeq_epi32(alpha, zero));
+            _mm256_storeu_si256((__m256i *)(dstp + x), d);
+        }
+        srcp += srcskip;
+        dstp += dstskip;
+    }
+    BlitAlphaTail(info, n, swap ? BlitRGBtoBGRPixelAlpha : BlitRGBtoRGBPixelAlpha);
+}
+
+static void BlitRGBtoRGBPixelAlphaAVX2(SDL_BlitInfo *info)
+{
+    BlitARGBPixelAlphaAVX2(info, SDL_FALSE);
+}
+
+static void BlitRGBtoBGRPixelAlphaAVX2(SDL_BlitInfo *info)
+{
+    BlitARGBPixelAlphaAVX2(info, SDL_TRUE);
+}
+#endif /* HAVE_AVX2_INTRINSICS */
+
+#if defined(HAVE_NEON_INTRINSICS)
+/* x / 255 for 0 <= x <= 255 * 255, narrowed to 8 bits */
+static SDL_INLINE uint8x8_t Div255NEON(uint16x8_t x)
+{
+    return vshrn_n_u16(vaddq_u16(vaddq_u16(x, vdupq_n_u16(1)), vshrq_n_u16(x, 8)), 8);
+}
+
+/* ALPHA_BLEND_RGB on a channel plane of 16 pixels */
+static SDL_INLINE uint8x16_t BlendColorNEON(uint8x16_t s, uint8x16_t a, uint8x16_t d)
+{
+    uint8x16_t diff = vabdq_u8(s, d);
+    uint8x16_t q = vcombine_u8(Div255NEON(vmull_u8(vget_low_u8(diff), vget_low_u8(a))),
+                               Div255NEON(vmull_u8(vget_high_u8(diff), vget_high_u8(a))));
+    return vbslq_u8(vcgeq_u8(s, d), vaddq_u8(d, q), vsubq_u8(d, q));
+}
+
+static SDL_INLINE uint8x16_t BlendAlphaNEON(uint8x16_t a, uint8x16_t d)
+{
+    uint8x16_t q = vcombine_u8(Div255NEON(vmull_u8(vget_low_u8(a), vget_low_u8(d))),
+                               Div255NEON(vmull_u8(vget_high_u8(a), vget_high_u8(d))));
+    return vsubq_u8(vaddq_u8(a, d), q);
+}
+
+/* NEON deinterleaves 16 pixels into channel planes, the blend then works plane by plane */
+static void BlitNtoNBlendNEON(SDL_BlitInfo *info, const BlendNtoN *b)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    int n = width & ~15;
+    Uint8 *src = info->src;
+    int srcskip = width * 4 + info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = width * 4 + info->dst_skip;
+    const Uint8 *ckey = (const Uint8 *)&info->colorkey;
+    const Uint8 *alpha_bytes = (const Uint8 *)&b->alpha_mask;
+    const Uint8 *rgb_bytes = (const Uint8 *)&b->rgb_mask;
+    const uint8x16_t zero = vdupq_n_u8(0);
+    uint8x16x4_t pixels, d, result;
+    uint8x16_t a, skip;
+    int x, i;
+
+    while (height--) {
+        for (x = 0; x < n; x += 16) {
+            pixels = vld4q_u8(src + x * 4);
+            d = vld4q_u8(dst + x * 4);
+            a = b->pixel_alpha ? pixels.val[b->alpha_byte] : vdupq_n_u8(info->a);
+            skip = vceqq_u8(a, zero);
+            if (b->keyed) {
+                uint8x16_t key = vceqq_u8(pixels.val[0], vdupq_n_u8(ckey[0]));
+                for (i = 1; i < 4; i++) {
+                    key = vandq_u8(key, vceqq_u8(pixels.val[i], vdupq_n_u8(ckey[i])));
+                }
+                skip = vorrq_u8(skip, key);
+            }
+            for (i = 0; i < 4; i++) {
+                if (alpha_bytes[i]) {
+                    result.val[i] = BlendAlphaNEON(a, d.val[i]);
+                } else if (rgb_bytes[i]) {
+                    result.val[i] = BlendColorNEON(pixels.val[b->shuffle[i]], a, d.val[i]);
+                } else {
+                    result.val[i] = zero;
+                }
+                result.val[i] = vbslq_u8(skip, d.val[i], result.val[i]);
+            }
+            vst4q_u8(dst + x * 4, result);
+        }
+        src += srcskip;
+        dst += dstskip;
+    }
+    BlitAlphaTail(info, n, b->blit);
+}
+
+static void BlitNtoNPixelAlphaNEON(SDL_BlitInfo *info)
+{
+    BlendNtoN b;
+
+    GetBlendNtoN(info, SDL_TRUE, SDL_FALSE, BlitNtoNPixelAlpha, &b);
+    BlitNtoNBlendNEON(info, &b);
+}
+
+static void BlitNtoNSurfaceAlphaNEON(SDL_BlitInfo *info)
+{
+    BlendNtoN b;
+
+    GetBlendNtoN(info, SDL_FALSE, SDL_FALSE, BlitNtoNSurfaceAlpha, &b);
+    BlitNtoNBlendNEON(info, &b);
+}
+
+static void BlitNtoNSurfaceAlphaKeyNEON(SDL_BlitInfo *info)
+{
+    BlendNtoN b;
+
+    GetBlendNtoN(info, SDL_FALSE, SDL_TRUE, BlitNtoNSurfaceAlphaKey, &b);
+    BlitNtoNBlendNEON(info, &b);
+}
+
+static void BlitARGBPixelAlphaNEON(SDL_BlitInfo *info, SDL_bool swap)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    int n = width & ~3;
+    Uint32 *srcp = (Uint32 *)info->src;
+    int srcskip = width + (info->src_skip >> 2);
+    Uint32 *dstp = (Uint32 *)info->dst;
+    int dstskip = width + (info->dst_skip >> 2);
+    const uint32x4_t rb_mask = vdupq_n_u32(0x00ff00ff);
+    const uint32x4_t g_mask = vdupq_n_u32(0x0000ff00);
+    const uint32x4_t ga_mask = vdupq_n_u32(0xff00ff00);
+    const uint32x4_t opaque = vdupq_n_u32(SDL_ALPHA_OPAQUE);
+    uint32x4_t s, d, d0, alpha, s1, d1, dalpha;
+    int x;
+
+    while (height--) {
+        for (x = 0; x < n; x += 4) {
+            s = vld1q_u32(srcp + x);
+            d0 = d = vld1q_u32(dstp + x);
+            alpha = vshrq_n_u32(s, 24);
+            s1 = vandq_u32(s, rb_mask);
+            if (swap) {
+                s1 = vorrq_u32(vshrq_n_u32(s1, 16), vshlq_n_u32(s1, 16));
+            }
+            s = vorrq_u32(s1, vandq_u32(s, ga_mask));
+            d1 = vandq_u32(d, rb_mask);
+            d1 = vandq_u32(vaddq_u32(d1, vshrq_n_u32(vmulq_u32(vsubq_u32(s1, d1), alpha), 8)), rb_mask);
+            dalpha = vaddq_u32(alpha, vshrq_n_u32(vmulq_u32(vshrq_n_u32(d, 24), veorq_u32(alpha, opaque)), 8));
+            s1 = vandq_u32(s, g_mask);
+            d = vandq_u32(d, g_mask);
+            d = vandq_u32(vaddq_u32(d, vshrq_n_u32(vmulq_u32(vsubq_u32(s1, d), alpha), 8)), g_mask);
+            d = vorrq_u32(vorrq_u32(d1, d), vshlq_n_u32(dalpha, 24));
+            d = vbslq_u32(vceqq_u32(alpha, opaque), s, d);
+            d = vbslq_u32(vceqq_u32(alpha, vdupq_n_u32(0)), d0, d);
+            vst1q_u32(dstp + x, d);
+        }
+        srcp += srcskip;
+        dstp += dstskip;
+    }
+    BlitAlphaTail(info, n, swap ? BlitRGBtoBGRPixelAlpha : BlitRGBtoRGBPixelAlpha);
+}
+
+static void BlitRGBtoRGBPixelAlphaNEON(SDL_BlitInfo *info)
+{
+    BlitARGBPixelAlphaNEON(info, SDL_FALSE);
+}
+
+static void BlitRGBtoBGRPixelAlphaNEON(SDL_BlitInfo *info)
+{
+    BlitARGBPixelAlphaNEON(info, SDL_TRUE);
+}
+
+static void BlitRGBtoRGBSurfaceAlphaNEON(SDL_BlitInfo *info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    int n = width & ~3;
+    Uint32 *srcp = (Uint32 *)info->src;
+    int srcskip = width + (info->src_skip >> 2);
+    Uint32 *dstp = (Uint32 *)info->dst;
+    int dstskip = width + (info->dst_skip >> 2);
+    const uint32x4_t rb_mask = vdupq_n_u32(0x00ff00ff);
+    const uint32x4_t g_mask = vdupq_n_u32(0x0000ff00);
+    const uint32x4_t a_mask = vdupq_n_u32(0xff000000);
+    const uint32x4_t half_mask = vdupq_n_u32(0x00fefefe);
+    const uint32x4_t low_mask = vdupq_n_u32(0x00010101);
+    const uint32x4_t alpha = vdupq_n_u32(info->a);
+    uint32x4_t s, d, s1, d1;
+    int x;
+
+    while (height--) {
+        for (x = 0; x < n; x += 4) {
+            s = vld1q_u32(srcp + x);
+            d = vld1q_u32(dstp + x);
+            if (info->a == 128) {
+                d1 = vshrq_n_u32(vaddq_u32(vandq_u32(s, half_mask), vandq_u32(d, half_mask)), 1);
+                d = vaddq_u32(d1, vandq_u32(vandq_u32(s, d), low_mask));
+            } else {
+                s1 = vandq_u32(s, rb_mask);
+                d1 = vandq_u32(d, rb_mask);
+                d1 = vandq_u32(vaddq_u32(d1, vshrq_n_u32(vmulq_u32(vsubq_u32(s1, d1), alpha), 8)), rb_mask);
+                s = vandq_u32(s, g_mask);
+                d = vandq_u32(d, g_mask);
+                d = vandq_u32(vaddq_u32(d, vshrq_n_u32(vmulq_u32(vsubq_u32(s, d), alpha), 8)), g_mask);
+                d = vorrq_u32(d1, d);
+            }
+            vst1q_u32(dstp + x, vorrq_u32(d, a_mask));
+        }
+        srcp += srcskip;
+        dstp += dstskip;
+    }
+    BlitAlphaTail(info, n, BlitRGBtoRGBSurfaceAlpha);
+}
+
+/* BlitARGBto565PixelAlpha, or BlitARGBto555PixelAlpha, on 4 pixels in 32-bit lanes */
+static SDL_INLINE uint16x4_t BlendARGBto16NEON(uint32x4_t s, uint16x4_t d16, SDL_bool rgb565)
+{
+    const uint32x4_t mask = vdupq_n_u32(rgb565 ? 0x07e0f81f : 0x03e07c1f);
+    const uint32x4_t b_mask = vdupq_n_u32(0x1f);
+    const uint32x4_t r_mask = vdupq_n_u32(rgb565 ? 0xf800 : 0x7c00);
+    const uint32x4_t g_mask = vdupq_n_u32(rgb565 ? 0x7e0 : 0x3e0);
+    const int32x4_t rshift = vdupq_n_s32(rgb565 ? -8 : -9);
+    const int32x4_t gshift = vdupq_n_s32(rgb565 ? -5 : -6);
+    uint32x4_t alpha = vshrq_n_u32(s, 27);
+    uint32x4_t d = vmovl_u16(d16);
+    uint32x4_t opaque, sx, dx;
+
+    opaque = vaddq_u32(vaddq_u32(vandq_u32(vshlq_u32(s, rshift), r_mask), vandq_u32(vshlq_u32(s, gshift), g_mask)),
+                       vandq_u32(vshrq_n_u32(s, 3), b_mask));
+    if (rgb565) {
+        sx = vshlq_n_u32(vandq_u32(s, vdupq_n_u32(0xfc00)), 11);
+    } else {
+        sx = vshlq_n_u32(vandq_u32(s, vdupq_n_u32(0xf800)), 10);
+    }
+    sx = vaddq_u32(vaddq_u32(sx, vandq_u32(vshlq_u32(s, rshift), r_mask)), vandq_u32(vshrq_n_u32(s, 3), b_mask));
+    dx = vandq_u32(vorrq_u32(d, vshlq_n_u32(d, 16)), mask);
+    dx = vandq_u32(vaddq_u32(dx, vshrq_n_u32(vmulq_u32(vsubq_u32(sx, dx), alpha), 5)), mask);
+    dx = vorrq_u32(dx, vshrq_n_u32(dx, 16));
+    dx = vbslq_u32(vceqq_u32(alpha, b_mask), opaque, dx);
+    dx = vbslq_u32(vceqq_u32(alpha, vdupq_n_u32(0)), d, dx);
+    return vmovn_u32(dx);
+}
+
+static void BlitARGBto16PixelAlphaNEON(SDL_BlitInfo *info, SDL_bool rgb565)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    int n = width & ~3;
+    Uint32 *srcp = (Uint32 *)info->src;
+    int srcskip = width + (info->src_skip >> 2);
+    Uint16 *dstp = (Uint16 *)info->dst;
+    int dstskip = width + (info->dst_skip >> 1);
+    int x;
+
+    while (height--) {
+        for (x = 0; x < n; x += 4) {
+            vst1_u16(dstp + x, BlendARGBto16NEON(vld1q_u32(srcp + x), vld1_u16(dstp + x), rgb565));
+        }
+        srcp += srcskip;
+        dstp += dstskip;
+    }
+    BlitAlphaTail(info, n, rgb565 ? BlitARGBto565PixelAlpha : BlitARGBto555PixelAlpha);
+}
+
+static void BlitARGBto565PixelAlphaNEON(SDL_BlitInfo *info)
+{
+    BlitARGBto16PixelAlphaNEON(info, SDL_TRUE);
+}
+
+static void BlitARGBto555PixelAlphaNEON(SDL_BlitInfo *info)
+{
+    BlitARGBto16PixelAlphaNEON(info, SDL_FALSE);
+}
+
+static void Blit16to16SurfaceAlphaNEON(SDL_BlitInfo *info, SDL_bool rgb565)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    int n = width & ~7;
+    Uint16 *srcp = (Uint16 *)info->src;
+    int srcskip = width + (info->src_skip >> 1);
+    Uint16 *dstp = (Uint16 *)info->dst;
+    int dstskip = width + (info->dst_skip >> 1);
+    const uint16x8_t half_mask = vdupq_n_u16(rgb565 ? 0xf7de : 0xfbde);
+    const uint32x4_t mask = vdupq_n_u32(rgb565 ? 0x07e0f81f : 0x03e07c1f);
+    const uint32x4_t alpha = vdupq_n_u32(info->a >> 3); /* downscale alpha to 5 bits */
+    uint16x8_t s, d;
+    uint32x4_t s32, d32;
+    uint16x4_t lo, hi;
+    int x;
+
+    while (height--) {
+        for (x = 0; x < n; x += 8) {
+            s = vld1q_u16(srcp + x);
+            d = vld1q_u16(dstp + x);
+            if (info->a == 128) {
+                /* BLEND16_50 */
+                d = vaddq_u16(vaddq_u16(vshrq_n_u16(vandq_u16(s, half_mask), 1), vshrq_n_u16(vandq_u16(d, half_mask), 1)),
+                              vbicq_u16(vandq_u16(s, d), half_mask));
+            } else {
+                s32 = vmovl_u16(vget_low_u16(s));
+                d32 = vmovl_u16(vget_low_u16(d));
+                s32 = vandq_u32(vorrq_u32(s32, vshlq_n_u32(s32, 16)), mask);
+                d32 = vandq_u32(vorrq_u32(d32, vshlq_n_u32(d32, 16)), mask);
+                d32 = vandq_u32(vaddq_u32(d32, vshrq_n_u32(vmulq_u32(vsubq_u32(s32, d32), alpha), 5)), mask);
+                lo = vmovn_u32(vorrq_u32(d32, vshrq_n_u32(d32, 16)));
+                s32 = vmovl_u16(vget_high_u16(s));
+                d32 = vmovl_u16(vget_high_u16(d));
+                s32 = vandq_u32(vorrq_u32(s32, vshlq_n_u32(s32, 16)), mask);
+                d32 = vandq_u32(vorrq_u32(d32, vshlq_n_u32(d32, 16)), mask);
+                d32 = vandq_u32(vaddq_u32(d32, vshrq_n_u32(vmulq_u32(vsubq_u32(s32, d32), alpha), 5)), mask);
+                hi = vmovn_u32(vorrq_u32(d32, vshrq_n_u32(d32, 16)));
+                d = vcombine_u16(lo, hi);
+            }
+            vst1q_u16(dstp + x, d);
+        }
+        srcp += srcskip;
+        dstp += dstskip;
+    }
+    BlitAlphaTail(info, n, rgb565 ? Blit565to565SurfaceAlpha : Blit555to555SurfaceAlpha);
+}
+
+static void Blit565to565SurfaceAlphaNEON(SDL_BlitInfo *info)
+{
+    Blit16to16SurfaceAlphaNEON(info, SDL_TRUE);
+}
+
+static void Blit555to555SurfaceAlphaNEON(SDL_BlitInfo *info)
+{
+    Blit16to16SurfaceAlphaNEON(info, SDL_FALSE);
+}
+#endif /* HAVE_NEON_INTRINSICS */
+
 SDL_BlitFunc SDL_CalculateBlitA(SDL_Surface *surface)
 {
     SDL_PixelFormat *sf = surface->format;
@@ -1451,8 +2304,28 @@ SDL_BlitFunc SDL_CalculateBlitA(SDL_Surface *surface)
 #endif
             if (sf->BytesPerPixel == 4 && sf->Amask == 0xff000000 && sf->Gmask == 0xff00 && ((sf->Rmask == 0xff && df->Rmask == 0x1f) || (sf->Bmask == 0xff && df->Bmask == 0x1f))) {
                 if (df->Gmask == 0x7e0) {
+#if defined(HAVE_SSE41_INTRINSICS)
+                    if (SDL_HasSSE41()) {
+                        return BlitARGBto565PixelAlphaSSE41;
+                    }
+#endif
+#if defined(HAVE_NEON_INTRINSICS)
+                    if (SDL_HasNEON()) {
+                        return BlitARGBto565PixelAlphaNEON;
+                    }
+#endif
                     return BlitARGBto565PixelAlpha;
                 } else if (df->Gmask == 0x3e0) {
+#if defined(HAVE_SSE41_INTRINSICS)
+                    if (SDL_HasSSE41()) {
+                        return BlitARGBto555PixelAlphaSSE41;
+                    }
+#endif
+#if defined(HAVE_NEON_INTRINSICS)
+                    if (SDL_HasNEON()) {
+                        return BlitARGBto555PixelAlphaNEON;
+                    }
+#endif
                     return BlitARGBto555PixelAlpha;
                 }
             }
@@ -1460,6 +2333,18 @@ SDL_BlitFunc SDL_CalculateBlitA(SDL_Surface *surface)
 
         case 4:
             if (sf->Rmask == df->Rmask && sf->Gmask == df->Gmask && sf->Bmask == df->Bmask && sf->BytesPerPixel == 4) {
+                if (sf->Amask == 0xff000000) {
+#if defined(HAVE_AVX2_INTRINSICS)
+                    if (SDL_HasAVX2()) {
+                        return BlitRGBtoRGBPixelAlphaAVX2;
+                    }
+#endif
+#if defined(HAVE_SSE41_INTRINSICS)
+                    if (SDL_HasSSE41()) {
+                        return BlitRGBtoRGBPixelAlphaSSE41;
+                    }
+#endif
+                }
 #if defined(__MMX__) || defined(__3dNOW__)
                 if (sf->Rshift % 8 == 0 && sf->Gshift % 8 == 0 && sf->Bshift % 8 == 0 && sf->Ashift % 8 == 0 && sf->Aloss == 0) {
 #ifdef __3dNOW__
@@ -1484,14 +2369,53 @@ SDL_BlitFunc SDL_CalculateBlitA(SDL_Surface *surface)
                     if (SDL_HasARMSIMD()) {
                         return BlitRGBtoRGBPixelAlphaARMSIMD;
                     }
+#endif
+#if defined(HAVE_NEON_INTRINSICS)
+                    if (SDL_HasNEON()) {
+                        return BlitRGBtoRGBPixelAlphaNEON;
+                    }
 #endif
                     return BlitRGBtoRGBPixelAlpha;
                 }
             } else if (sf->Rmask == df->Bmask && sf->Gmask == df->Gmask && sf->Bmask == df->Rmask && sf->BytesPerPixel == 4) {
                 if (sf->Amask == 0xff000000) {
+#if defined(HAVE_AVX2_INTRINSICS)
+                    if (SDL_HasAVX2()) {
+                        return BlitRGBtoBGRPixelAlphaAVX2;
+                    }
+#endif
+#if defined(HAVE_SSE41_INTRINSICS)
+                    if (SDL_HasSSE41()) {
+                        return BlitRGBtoBGRPixelAlphaSSE41;
+                    }
+#endif
+#if defined(HAVE_NEON_INTRINSICS)
+                    if (SDL_HasNEON()) {
+                        return BlitRGBtoBGRPixelAlphaNEON;
+                    }
+#endif
                     return BlitRGBtoBGRPixelAlpha;
                 }
             }
+#if defined(HAVE_SSE41_INTRINSICS) || defined(HAVE_NEON_INTRINSICS)
+            if (sf->Amask && Is8888(sf) && Is8888(df)) {
+#if defined(HAVE_AVX2_INTRINSICS)
+                if (SDL_HasAVX2()) {
+                    return BlitNtoNPixelAlphaAVX2;
+                }
+#endif
+#if defined(HAVE_SSE41_INTRINSICS)
+                if (SDL_HasSSE41()) {
+                    return BlitNtoNPixelAlphaSSE41;
+                }
+#endif
+#if defined(HAVE_NEON_INTRINSICS)
+                if (SDL_HasNEON()) {
+                    return BlitNtoNPixelAlphaNEON;
+                }
+#endif
+            }
+#endif
             return BlitNtoNPixelAlpha;
 
         case 3:
@@ -1515,6 +2439,16 @@ SDL_BlitFunc SDL_CalculateBlitA(SDL_Surface *surface)
             case 2:
                 if (surface->map->identity) {
                     if (df->Gmask == 0x7e0) {
+#if defined(HAVE_SSE41_INTRINSICS)
+                        if (SDL_HasSSE41()) {
+                            return Blit565to565SurfaceAlphaSSE41;
+                        }
+#endif
+#if defined(HAVE_NEON_INTRINSICS)
+                        if (SDL_HasNEON()) {
+                            return Blit565to565SurfaceAlphaNEON;
+                        }
+#endif
 #ifdef __MMX__
                         if (SDL_HasMMX()) {
                             return Blit565to565SurfaceAlphaMMX;
@@ -1524,6 +2458,16 @@ SDL_BlitFunc SDL_CalculateBlitA(SDL_Surface *surface)
                             return Blit565to565SurfaceAlpha;
                         }
                     } else if (df->Gmask == 0x3e0) {
+#if defined(HAVE_SSE41_INTRINSICS)
+                        if (SDL_HasSSE41()) {
+                            return Blit555to555SurfaceAlphaSSE41;
+                        }
+#endif
+#if defined(HAVE_NEON_INTRINSICS)
+                        if (SDL_HasNEON()) {
+                            return Blit555to555SurfaceAlphaNEON;
+                        }
+#endif
 #ifdef __MMX__
                         if (SDL_HasMMX()) {
                             return Blit555to555SurfaceAlphaMMX;
@@ -1538,6 +2482,18 @@ SDL_BlitFunc SDL_CalculateBlitA(SDL_Surface *surface)
 
             case 4:
                 if (sf->Rmask == df->Rmask && sf->Gmask == df->Gmask && sf->Bmask == df->Bmask && sf->BytesPerPixel == 4) {
+                    if ((sf->Rmask | sf->Gmask | sf->Bmask) == 0xffffff) {
+#if defined(HAVE_SSE41_INTRINSICS)
+                        if (SDL_HasSSE41()) {
+                            return BlitRGBtoRGBSurfaceAlphaSSE41;
+                        }
+#endif
+#if defined(HAVE_NEON_INTRINSICS)
+                        if (SDL_HasNEON()) {
+                            return BlitRGBtoRGBSurfaceAlphaNEON;
+                        }
+#endif
+                    }
 #ifdef __MMX__
                     if (sf->Rshift % 8 == 0 && sf->Gshift % 8 == 0 && sf->Bshift % 8 == 0 && SDL_HasMMX()) {
                         return BlitRGBtoRGBSurfaceAlphaMMX;
@@ -1547,6 +2503,25 @@ SDL_BlitFunc SDL_CalculateBlitA(SDL_Surface *surface)
                         return BlitRGBtoRGBSurfaceAlpha;
                     }
                 }
+#if defined(HAVE_SSE41_INTRINSICS) || defined(HAVE_NEON_INTRINSICS)
+                if (Is8888(sf) && Is8888(df)) {
+#if defined(HAVE_AVX2_INTRINSICS)
+                    if (SDL_HasAVX2()) {
+                        return BlitNtoNSurfaceAlphaAVX2;
+                    }
+#endif
+#if defined(HAVE_SSE41_INTRINSICS)
+                    if (SDL_HasSSE41()) {
+                        return BlitNtoNSurfaceAlphaSSE41;
+                    }
+#endif
+#if defined(HAVE_NEON_INTRINSICS)
+                    if (SDL_HasNEON()) {
+                        return BlitNtoNSurfaceAlphaNEON;
+                    }
+#endif
+                }
+#endif
                 return BlitNtoNSurfaceAlpha;
 
             case 3:
@@ -1567,6 +2542,25 @@ SDL_BlitFunc SDL_CalculateBlitA(SDL_Surface *surface)
                     return BlitNtoNSurfaceAlphaKey;
                 }
             } else {
+#if defined(HAVE_SSE41_INTRINSICS) || defined(HAVE_NEON_INTRINSICS)
+                if (Is8888(sf) && Is8888(df)) {
+#if defined(HAVE_AVX2_INTRINSICS)
+                    if (SDL_HasAVX2()) {
+                        return BlitNtoNSurfaceAlphaKeyAVX2;
+                    }
+#endif
+#if defined(HAVE_SSE41_INTRINSICS)
+                    if (SDL_HasSSE41()) {
+                        return BlitNtoNSurfaceAlphaKeySSE41;
+                    }
+#endif
+#if defined(HAVE_NEON_INTRINSICS)
+                    if (SDL_HasNEON()) {
+                        return BlitNtoNSurfaceAlphaKeyNEON;
+                    }
+#endif
+                }
+#endif
                 return BlitNtoNSurfaceAlphaKey;
             }
         }
@@ -37,6 +37,24 @@
 #define HAVE_FAST_WRITE_INT8 0
 #endif
 
+/* SIMD blitters for formats with 8-bit channels, chosen at runtime */
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#if (defined(__i386__) || defined(__x86_64__)) && (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ >= 5))) && !defined(SDL_DISABLE_IMMINTRIN_H)
+#include <immintrin.h>
+#define HAVE_SSE41_INTRINSICS 1
+#define HAVE_AVX2_INTRINSICS  1
+#define BLIT_TARGET(x)        __attribute__((target(x)))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64)) && !defined(SDL_DISABLE_IMMINTRIN_H)
+#include <immintrin.h>
+#define HAVE_SSE41_INTRINSICS 1
+#define HAVE_AVX2_INTRINSICS  1
+#define BLIT_TARGET(x)
+#endif
+#if defined(__ARM_NEON) && !defined(SDL_DISABLE_ARM_NEON_H)
+#define HAVE_NEON_INTRINSICS 1
+#endif
+#endif
+
 /* Functions to blit from N-bit surfaces to other surfaces */
 
 enum blit_features
@@ -45,7 +63,10 @@ enum blit_features
     BLIT_FEATURE_HAS_MMX = 1,
     BLIT_FEATURE_HAS_ALTIVEC = 2,
     BLIT_FEATURE_ALTIVEC_DONT_USE_PREFETCH = 4,
-    BLIT_FEATURE_HAS_ARM_SIMD = 8
+    BLIT_FEATURE_HAS_ARM_SIMD = 8,
+    BLIT_FEATURE_HAS_NEON = 16,
+    BLIT_FEATURE_HAS_SSE41 = 32,
+    BLIT_FEATURE_HAS_AVX2 = 64
 };
 
 #if SDL_ALTIVEC_BLITTERS
@@ -908,7 +929,9 @@ static enum blit_features GetBlitFeatures(void)
 #endif
 #else
 /* Feature 1 is has-MMX */
-#define GetBlitFeatures() ((SDL_HasMMX() ? BLIT_FEATURE_HAS_MMX : 0) | (SDL_HasARMSIMD() ? BLIT_FEATURE_HAS_ARM_SIMD : 0))
+#define GetBlitFeatures() ((SDL_HasMMX() ? BLIT_FEATURE_HAS_MMX : 0) | (SDL_HasARMSIMD() ? BLIT_FEATURE_HAS_ARM_SIMD : 0) | \
+                           (SDL_HasNEON() ? BLIT_FEATURE_HAS_NEON : 0) | (SDL_HasSSE41() ? BLIT_FEATURE_HAS_SSE41 : 0) |  \
+                           (SDL_HasAVX2() ? BLIT_FEATURE_HAS_AVX2 : 0))
 #endif
 
 #if SDL_ARM_SIMD_BLITTERS
@@ -2964,6 +2987,551 @@ static void BlitNtoNKeyCopyAlpha(SDL_BlitInfo *info)
     }
 }
 
+#if defined(HAVE_SSE41_INTRINSICS) || defined(HAVE_NEON_INTRINSICS)
+/*
+ * The SIMD blitters handle conversions between formats with 8-bit channels
+ * as byte shuffles: byte i of a destination pixel is byte shuffle[i] of the
+ * source pixel, and 32-bit results are then ANDed with and_mask and ORed with
+ * or_mask to drop or set the alpha channel. With a colorkey, destination
+ * pixels are kept where the source matches it.
+ *
+ * The vector loops leave the pixels at the end of a row that don't fill a
+ * whole vector to BlitShuffleRow, so the results match the C blitters above
+ * bit for bit.
+ */
+typedef struct BlitShuffle
+{
+    int srcbpp, dstbpp;
+    Uint8 shuffle[4];
+    Uint32 and_mask, or_mask;
+    SDL_bool keyed;
+    Uint32 rgbmask, ckey;
+} BlitShuffle;
+
+/* Returns how many pixels of the row it converted, starting from the first one. */
+typedef int (*BlitShuffleRowFunc)(const Uint8 *src, Uint8 *dst, int width, const BlitShuffle *s);
+
+/* Sets up the shuffle doing what BlitNtoN, BlitNtoNCopyAlpha, BlitNtoNKey or BlitNtoNKeyCopyAlpha would */
+static void GetBlitShuffle(SDL_BlitInfo *info, SDL_bool keyed, BlitShuffle *s)
+{
+    SDL_PixelFormat *srcfmt = info->src_fmt;
+    SDL_PixelFormat *dstfmt = info->dst_fmt;
+    SDL_bool copy_alpha = (srcfmt->Amask && dstfmt->Amask);
+    int alpha_channel, p0, p1, p2, p3;
+
+    s->srcbpp = srcfmt->BytesPerPixel;
+    s->dstbpp = dstfmt->BytesPerPixel;
+    s->and_mask = 0xFFFFFFFF;
+    s->or_mask = 0;
+    s->keyed = keyed;
+    s->rgbmask = ~srcfmt->Amask;
+    s->ckey = info->colorkey & s->rgbmask;
+
+    if (keyed && (copy_alpha ? srcfmt->format == dstfmt->format :
+                               (srcfmt->Rmask == dstfmt->Rmask && srcfmt->Gmask == dstfmt->Gmask && srcfmt->Bmask == dstfmt->Bmask))) {
+        /* The colorkey blitters keep the pixels as they are then, apart from the alpha channel */
+        s->shuffle[0] = 0;
+        s->shuffle[1] = 1;
+        s->shuffle[2] = 2;
+        s->shuffle[3] = 3;
+        if (copy_alpha) {
+        } else if (dstfmt->Amask) {
+            s->or_mask = ((Uint32)info->a) << dstfmt->Ashift;
+        } else {
+            s->and_mask = srcfmt->Rmask | srcfmt->Gmask | srcfmt->Bmask;
+        }
+        return;
+    }
+
+    get_permutation(srcfmt, dstfmt, &p0, &p1, &p2, &p3, &alpha_channel);
+    s->shuffle[0] = (Uint8)p0;
+    s->shuffle[1] = (Uint8)p1;
+    s->shuffle[2] = (Uint8)p2;
+    s->shuffle[3] = (Uint8)p3;
+    if (!copy_alpha && s->dstbpp == 4) {
+        ((Uint8 *)&s->and_mask)[alpha_channel] = 0;
+        ((Uint8 *)&s->or_mask)[alpha_channel] = dstfmt->Amask ? info->a : 0;
+    }
+}
+
+static void BlitShuffleRow(const Uint8 *src, Uint8 *dst, int width, const BlitShuffle *s)
+{
+    Uint32 pixel;
+
+    while (width--) {
+        if (!s->keyed || (*(const Uint32 *)src & s->rgbmask) != s->ckey) {
+            if (s->dstbpp == 4) {
+                ((Uint8 *)&pixel)[0] = src[s->shuffle[0]];
+                ((Uint8 *)&pixel)[1] = src[s->shuffle[1]];
+                ((Uint8 *)&pixel)[2] = src[s->shuffle[2]];
+                ((Uint8 *)&pixel)[3] = src[s->shuffle[3]];
+                *(Uint32 *)dst = (pixel & s->and_mask) | s->or_mask;
+            } else {
+                dst[0] = src[s->shuffle[0]];
+                dst[1] = src[s->shuffle[1]];
+                dst[2] = src[s->shuffle[2]];
+            }
+        }
+        src += s->srcbpp;
+        dst += s->dstbpp;
+    }
+}
+
+static void BlitShuffleRows(SDL_BlitInfo *info, const BlitShuffle *s, BlitShuffleRowFunc row)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    Uint8 *dst = info->dst;
+    int n;
+
+    while (height--) {
+        n = row(src, dst, width, s);
+        BlitShuffleRow(src + n * s->srcbpp, dst + n * s->dstbpp, width - n, s);
+        src += width * s->srcbpp + info->src_skip;
+        dst += width * s->dstbpp + info->dst_skip;
+    }
+}
+#endif /* HAVE_SSE41_INTRINSICS || HAVE_NEON_INTRINSICS */
+
+#if defined(HAVE_SSE41_INTRINSICS)
+/* The byte indices of a shuffle spread over as many pixels as fit in 16 bytes, 0x80 zeroes a byte */
+static void GetShuffleIndices(const BlitShuffle *s, Uint8 indices[16])
+{
+    int pixels = 16 / SDL_max(s->srcbpp, s->dstbpp);
+    int i, j;
+
+    SDL_memset(indices, 0x80, 16);
+    for (i = 0; i < pixels; i++) {
+        for (j = 0; j < s->dstbpp; j++) {
+            indices[i * s->dstbpp + j] = (Uint8)(i * s->srcbpp + s->shuffle[j]);
+        }
+    }
+}
+static int BLIT_TARGET("sse4.1") BlitShuffleRow4to4SSE41(const Uint8 *src, Uint8 *dst, int width, const BlitShuffle *s)
+{
+    Uint8 indices[16];
+    __m128i shuffle, and_mask, or_mask, rgbmask, ckey, pixels, result;
+    int n = 0;
+
+    GetShuffleIndices(s, indices);
+    shuffle = _mm_loadu_si128((const __m128i *)indices);
+    and_mask = _mm_set1_epi32((int)s->and_mask);
+    or_mask = _mm_set1_epi32((int)s->or_mask);
+
+    if (s->keyed) {
+        rgbmask = _mm_set1_epi32((int)s->rgbmask);
+        ckey = _mm_set1_epi32((int)s->ckey);
+        for (; n + 4 <= width; n += 4) {
+            pixels = _mm_loadu_si128((const __m128i *)(src + n * 4));
+            result = _mm_or_si128(_mm_and_si128(_mm_shuffle_epi8(pixels, shuffle), and_mask), or_mask);
+            result = _mm_blendv_epi8(result, _mm_loadu_si128((const __m128i *)(dst + n * 4)),
+                                     _mm_cmpeq_epi32(_mm_and_si128(pixels, rgbmask), ckey));
+            _mm_storeu_si128((__m128i *)(dst + n * 4), result);
+        }
+    } else {
+        for (; n + 4 <= width; n += 4) {
+            pixels = _mm_loadu_si128((const __m128i *)(src + n * 4));
+            result = _mm_or_si128(_mm_and_si128(_mm_shuffle_epi8(pixels, shuffle), and_mask), or_mask);
+            _mm_storeu_si128((__m128i *)(dst + n * 4), result);
+        }
+    }
+    return n;
+}
+
+static int BLIT_TARGET("sse4.1") BlitShuffleRow4to3SSE41(const Uint8 *src, Uint8 *dst, int width, const BlitShuffle *s)
+{
+    Uint8 indices[16];
+    __m128i shuffle, result;
+    int n = 0;
+
+    GetShuffleIndices(s, indices);
+    shuffle = _mm_loadu_si128((const __m128i *)indices);
+
+    /* 4 pixels make 12 bytes, stored as 8 and 4 so nothing past them is touched */
+    for (; n + 4 <= width; n += 4) {
+        result = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + n * 4)), shuffle);
+        _mm_storel_epi64((__m128i *)(dst + n * 3), result);
+        *(Uint32 *)(dst + n * 3 + 8) = (Uint32)_mm_cvtsi128_si32(_mm_srli_si128(result, 8));
+    }
+    return n;
+}
+
+static int BLIT_TARGET("sse4.1") BlitShuffleRow3to4SSE41(const Uint8 *src, Uint8 *dst, int width, const BlitShuffle *s)
+{
+    Uint8 indices[16];
+    __m128i shuffle, and_mask, or_mask, result;
+    int n = 0;
+
+    GetShuffleIndices(s, indices);
+    shuffle = _mm_loadu_si128((const __m128i *)indices);
+    and_mask = _mm_set1_epi32((int)s->and_mask);
+    or_mask = _mm_set1_epi32((int)s->or_mask);
+
+    /* 4 pixels are 12 bytes, loading 16 must stay within the row */
+    for (; n + 6 <= width; n += 4) {
+        result = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + n * 3)), shuffle);
+        result = _mm_or_si128(_mm_and_si128(result, and_mask), or_mask);
+        _mm_storeu_si128((__m128i *)(dst + n * 4), result);
+    }
+    return n;
+}
+
+static void BlitNtoNSSE41(SDL_BlitInfo *info)
+{
+    BlitShuffle s;
+
+    GetBlitShuffle(info, SDL_FALSE, &s);
+    if (s.srcbpp == 3) {
+        BlitShuffleRows(info, &s, BlitShuffleRow3to4SSE41);
+    } else if (s.dstbpp == 3) {
+        BlitShuffleRows(info, &s, BlitShuffleRow4to3SSE41);
+    } else {
+        BlitShuffleRows(info, &s, BlitShuffleRow4to4SSE41);
+    }
+}
+
+static void BlitNtoNKeySSE41(SDL_BlitInfo *info)
+{
+    BlitShuffle s;
+
+    GetBlitShuffle(info, SDL_TRUE, &s);
+    BlitShuffleRows(info, &s, BlitShuffleRow4to4SSE41);
+}
+
+/* RGB888 to RGB565 or RGB555, packing the 32-bit results with unsigned saturation */
+static void BLIT_TARGET("sse4.1") Blit_RGB888_RGB16SSE41(SDL_BlitInfo *info, int rshift, Uint32 gmask, int gshift)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint32 *src = (Uint32 *)info->src;
+    int srcskip = info->src_skip / 4;
+    Uint16 *dst = (Uint16 *)info->dst;
+    int dstskip = info->dst_skip / 2;
+    const __m128i rmask_v = _mm_set1_epi32(0x00F80000);
+    const __m128i gmask_v = _mm_set1_epi32((int)gmask);
+    const __m128i bmask_v = _mm_set1_epi32(0x000000F8);
+    const __m128i rshift_v = _mm_cvtsi32_si128(rshift);
+    const __m128i gshift_v = _mm_cvtsi32_si128(gshift);
+    __m128i lo, hi;
+    int n;
+
+    while (height--) {
+        for (n = 0; n + 8 <= width; n += 8) {
+            lo = _mm_loadu_si128((const __m128i *)(src + n));
+            hi = _mm_loadu_si128((const __m128i *)(src + n + 4));
+            lo = _mm_or_si128(_mm_or_si128(_mm_srl_epi32(_mm_and_si128(lo, rmask_v), rshift_v),
+                                           _mm_srl_epi32(_mm_and_si128(lo, gmask_v), gshift_v)),
+                              _mm_srli_epi32(_mm_and_si128(lo, bmask_v), 3));
+            hi = _mm_or_si128(_mm_or_si128(_mm_srl_epi32(_mm_and_si128(hi, rmask_v), rshift_v),
+                                           _mm_srl_epi32(_mm_and_si128(hi, gmask_v), gshift_v)),
+                              _mm_srli_epi32(_mm_and_si128(hi, bmask_v), 3));
+            _mm_storeu_si128((__m128i *)(dst + n), _mm_packus_epi32(lo, hi));
+        }
+        for (; n < width; n++) {
+            dst[n] = (Uint16)(((src[n] & 0x00F80000) >> rshift) | ((src[n] & gmask) >> gshift) | ((src[n] & 0x000000F8) >> 3));
+        }
+        src += width + srcskip;
+        dst += width + dstskip;
+    }
+}
+
+static void Blit_RGB888_RGB565SSE41(SDL_BlitInfo *info)
+{
+    Blit_RGB888_RGB16SSE41(info, 8, 0x0000FC00, 5);
+}
+
+static void Blit_RGB888_RGB555SSE41(SDL_BlitInfo *info)
+{
+    Blit_RGB888_RGB16SSE41(info, 9, 0x0000F800, 6);
+}
+
+static void BLIT_TARGET("sse4.1") Blit2to2KeySSE41(SDL_BlitInfo *info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint16 *srcp = (Uint16 *)info->src;
+    int srcskip = info->src_skip / 2;
+    Uint16 *dstp = (Uint16 *)info->dst;
+    int dstskip = info->dst_skip / 2;
+    Uint16 rgbmask = (Uint16)~info->src_fmt->Amask;
+    Uint16 ckey = (Uint16)info->colorkey & rgbmask;
+    const __m128i rgbmask_v = _mm_set1_epi16((short)rgbmask);
+    const __m128i ckey_v = _mm_set1_epi16((short)ckey);
+    __m128i pixels;
+    int n;
+
+    while (height--) {
+        for (n = 0; n + 8 <= width; n += 8) {
+            pixels = _mm_loadu_si128((const __m128i *)(srcp + n));
+            pixels = _mm_blendv_epi8(pixels, _mm_loadu_si128((const __m128i *)(dstp + n)),
+                                     _mm_cmpeq_epi16(_mm_and_si128(pixels, rgbmask_v), ckey_v));
+            _mm_storeu_si128((__m128i *)(dstp + n), pixels);
+        }
+        for (; n < width; n++) {
+            if ((srcp[n] & rgbmask) != ckey) {
+                dstp[n] = srcp[n];
+            }
+        }
+        srcp += width + srcskip;
+        dstp += width + dstskip;
+    }
+}
+#endif /* HAVE_SSE41_INTRINSICS */
+
+#if defined(HAVE_AVX2_INTRINSICS)
+static int BLIT_TARGET("avx2") BlitShuffleRow4to4AVX2(const Uint8 *src, Uint8 *dst, int width, const BlitShuffle *s)
+{
+    Uint8 indices[16];
+    __m256i shuffle, and_mask, or_mask, rgbmask, ckey, pixels, result;
+    int n = 0;
+
+    /* Pixels never straddle the two 128-bit lanes, so both shuffle the same way */
+    GetShuffleIndices(s, indices);
+    shuffle = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)indices));
+    and_mask = _mm256_set1_epi32((int)s->and_mask);
+    or_mask = _mm256_set1_epi32((int)s->or_mask);
+
+    if (s->keyed) {
+        rgbmask = _mm256_set1_epi32((int)s->rgbmask);
+        ckey = _mm256_set1_epi32((int)s->ckey);
+        for (; n + 8 <= width; n += 8) {
+            pixels = _mm256_loadu_si256((const __m256i *)(src + n * 4));
+            result = _mm256_or_si256(_mm256_and_si256(_mm256_shuffle_epi8(pixels, shuffle), and_mask), or_mask);
+            result = _mm256_blendv_epi8(result, _mm256_loadu_si256((const __m256i *)(dst + n * 4)),
+                                        _mm256_cmpeq_epi32(_mm256_and_si256(pixels, rgbmask), ckey));
+            _mm256_storeu_si256((__m256i *)(dst + n * 4), result);
+        }
+    } else {
+        for (; n + 8 <= width; n += 8) {
+            pixels = _mm256_loadu_si256((const __m256i *)(src + n * 4));
+            result = _mm256_or_si256(_mm256_and_si256(_mm256_shuffle_epi8(pixels, shuffle), and_mask), or_mask);
+            _mm256_storeu_si256((__m256i *)(dst + n * 4), result);
+        }
+    }
+    return n;
+}
+
+static void BlitNtoNAVX2(SDL_BlitInfo *info)
+{
+    BlitShuffle s;
+
+    GetBlitShuffle(info, SDL_FALSE, &s);
+    BlitShuffleRows(info, &s, BlitShuffleRow4to4AVX2);
+}
+
+static void BlitNtoNKeyAVX2(SDL_BlitInfo *info)
+{
+    BlitShuffle s;
+
+    GetBlitShuffle(info, SDL_TRUE, &s);
+    BlitShuffleRows(info, &s, BlitShuffleRow4to4AVX2);
+}
+
+static void BLIT_TARGET("avx2") Blit2to2KeyAVX2(SDL_BlitInfo *info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint16 *srcp = (Uint16 *)info->src;
+    int srcskip = info->src_skip / 2;
+    Uint16 *dstp = (Uint16 *)info->dst;
+    int dstskip = info->dst_skip / 2;
+    Uint16 rgbmask = (Uint16)~info->src_fmt->Amask;
+    Uint16 ckey = (Uint16)info->colorkey & rgbmask;
+    const __m256i rgbmask_v = _mm256_set1_epi16((short)rgbmask);
+    const __m256i ckey_v = _mm256_set1_epi16((short)ckey);
+    __m256i pixels;
+    int n;
+
+    while (height--) {
+        for (n = 0; n + 16 <= width; n += 16) {
+            pixels = _mm256_loadu_si256((const __m256i *)(srcp + n));
+            pixels = _mm256_blendv_epi8(pixels, _mm256_loadu_si256((const __m256i *)(dstp + n)),
+                                        _mm256_cmpeq_epi16(_mm256_and_si256(pixels, rgbmask_v), ckey_v));
+            _mm256_storeu_si256((__m256i *)(dstp + n), pixels);
+        }
+        for (; n < width; n++) {
+            if ((srcp[n] & rgbmask) != ckey) {
+                dstp[n] = srcp[n];
+            }
+        }
+        srcp += width + srcskip;
+        dstp += width + dstskip;
+    }
+}
+#endif /* HAVE_AVX2_INTRINSICS */
+
+#if defined(HAVE_NEON_INTRINSICS)
+/* NEON loads and stores deinterleave 16 pixels into channel planes, which are shuffled as a whole */
+static int BlitShuffleRow4to4NEON(const Uint8 *src, Uint8 *dst, int width, const BlitShuffle *s)
+{
+    const Uint8 *and_bytes = (const Uint8 *)&s->and_mask;
+    const Uint8 *or_bytes = (const Uint8 *)&s->or_mask;
+    const Uint8 *rgb_bytes = (const Uint8 *)&s->rgbmask;
+    const Uint8 *key_bytes = (const Uint8 *)&s->ckey;
+    uint8x16x4_t pixels, result, prev;
+    uint8x16_t keep;
+    int n, i;
+
+    for (n = 0; n + 16 <= width; n += 16) {
+        pixels = vld4q_u8(src + n * 4);
+        for (i = 0; i < 4; i++) {
+            result.val[i] = vorrq_u8(vandq_u8(pixels.val[s->shuffle[i]], vdupq_n_u8(and_bytes[i])), vdupq_n_u8(or_bytes[i]));
+        }
+        if (s->keyed) {
+            keep = vceqq_u8(vandq_u8(pixels.val[0], vdupq_n_u8(rgb_bytes[0])), vdupq_n_u8(key_bytes[0]));
+            for (i = 1; i < 4; i++) {
+                keep = vandq_u8(keep, vceqq_u8(vandq_u8(pixels.val[i], vdupq_n_u8(rgb_bytes[i])), vdupq_n_u8(key_bytes[i])));
+            }
+            prev = vld4q_u8(dst + n * 4);
+            for (i = 0; i < 4; i++) {
+                result.val[i] = vbslq_u8(keep, prev.val[i], result.val[i]);
+            }
+        }
+        vst4q_u8(dst + n * 4, result);
+    }
+    return n;
+}
+
+static int BlitShuffleRow4to3NEON(const Uint8 *src, Uint8 *dst, int width, const BlitShuffle *s)
+{
+    uint8x16x4_t pixels;
+    uint8x16x3_t result;
+    int n;
+
+    for (n = 0; n + 16 <= width; n += 16) {
+        pixels = vld4q_u8(src + n * 4);
+        result.val[0] = pixels.val[s->shuffle[0]];
+        result.val[1] = pixels.val[s->shuffle[1]];
+        result.val[2] = pixels.val[s->shuffle[2]];
+        vst3q_u8(dst + n * 3, result);
+    }
+    return n;
+}
+
+static int BlitShuffleRow3to4NEON(const Uint8 *src, Uint8 *dst, int width, const BlitShuffle *s)
+{
+    const Uint8 *and_bytes = (const Uint8 *)&s->and_mask;
+    const Uint8 *or_bytes = (const Uint8 *)&s->or_mask;
+    uint8x16x3_t pixels;
+    uint8x16x4_t result;
+    int n, i;
+
+    for (n = 0; n + 16 <= width; n += 16) {
+        pixels = vld3q_u8(src + n * 3);
+        for (i = 0; i < 4; i++) {
+            result.val[i] = vorrq_u8(vandq_u8(pixels.val[s->shuffle[i]], vdupq_n_u8(and_bytes[i])), vdupq_n_u8(or_bytes[i]));
+        }
+        vst4q_u8(dst + n * 4, result);
+    }
+    return n;
+}
+
+static void BlitNtoNNEON(SDL_BlitInfo *info)
+{
+    BlitShuffle s;
+
+    GetBlitShuffle(info, SDL_FALSE, &s);
+    if (s.srcbpp == 3) {
+        BlitShuffleRows(info, &s, BlitShuffleRow3to4NEON);
+    } else if (s.dstbpp == 3) {
+        BlitShuffleRows(info, &s, BlitShuffleRow4to3NEON);
+    } else {
+        BlitShuffleRows(info, &s, BlitShuffleRow4to4NEON);
+    }
+}
+
+static void BlitNtoNKeyNEON(SDL_BlitInfo *info)
+{
+    BlitShuffle s;
+
+    GetBlitShuffle(info, SDL_TRUE, &s);
+    BlitShuffleRows(info, &s, BlitShuffleRow4to4NEON);
+}
+
+/* RGB888 to RGB565 or RGB555, shifting the top bits of each channel in with vsri */
+static void Blit_RGB888_RGB16NEON(SDL_BlitInfo *info, SDL_bool rgb565)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    Uint8 *dst = info->dst;
+    uint8x16x4_t pixels;
+    uint16x8_t lo, hi;
+    Uint32 pixel;
+    int n;
+
+    while (height--) {
+        for (n = 0; n + 16 <= width; n += 16) {
+            /* Planes 0, 1 and 2 are blue, green and red */
+            pixels = vld4q_u8(src + n * 4);
+            if (rgb565) {
+                lo = vsriq_n_u16(vshll_n_u8(vget_low_u8(pixels.val[2]), 8), vshll_n_u8(vget_low_u8(pixels.val[1]), 8), 5);
+                hi = vsriq_n_u16(vshll_n_u8(vget_high_u8(pixels.val[2]), 8), vshll_n_u8(vget_high_u8(pixels.val[1]), 8), 5);
+            } else {
+                lo = vsriq_n_u16(vshrq_n_u16(vshll_n_u8(vget_low_u8(pixels.val[2]), 8), 1), vshll_n_u8(vget_low_u8(pixels.val[1]), 8), 6);
+                hi = vsriq_n_u16(vshrq_n_u16(vshll_n_u8(vget_high_u8(pixels.val[2]), 8), 1), vshll_n_u8(vget_high_u8(pixels.val[1]), 8), 6);
+            }
+            lo = vsriq_n_u16(lo, vshll_n_u8(vget_low_u8(pixels.val[0]), 8), 11);
+            hi = vsriq_n_u16(hi, vshll_n_u8(vget_high_u8(pixels.val[0]), 8), 11);
+            vst1q_u16((uint16_t *)(dst + n * 2), lo);
+            vst1q_u16((uint16_t *)(dst + n * 2 + 16), hi);
+        }
+        for (; n < width; n++) {
+            pixel = ((const Uint32 *)src)[n];
+            if (rgb565) {
+                ((Uint16 *)dst)[n] = (Uint16)(((pixel & 0x00F80000) >> 8) | ((pixel & 0x0000FC00) >> 5) | ((pixel & 0x000000F8) >> 3));
+            } else {
+                ((Uint16 *)dst)[n] = (Uint16)(((pixel & 0x00F80000) >> 9) | ((pixel & 0x0000F800) >> 6) | ((pixel & 0x000000F8) >> 3));
+            }
+        }
+        src += width * 4 + info->src_skip;
+        dst += width * 2 + info->dst_skip;
+    }
+}
+
+static void Blit_RGB888_RGB565NEON(SDL_BlitInfo *info)
+{
+    Blit_RGB888_RGB16NEON(info, SDL_TRUE);
+}
+
+static void Blit_RGB888_RGB555NEON(SDL_BlitInfo *info)
+{
+    Blit_RGB888_RGB16NEON(info, SDL_FALSE);
+}
+
+static void Blit2to2KeyNEON(SDL_BlitInfo *info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint16 *srcp = (Uint16 *)info->src;
+    int srcskip = info->src_skip / 2;
+    Uint16 *dstp = (Uint16 *)info->dst;
+    int dstskip = info->dst_skip / 2;
+    Uint16 rgbmask = (Uint16)~info->src_fmt->Amask;
+    Uint16 ckey = (Uint16)info->colorkey & rgbmask;
+    const uint16x8_t rgbmask_v = vdupq_n_u16(rgbmask);
+    const uint16x8_t ckey_v = vdupq_n_u16(ckey);
+    uint16x8_t pixels;
+    int n;
+
+    while (height--) {
+        for (n = 0; n + 8 <= width; n += 8) {
+            pixels = vld1q_u16(srcp + n);
+            pixels = vbslq_u16(vceqq_u16(vandq_u16(pixels, rgbmask_v), ckey_v), vld1q_u16(dstp + n), pixels);
+            vst1q_u16(dstp + n, pixels);
+        }
+        for (; n < width; n++) {
+            if ((srcp[n] & rgbmask) != ckey) {
+                dstp[n] = srcp[n];
+            }
+        }
+        srcp += width + srcskip;
+        dstp += width + dstskip;
+    }
+}
+#endif /* HAVE_NEON_INTRINSICS */
+
 /* Special optimized blit for ARGB 2-10-10-10 --> RGBA */
 static void Blit2101010toN(SDL_BlitInfo *info)
 {
@@ -3252,6 +3820,14 @@ static const struct blit_table normal_blit_2[] = {
 };
 
 static const struct blit_table normal_blit_3[] = {
+#if defined(HAVE_NEON_INTRINSICS)
+    { 0x00000000, 0x00000000, 0x00000000, 4, 0x00000000, 0x00000000, 0x00000000,
+      BLIT_FEATURE_HAS_NEON, BlitNtoNNEON, NO_ALPHA | SET_ALPHA },
+#endif
+#if defined(HAVE_SSE41_INTRINSICS)
+    { 0x00000000, 0x00000000, 0x00000000, 4, 0x00000000, 0x00000000, 0x00000000,
+      BLIT_FEATURE_HAS_SSE41, BlitNtoNSSE41, NO_ALPHA | SET_ALPHA },
+#endif
     /* 3->4 with same rgb triplet */
     { 0x000000FF, 0x0000FF00, 0x00FF0000, 4, 0x000000FF, 0x0000FF00, 0x00FF0000,
       0, Blit_3or4_to_3or4__same_rgb,
@@ -3302,6 +3878,30 @@ static const struct blit_table normal_blit_4[] = {
 #if SDL_ARM_SIMD_BLITTERS
     { 0x000000FF, 0x0000FF00, 0x00FF0000, 4, 0x00FF0000, 0x0000FF00, 0x000000FF,
       BLIT_FEATURE_HAS_ARM_SIMD, Blit_BGR888_RGB888ARMSIMD, NO_ALPHA | COPY_ALPHA },
+#endif
+#if defined(HAVE_NEON_INTRINSICS)
+    { 0x00000000, 0x00000000, 0x00000000, 4, 0x00000000, 0x00000000, 0x00000000,
+      BLIT_FEATURE_HAS_NEON, BlitNtoNNEON, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x00000000, 0x00000000, 0x00000000, 3, 0x00000000, 0x00000000, 0x00000000,
+      BLIT_FEATURE_HAS_NEON, BlitNtoNNEON, NO_ALPHA },
+    { 0x00FF0000, 0x0000FF00, 0x000000FF, 2, 0x0000F800, 0x000007E0, 0x0000001F,
+      BLIT_FEATURE_HAS_NEON, Blit_RGB888_RGB565NEON, NO_ALPHA },
+    { 0x00FF0000, 0x0000FF00, 0x000000FF, 2, 0x00007C00, 0x000003E0, 0x0000001F,
+      BLIT_FEATURE_HAS_NEON, Blit_RGB888_RGB555NEON, NO_ALPHA },
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+    { 0x00000000, 0x00000000, 0x00000000, 4, 0x00000000, 0x00000000, 0x00000000,
+      BLIT_FEATURE_HAS_AVX2, BlitNtoNAVX2, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+#endif
+#if defined(HAVE_SSE41_INTRINSICS)
+    { 0x00000000, 0x00000000, 0x00000000, 4, 0x00000000, 0x00000000, 0x00000000,
+      BLIT_FEATURE_HAS_SSE41, BlitNtoNSSE41, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x00000000, 0x00000000, 0x00000000, 3, 0x00000000, 0x00000000, 0x00000000,
+      BLIT_FEATURE_HAS_SSE41, BlitNtoNSSE41, NO_ALPHA },
+    { 0x00FF0000, 0x0000FF00, 0x000000FF, 2, 0x0000F800, 0x000007E0, 0x0000001F,
+      BLIT_FEATURE_HAS_SSE41, Blit_RGB888_RGB565SSE41, NO_ALPHA },
+    { 0x00FF0000, 0x0000FF00, 0x000000FF, 2, 0x00007C00, 0x000003E0, 0x0000001F,
+      BLIT_FEATURE_HAS_SSE41, Blit_RGB888_RGB555SSE41, NO_ALPHA },
 #endif
     /* 4->3 with same rgb triplet */
     { 0x000000FF, 0x0000FF00, 0x00FF0000, 3, 0x000000FF, 0x0000FF00, 0x00FF0000,
@@ -3342,6 +3942,33 @@ static const struct blit_table *const normal_blit[] = {
 /* Mask matches table, or table entry is zero */
 #define MASKOK(x, y) (((x) == (y)) || ((y) == 0x00000000))
 
+/* C blitters for formats BlitNtoN isn't the best fit for, or NULL */
+static SDL_BlitFunc GetSpecialBlitN(const SDL_PixelFormat *srcfmt, const SDL_PixelFormat *dstfmt, Uint32 a_need)
+{
+    if (srcfmt->format == SDL_PIXELFORMAT_ARGB2101010) {
+        return Blit2101010toN;
+    } else if (dstfmt->format == SDL_PIXELFORMAT_ARGB2101010) {
+        return BlitNto2101010;
+    } else if (srcfmt->BytesPerPixel == 4 &&
+               dstfmt->BytesPerPixel == 4 &&
+               srcfmt->Rmask == dstfmt->Rmask &&
+               srcfmt->Gmask == dstfmt->Gmask &&
+               srcfmt->Bmask == dstfmt->Bmask) {
+        if (a_need == COPY_ALPHA) {
+            if (srcfmt->Amask == dstfmt->Amask) {
+                /* Fastpath C fallback: 32bit RGBA<->RGBA blit with matching RGBA */
+                return SDL_BlitCopy;
+            } else {
+                return BlitNtoNCopyAlpha;
+            }
+        } else {
+            /* Fastpath C fallback: 32bit RGB<->RGBA blit with matching RGB */
+            return Blit4to4MaskAlpha;
+        }
+    }
+    return NULL;
+}
+
 SDL_BlitFunc SDL_CalculateBlitN(SDL_Surface *surface)
 {
     SDL_PixelFormat *srcfmt;
@@ -3382,6 +4009,16 @@ SDL_BlitFunc SDL_CalculateBlitN(SDL_Surface *surface)
             if (dstfmt->Amask) {
                 a_need = srcfmt->Amask ? COPY_ALPHA : SET_ALPHA;
             }
+
+#if !SDL_ALTIVEC_BLITTERS
+            /* The SIMD blitters in the tables would match these too, but don't handle them.
+               AltiVec builds keep picking their 32->32 blitters for them first, as they always did. */
+            blitfun = GetSpecialBlitN(srcfmt, dstfmt, a_need);
+            if (blitfun) {
+                return blitfun;
+            }
+#endif
+
             table = normal_blit[srcfmt->BytesPerPixel - 1];
             for (which = 0; table[which].dstbpp; ++which) {
                 if (MASKOK(srcfmt->Rmask, table[which].srcR) &&
@@ -3400,26 +4037,9 @@ SDL_BlitFunc SDL_CalculateBlitN(SDL_Surface *surface)
             blitfun = table[which].blitfunc;
 
             if (blitfun == BlitNtoN) { /* default C fallback catch-all. Slow! */
-                if (srcfmt->format == SDL_PIXELFORMAT_ARGB2101010) {
-                    blitfun = Blit2101010toN;
-                } else if (dstfmt->format == SDL_PIXELFORMAT_ARGB2101010) {
-                    blitfun = BlitNto2101010;
-                } else if (srcfmt->BytesPerPixel == 4 &&
-                           dstfmt->BytesPerPixel == 4 &&
-                           srcfmt->Rmask == dstfmt->Rmask &&
-                           srcfmt->Gmask == dstfmt->Gmask &&
-                           srcfmt->Bmask == dstfmt->Bmask) {
-                    if (a_need == COPY_ALPHA) {
-                        if (srcfmt->Amask == dstfmt->Amask) {
-                            /* Fastpath C fallback: 32bit RGBA<->RGBA blit with matching RGBA */
-                            blitfun = SDL_BlitCopy;
-                        } else {
-                            blitfun = BlitNtoNCopyAlpha;
-                        }
-                    } else {
-                        /* Fastpath C fallback: 32bit RGB<->RGBA blit with matching RGB */
-                        blitfun = Blit4to4MaskAlpha;
-                    }
+                SDL_BlitFunc special = GetSpecialBlitN(srcfmt, dstfmt, a_need);
+                if (special) {
+                    blitfun = special;
                 } else if (a_need == COPY_ALPHA) {
                     blitfun = BlitNtoNCopyAlpha;
                 }
@@ -3433,10 +4053,46 @@ SDL_BlitFunc SDL_CalculateBlitN(SDL_Surface *surface)
            If a particular case turns out to be useful we'll add it. */
 
         if (srcfmt->BytesPerPixel == 2 && surface->map->identity != 0) {
+#if defined(HAVE_AVX2_INTRINSICS)
+            if (SDL_HasAVX2()) {
+                return Blit2to2KeyAVX2;
+            }
+#endif
+#if defined(HAVE_SSE41_INTRINSICS)
+            if (SDL_HasSSE41()) {
+                return Blit2to2KeySSE41;
+            }
+#endif
+#if defined(HAVE_NEON_INTRINSICS)
+            if (SDL_HasNEON()) {
+                return Blit2to2KeyNEON;
+            }
+#endif
             return Blit2to2Key;
         } else if (dstfmt->BytesPerPixel == 1) {
             return BlitNto1Key;
         } else {
+#if defined(HAVE_AVX2_INTRINSICS) || defined(HAVE_SSE41_INTRINSICS) || defined(HAVE_NEON_INTRINSICS)
+            if (srcfmt->BytesPerPixel == 4 && dstfmt->BytesPerPixel == 4 &&
+                srcfmt->format != SDL_PIXELFORMAT_ARGB2101010 &&
+                dstfmt->format != SDL_PIXELFORMAT_ARGB2101010) {
+#if defined(HAVE_AVX2_INTRINSICS)
+                if (SDL_HasAVX2()) {
+                    return BlitNtoNKeyAVX2;
+                }
+#endif
+#if defined(HAVE_SSE41_INTRINSICS)
+                if (SDL_HasSSE41()) {
+                    return BlitNtoNKeySSE41;
+                }
+#endif
+#if defined(HAVE_NEON_INTRINSICS)
+                if (SDL_HasNEON()) {
+                    return BlitNtoNKeyNEON;
+                }
+#endif
+            }
+#endif
 #if SDL_ALTIVEC_BLITTERS
             if ((srcfmt->BytesPerPixel == 4) && (dstfmt->BytesPerPixel == 4) && SDL_HasAltiVec()) {
                 return Blit32to32KeyAltivec;
@@ -2633,6 +2633,11 @@ static SDL_Surface *SDL_CreateWindowFramebuffer(SDL_Window *window)
             attempt_texture_framebuffer = SDL_FALSE;
         }
 #endif
+#if SDL_VIDEO_DRIVER_MALI /* The mali driver hands out the buffers it presents from directly. */
+        else if ((_this->CreateWindowFramebuffer != NULL) && (SDL_strcmp(_this->name, "mali") == 0)) {
+            attempt_texture_framebuffer = SDL_FALSE;
+        }
+#endif
 #if defined(__EMSCRIPTEN__)
         else {
             attempt_texture_framebuffer = SDL_FALSE;
@@ -4827,4 +4832,42 @@ void SDL_Metal_GetDrawableSize(SDL_Window *window, int *w, int *h)
     }
 }
 
+#if defined(__LINUX__) && !SDL_VIDEO_DRIVER_MALI
+/* Platform functions of the mali-fbdev driver, when it isn't built in */
+int SDL_MaliGetFrameStats(SDL_Window *window, SDL_MaliFrameStats *stats)
+{
+    return SDL_Unsupported();
+}
+
+int SDL_MaliSetSwapDamage(SDL_Window *window, const SDL_Rect *rects, int numrects)
+{
+    return SDL_Unsupported();
+}
+
+int SDL_MaliGetVblank(SDL_Window *window, Uint64 *timestamp, Uint64 *interval)
+{
+    return SDL_Unsupported();
+}
+
+int SDL_MaliSetDynamicResolution(SDL_Window *window, int min_w, int min_h)
+{
+    return SDL_Unsupported();
+}
+
+int SDL_MaliStartCapture(SDL_Window *window, const char *path)
+{
+    return SDL_Unsupported();
+}
+
+int SDL_MaliStopCapture(SDL_Window *window)
+{
+    return SDL_Unsupported();
+}
+
+int SDL_MaliSetOverlay(SDL_Window *window, int layer, SDL_Surface *surface, const SDL_Rect *dst)
+{
+    return SDL_Unsupported();
+}
+#endif
+
 /* vi: set ts=4 sw=4 expandtab: */
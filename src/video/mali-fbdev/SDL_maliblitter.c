@@ -8,9 +8,26 @@
 
 #include "SDL_malivideo.h"
 #include "SDL_maliblitter.h"
+#include "SDL_malisched.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <linux/sync_file.h>
 
 #define MAX_CONFIGS 128
 
+#ifndef GL_PROGRAM_BINARY_LENGTH_OES
+#define GL_PROGRAM_BINARY_LENGTH_OES 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS_OES
+#define GL_NUM_PROGRAM_BINARY_FORMATS_OES 0x87FE
+#endif
+
 /* used to simplify code */
 typedef struct mat4 {
     GLfloat v[16];
@@ -81,7 +98,7 @@ int MALI_Blitter_CreateContext(_THIS, MALI_Blitter *blitter, NativeWindowType nw
     /* max 14 values plus terminator. */
     EGLint screen_attribs[] = {
         EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
-        EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+        EGL_SURFACE_TYPE, MALI_WINDOW_SURFACE_BIT,
         EGL_RED_SIZE, 8,
         EGL_GREEN_SIZE, 8,
         EGL_BLUE_SIZE, 8,
@@ -91,9 +108,11 @@ int MALI_Blitter_CreateContext(_THIS, MALI_Blitter *blitter, NativeWindowType nw
         EGL_NONE
     };
 
+#if !SDL_VIDEO_DRIVER_MALI_SIM
     EGLint window_attribs[] = {
         EGL_NONE,
     };
+#endif
 
     EGLint context_attribs[] = {
         EGL_CONTEXT_CLIENT_VERSION, 2,
@@ -128,7 +147,11 @@ int MALI_Blitter_CreateContext(_THIS, MALI_Blitter *blitter, NativeWindowType nw
         return 0;
     }
 
+#if SDL_VIDEO_DRIVER_MALI_SIM
+    blitter->egl_surface = MALI_Sim_CreateWindowSurface(blitter, configs[0], nw);
+#else
     blitter->egl_surface = blitter->eglCreateWindowSurface(blitter->egl_display, configs[0], nw, window_attribs);
+#endif
     if (blitter->egl_surface == EGL_NO_SURFACE) {
         SDL_EGL_SetError("mali-fbdev: failed to create window surface", "eglCreateContext");
         return 0;
@@ -137,12 +160,32 @@ int MALI_Blitter_CreateContext(_THIS, MALI_Blitter *blitter, NativeWindowType nw
     return 1;
 }
 
+/* Maps a rect in display space (top-left origin) to screen space (bottom-left origin), following the rotation. */
 static void
-get_aspect_correct_coords(int viewport[2], int plane[2], int rotation, GLfloat vert[4][4], GLfloat scale[2])
+map_display_rect(int viewport[2], int rotation, const SDL_Rect *rect, SDL_Rect *result)
+{
+    switch (rotation) {
+    case 1:  *result = (SDL_Rect){ rect->y, rect->x, rect->h, rect->w }; break;
+    case 2:  *result = (SDL_Rect){ viewport[0] - rect->x - rect->w, rect->y, rect->w, rect->h }; break;
+    case 3:  *result = (SDL_Rect){ viewport[0] - rect->y - rect->h, viewport[1] - rect->x - rect->w, rect->h, rect->w }; break;
+    default: *result = (SDL_Rect){ rect->x, viewport[1] - rect->y - rect->h, rect->w, rect->h }; break;
+    }
+}
+
+void
+MALI_Blitter_MapDisplayRect(MALI_Blitter *blitter, const SDL_Rect *rect, SDL_Rect *result)
+{
+    map_display_rect((int [2]){blitter->viewport_width, blitter->viewport_height}, blitter->rotation, rect, result);
+}
+
+/* Places the quad for the scale mode, returns whether the frame is scaled by a whole factor. */
+static SDL_bool
+get_aspect_correct_coords(int viewport[2], int plane[2], int rotation, int mode, const SDL_Rect *custom, GLfloat vert[4][4], GLfloat scale[2])
 {
     /* FIXME: Sorry for the spaghetti! */
     float aspect_plane, aspect_viewport, ratio_x, ratio_y;
-    int shift_x, shift_y, temp;
+    int shift_x, shift_y, temp, factor;
+    SDL_Rect rect;
 
     // when sideways, invert plane coords
     if (rotation & 1) {
@@ -151,11 +194,32 @@ get_aspect_correct_coords(int viewport[2], int plane[2], int rotation, GLfloat v
         plane[1] = temp;
     }
 
-    // Choose which edge to touch
+    // Largest whole multiple that fits, frames larger than the screen are fit instead
+    factor = SDL_min(viewport[0] / plane[0], viewport[1] / plane[1]);
+    if (mode == MALI_SCALE_INTEGER && factor < 1)
+        mode = MALI_SCALE_FIT;
+
+    // Choose which edge to touch, fill touches the other one and crops
     aspect_plane = (float)plane[0] / plane[1];
     aspect_viewport = (float)viewport[0] / viewport[1];
 
-    if (aspect_viewport > aspect_plane) {
+    if (mode == MALI_SCALE_INTEGER) {
+        ratio_x = plane[0] * factor;
+        ratio_y = plane[1] * factor;
+        shift_x = (viewport[0] - plane[0] * factor) / 2;
+        shift_y = (viewport[1] - plane[1] * factor) / 2;
+    } else if (mode == MALI_SCALE_STRETCH) {
+        ratio_x = viewport[0];
+        ratio_y = viewport[1];
+        shift_x = 0;
+        shift_y = 0;
+    } else if (mode == MALI_SCALE_CUSTOM) {
+        map_display_rect(viewport, rotation, custom, &rect);
+        ratio_x = rect.w;
+        ratio_y = rect.h;
+        shift_x = rect.x;
+        shift_y = rect.y;
+    } else if ((aspect_viewport > aspect_plane) == (mode == MALI_SCALE_FIT)) {
         // viewport wider than plane
         ratio_x = plane[0] * (float)((float)viewport[1] / plane[1]);
         ratio_y = viewport[1];
@@ -184,6 +248,8 @@ get_aspect_correct_coords(int viewport[2], int plane[2], int rotation, GLfloat v
     // Get scale, for filtering.
     scale[0] = ratio_x / plane[0];
     scale[1] = ratio_y / plane[1];
+
+    return (mode == MALI_SCALE_INTEGER);
 }
 
 static
@@ -198,16 +264,19 @@ void mat_ortho(float left, float right, float bottom, float top, float Result[4]
     Result[3][3] = 1.0f;
 }
 
-static void
+void
 MALI_Blitter_GetTexture(_THIS, MALI_Blitter *blitter, MALI_EGL_Surface *surf)
 {
-    /* Define attributes of the EGLImage that will import our dmabuf file descriptor */
+#if SDL_VIDEO_DRIVER_MALI_SIM
+    MALI_Sim_InitTexture(blitter, surf);
+#else
+    /* Define attributes of the EGLImage that will import our dmabuf file descriptor, alpha is never shown */
     EGLint attribute_list[] = {
-        EGL_WIDTH, blitter->plane_width,
-        EGL_HEIGHT, blitter->plane_height,
-        EGL_LINUX_DRM_FOURCC_EXT, DRM_FORMAT_XRGB8888,
+        EGL_WIDTH, surf->pixmap.width,
+        EGL_HEIGHT, surf->pixmap.height,
+        EGL_LINUX_DRM_FOURCC_EXT, (surf->pixmap.drm_fourcc.format == DRM_FORMAT_ARGB8888) ? DRM_FORMAT_XRGB8888 : surf->pixmap.drm_fourcc.format,
         EGL_DMA_BUF_PLANE0_OFFSET_EXT, 0,
-        EGL_DMA_BUF_PLANE0_PITCH_EXT, blitter->plane_pitch,
+        EGL_DMA_BUF_PLANE0_PITCH_EXT, surf->pixmap.planes[0].stride,
         EGL_DMA_BUF_PLANE0_FD_EXT, surf->dmabuf_fd,
         EGL_NONE
     };
@@ -229,42 +298,437 @@ MALI_Blitter_GetTexture(_THIS, MALI_Blitter *blitter, MALI_EGL_Surface *surf)
     blitter->glBindTexture(GL_TEXTURE_2D, surf->texture);
     blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    if (blitter->scaler > 0) {
-        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    } else {
-        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    }
 
     /* And populate our texture with the EGLImage */
     blitter->glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, surf->egl_image);
+#endif
 }
 
-int
-MALI_InitBlitterContext(_THIS, MALI_Blitter *blitter, SDL_WindowData *windata, NativeWindowType nw, int rotation)
+/*
+ * SDL_MALI_SHADER_CACHE: Existing directory where the linked blitter programs
+ * are cached across runs, or "0" to disable the cache. Defaults to the SDL
+ * pref path. Entries are keyed on the shader sources, which encode the scaler
+ * and rotation, and on the driver's renderer and version strings.
+ */
+static char *
+MALI_Blitter_GetCachePath(MALI_Blitter *blitter, const GLchar *vert, const GLchar *frag)
 {
-    char *use_hq_scaler;
-    GLchar msg[2048] = {}, blit_vert[2048] = {};
-    const GLchar *sources[2] = { blit_vert, blit_frag_standard };
-    float scale[2];
+    const char *hint = SDL_GetHint("SDL_MALI_SHADER_CACHE");
+    const char *renderer, *version;
+    char *dir, *path;
+    size_t len;
+    Uint32 crc;
+
+    if (!blitter->glProgramBinaryOES || (hint && SDL_strcmp(hint, "0") == 0))
+        return NULL;
+
+    renderer = (const char *)blitter->glGetString(GL_RENDERER);
+    version = (const char *)blitter->glGetString(GL_VERSION);
+    crc = SDL_crc32(0, vert, SDL_strlen(vert));
+    crc = SDL_crc32(crc, frag, SDL_strlen(frag));
+    crc = SDL_crc32(crc, renderer, renderer ? SDL_strlen(renderer) : 0);
+    crc = SDL_crc32(crc, version, version ? SDL_strlen(version) : 0);
+
+    dir = (hint && *hint) ? SDL_strdup(hint) : SDL_GetPrefPath("libsdl", "mali-fbdev");
+    if (!dir)
+        return NULL;
+
+    len = SDL_strlen(dir) + 32;
+    path = SDL_malloc(len);
+    if (path)
+        SDL_snprintf(path, len, "%s%sblitter-%08x.bin", dir, (dir[SDL_strlen(dir) - 1] == '/') ? "" : "/", crc);
+
+    SDL_free(dir);
+    return path;
+}
 
-    /*
-     * SDL_HQ_SCALER: Selects one of the available scalers:
-     * - 0: Nearest filtering
-     * - 1: Linear filtering
-     * - 2: Sharp Bilinear Simple
-     * - 3: Quilez
-     */
-    blitter->scaler = 0;
-    if ((use_hq_scaler = SDL_getenv("SDL_HQ_SCALER")) != NULL && *use_hq_scaler != '0') {
-        switch (*use_hq_scaler) {
-            case '0': blitter->scaler = 0; sources[1] = blit_frag_standard; break;
-            case '1': blitter->scaler = 1; sources[1] = blit_frag_standard; break;
-            case '2': blitter->scaler = 2; sources[1] = blit_frag_bilinear_simple; break;
-            case '3': blitter->scaler = 3; sources[1] = blit_frag_quilez; break;
+static GLuint
+MALI_Blitter_LoadProgramBinary(MALI_Blitter *blitter, const char *path)
+{
+    SDL_RWops *rw;
+    Sint64 size;
+    GLenum format;
+    GLint linked = GL_FALSE;
+    GLuint prog = 0;
+    void *data;
+
+    if ((rw = SDL_RWFromFile(path, "rb")) == NULL)
+        return 0;
+
+    size = SDL_RWsize(rw) - sizeof(Uint32);
+    if (size > 0 && (data = SDL_malloc(size)) != NULL) {
+        format = SDL_ReadLE32(rw);
+        if (SDL_RWread(rw, data, size, 1) == 1) {
+            prog = blitter->glCreateProgram();
+            blitter->glProgramBinaryOES(prog, format, data, (GLint)size);
+            blitter->glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+            if (linked && (blitter->glGetAttribLocation(prog, "aVertCoord") != MALI_ATTRIB_VERTCOORD
+                        || blitter->glGetAttribLocation(prog, "aTexCoord") != MALI_ATTRIB_TEXCOORD)) {
+                linked = GL_FALSE;
+            }
+            if (!linked) {
+                /* Stale or corrupted, we'll just compile and overwrite it. */
+                blitter->glDeleteProgram(prog);
+                prog = 0;
+            }
+        }
+        SDL_free(data);
+    }
+
+    SDL_RWclose(rw);
+    return prog;
+}
+
+static void
+MALI_Blitter_SaveProgramBinary(MALI_Blitter *blitter, GLuint prog, const char *path)
+{
+    SDL_RWops *rw;
+    GLint size = 0;
+    GLenum format;
+    char *tmp_path;
+    size_t len;
+    void *data;
+    int written;
+
+    blitter->glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH_OES, &size);
+    if (size <= 0 || (data = SDL_malloc(size)) == NULL)
+        return;
+
+    /* Don't mistake an error left over from earlier calls for ours. */
+    while (blitter->glGetError() != GL_NO_ERROR) {
+        continue;
+    }
+
+    blitter->glGetProgramBinaryOES(prog, size, &size, &format, data);
+    if (blitter->glGetError() != GL_NO_ERROR) {
+        SDL_free(data);
+        return;
+    }
+
+    /* Write next to the cache entry and rename it into place, so a crash or
+     * a full disk never leaves a truncated binary to be loaded next run. */
+    len = SDL_strlen(path) + 32;
+    if ((tmp_path = SDL_malloc(len)) == NULL) {
+        SDL_free(data);
+        return;
+    }
+    SDL_snprintf(tmp_path, len, "%s.%d.tmp", path, (int)getpid());
+
+    if ((rw = SDL_RWFromFile(tmp_path, "wb")) != NULL) {
+        written = SDL_WriteLE32(rw, format) == 1 && SDL_RWwrite(rw, data, size, 1) == 1;
+        if (SDL_RWclose(rw) < 0)
+            written = 0;
+        if (!written || rename(tmp_path, path) < 0) {
+            SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "Couldn't write blitter program to %s\n", path);
+            unlink(tmp_path);
+        }
+    }
+
+    SDL_free(tmp_path);
+    SDL_free(data);
+}
+
+static GLuint
+MALI_Blitter_CompileShader(MALI_Blitter *blitter, GLenum type, const GLchar *source)
+{
+    GLchar msg[2048] = {};
+    GLuint shader = blitter->glCreateShader(type);
+
+    blitter->glShaderSource(shader, 1, &source, NULL);
+    blitter->glCompileShader(shader);
+    blitter->glGetShaderInfoLog(shader, sizeof(msg), NULL, msg);
+    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "Blitter %s Shader Info: %s\n",
+        (type == GL_VERTEX_SHADER) ? "Vertex" : "Fragment", msg);
+
+    return shader;
+}
+
+GLuint
+MALI_Blitter_BuildProgram(MALI_Blitter *blitter, const GLchar *vert_src, const GLchar *frag_src)
+{
+    GLchar msg[2048] = {};
+    GLint linked = GL_FALSE;
+    GLuint prog, vert, frag;
+    char *cache_path = MALI_Blitter_GetCachePath(blitter, vert_src, frag_src);
+
+    if (cache_path && (prog = MALI_Blitter_LoadProgramBinary(blitter, cache_path)) != 0) {
+        SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "Blitter Program loaded from %s\n", cache_path);
+        SDL_free(cache_path);
+        return prog;
+    }
+
+    vert = MALI_Blitter_CompileShader(blitter, GL_VERTEX_SHADER, vert_src);
+    frag = MALI_Blitter_CompileShader(blitter, GL_FRAGMENT_SHADER, frag_src);
+
+    prog = blitter->glCreateProgram();
+    blitter->glAttachShader(prog, vert);
+    blitter->glAttachShader(prog, frag);
+    blitter->glBindAttribLocation(prog, MALI_ATTRIB_VERTCOORD, "aVertCoord");
+    blitter->glBindAttribLocation(prog, MALI_ATTRIB_TEXCOORD, "aTexCoord");
+    blitter->glLinkProgram(prog);
+    blitter->glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+
+    blitter->glGetProgramInfoLog(prog, sizeof(msg), NULL, msg);
+    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "Blitter Program Info: %s\n", msg);
+
+    /* The program keeps what it needs, flag them for deletion. */
+    blitter->glDeleteShader(vert);
+    blitter->glDeleteShader(frag);
+
+    /* Nothing to draw with, and nothing worth caching for the next run */
+    if (!linked) {
+        SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Blitter program failed to link: %s", msg);
+        blitter->glDeleteProgram(prog);
+        SDL_free(cache_path);
+        return 0;
+    }
+
+    if (cache_path) {
+        MALI_Blitter_SaveProgramBinary(blitter, prog, cache_path);
+        SDL_free(cache_path);
+    }
+
+    return prog;
+}
+
+static void
+MALI_Blitter_LoadExtensions(MALI_Blitter *blitter)
+{
+    const char *extensions = (const char *)blitter->glGetString(GL_EXTENSIONS);
+    GLint formats = 0;
+
+    blitter->glGetProgramBinaryOES = NULL;
+    blitter->glProgramBinaryOES = NULL;
+    if (extensions && SDL_strstr(extensions, "GL_OES_get_program_binary")) {
+        blitter->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+        if (formats > 0) {
+            blitter->glGetProgramBinaryOES = blitter->eglGetProcAddress("glGetProgramBinaryOES");
+            blitter->glProgramBinaryOES = blitter->eglGetProcAddress("glProgramBinaryOES");
+        }
+        if (!blitter->glGetProgramBinaryOES || !blitter->glProgramBinaryOES) {
+            blitter->glGetProgramBinaryOES = NULL;
+            blitter->glProgramBinaryOES = NULL;
         }
     }
+}
+
+static void
+MALI_Blitter_LoadEGLExtensions(MALI_Blitter *blitter)
+{
+    const char *extensions = blitter->eglQueryString(blitter->egl_display, EGL_EXTENSIONS);
+
+    blitter->has_buffer_age = SDL_FALSE;
+    blitter->eglSetDamageRegionKHR = NULL;
+    blitter->eglSwapBuffersWithDamage = NULL;
+    if (!extensions)
+        return;
+
+    /* Without a buffer age there's no telling what's stale in the back buffer. */
+    if (SDL_strstr(extensions, "EGL_EXT_buffer_age") || SDL_strstr(extensions, "EGL_KHR_partial_update"))
+        blitter->has_buffer_age = SDL_TRUE;
+    if (SDL_strstr(extensions, "EGL_KHR_partial_update"))
+        blitter->eglSetDamageRegionKHR = blitter->eglGetProcAddress("eglSetDamageRegionKHR");
+    if (SDL_strstr(extensions, "EGL_KHR_swap_buffers_with_damage"))
+        blitter->eglSwapBuffersWithDamage = blitter->eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+    else if (SDL_strstr(extensions, "EGL_EXT_swap_buffers_with_damage"))
+        blitter->eglSwapBuffersWithDamage = blitter->eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+}
+
+static void
+MALI_Blitter_SetScaler(MALI_Blitter *blitter, SDL_WindowData *windata, int scaler)
+{
+    GLint filter;
+    int i;
+
+    /* Nothing beats nearest filtering at whole scale factors, and it costs nothing */
+    blitter->scaler = scaler;
+    if (blitter->integer_scale)
+        scaler = 0;
+
+    /* A scaler that failed to build falls back to nearest filtering */
+    if (blitter->programs[scaler].prog == 0)
+        scaler = 0;
+
+    filter = (scaler > 0) ? GL_LINEAR : GL_NEAREST;
+    blitter->scaler_prog = blitter->programs[scaler].prog;
+    blitter->glUseProgram(blitter->scaler_prog);
+
+    /* The scaler samples the last post-processing pass, if there's any. */
+    if (blitter->num_passes > 0) {
+        blitter->glBindTexture(GL_TEXTURE_2D, blitter->passes[blitter->num_passes - 1].texture);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        return;
+    }
+
+    for (i = MALI_SET_FIRST(blitter->buffer_set); i < MALI_SET_FIRST(blitter->buffer_set) + windata->num_buffers; i++) {
+        blitter->glBindTexture(GL_TEXTURE_2D, windata->surface[i].texture);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    }
+}
+
+/*
+ * SDL_HQ_SCALER: Selects one of the available scalers, can be changed at any
+ * time and takes effect on the next frame:
+ * - 0: Nearest filtering
+ * - 1: Linear filtering
+ * - 2: Sharp Bilinear Simple
+ * - 3: Quilez
+ */
+static void SDLCALL
+MALI_Blitter_ScalerChanged(void *userdata, const char *name, const char *oldValue, const char *newValue)
+{
+    MALI_Blitter *blitter = (MALI_Blitter *)userdata;
+    int scaler = (newValue && *newValue >= '0' && *newValue <= '3') ? (*newValue - '0') : 0;
+
+    SDL_AtomicSet(&blitter->next_scaler, scaler);
+}
+
+/*
+ * SDL_MALI_SCALE_MODE: How frames are placed on the screen, can be changed at
+ * any time and takes effect on the next frame:
+ * - "fit": Largest size that keeps the aspect ratio (default)
+ * - "integer": Largest whole multiple of the frame size, centered, with
+ *   nearest filtering whatever SDL_HQ_SCALER says
+ * - "fill": Smallest size that covers the screen, keeping the aspect ratio
+ * - "stretch": The whole screen
+ * - "x,y,w,h": That rect, in display coordinates
+ */
+static void SDLCALL
+MALI_Blitter_ScaleModeChanged(void *userdata, const char *name, const char *oldValue, const char *newValue)
+{
+    MALI_Blitter *blitter = (MALI_Blitter *)userdata;
+    SDL_Rect rect = { 0, 0, 0, 0 };
+    int mode = MALI_SCALE_FIT;
+
+    if (!newValue || !*newValue || SDL_strcasecmp(newValue, "fit") == 0) {
+        mode = MALI_SCALE_FIT;
+    } else if (SDL_strcasecmp(newValue, "integer") == 0) {
+        mode = MALI_SCALE_INTEGER;
+    } else if (SDL_strcasecmp(newValue, "fill") == 0) {
+        mode = MALI_SCALE_FILL;
+    } else if (SDL_strcasecmp(newValue, "stretch") == 0) {
+        mode = MALI_SCALE_STRETCH;
+    } else if (SDL_sscanf(newValue, "%d,%d,%d,%d", &rect.x, &rect.y, &rect.w, &rect.h) == 4 && rect.w > 0 && rect.h > 0) {
+        mode = MALI_SCALE_CUSTOM;
+    } else {
+        SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Unknown scale mode \"%s\"", newValue);
+    }
+
+    SDL_AtomicLock(&blitter->scale_lock);
+    blitter->scale_mode = mode;
+    blitter->scale_rect = rect;
+    SDL_AtomicUnlock(&blitter->scale_lock);
+    SDL_AtomicSet(&blitter->scale_changed, 1);
+}
+
+/* Places the quad for the current source size and scale mode. */
+static void
+MALI_Blitter_UpdateQuad(MALI_Blitter *blitter, SDL_WindowData *windata)
+{
+    MALI_BlitterProgram *program;
+    SDL_Rect rect;
+    int mode, i;
+
+    SDL_AtomicSet(&blitter->scale_changed, 0);
+    SDL_AtomicLock(&blitter->scale_lock);
+    mode = blitter->scale_mode;
+    rect = blitter->scale_rect;
+    SDL_AtomicUnlock(&blitter->scale_lock);
+
+    blitter->integer_scale = get_aspect_correct_coords(
+        (int [2]){blitter->viewport_width, blitter->viewport_height},
+        (int [2]){blitter->source_width, blitter->source_height},
+        blitter->rotation,
+        mode,
+        &rect,
+        blitter->vert_buffer_data,
+        blitter->scale
+    );
+
+    for (i = 0; i < MALI_SCALER_COUNT; i++) {
+        if (i == 1)
+            continue;
+
+        program = &blitter->programs[i];
+        blitter->glUseProgram(program->prog);
+        blitter->glUniform2f(program->loc_uScale, blitter->scale[0], blitter->scale[1]);
+        blitter->glUniform2f(program->loc_uTexSize, blitter->source_width, blitter->source_height);
+    }
+
+    /* Same layout every time, the buffer was sized when the blitter started */
+    blitter->glBindBuffer(GL_ARRAY_BUFFER, blitter->vbo);
+    blitter->glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(blitter->vert_buffer_data), blitter->vert_buffer_data);
+
+    MALI_Blitter_SetScaler(blitter, windata, SDL_AtomicGet(&blitter->next_scaler));
+
+    /* The borders moved, redraw everything, the cursor moves along with the frame */
+    blitter->damage_frames = 0;
+    SDL_AtomicSet(&blitter->overlay_changed, 1);
+}
+
+/* Imports the buffers of a set, then sizes the chain and the quad after them. */
+static void
+MALI_Blitter_BindSet(_THIS, MALI_Blitter *blitter, SDL_WindowData *windata, int set)
+{
+    MALI_EGL_Surface *surfaces = &windata->surface[MALI_SET_FIRST(set)];
+    int i;
+
+    blitter->buffer_set = set;
+    blitter->plane_width = surfaces[0].pixmap.width;
+    blitter->plane_height = surfaces[0].pixmap.height;
+    blitter->plane_pitch = surfaces[0].pixmap.planes[0].stride;
+
+    for (i = 0; i < windata->num_buffers; i++) {
+        MALI_Blitter_GetTexture(_this, blitter, &surfaces[i]);
+    }
+
+    /* Post-processing passes run first, the scaler then works off their output. */
+    blitter->source_width = blitter->plane_width;
+    blitter->source_height = blitter->plane_height;
+    MALI_Blitter_InitChain(blitter, surfaces, windata->num_buffers, &blitter->source_width, &blitter->source_height);
+
+    /* Also drops the damage history, nothing drawn from another set is worth keeping. */
+    MALI_Blitter_UpdateQuad(blitter, windata);
+
+    /* Caught up with the render thread, it can free the set it left behind. */
+    if (SDL_AtomicGet(&windata->resize_state) == MALI_RESIZE_SWITCHED && windata->buffer_set == set)
+        SDL_AtomicSet(&windata->resize_state, MALI_RESIZE_RETIRED);
+}
+
+static void
+MALI_Blitter_UnbindSet(MALI_Blitter *blitter, SDL_WindowData *windata)
+{
+    MALI_EGL_Surface *surfaces = &windata->surface[MALI_SET_FIRST(blitter->buffer_set)];
+    int i;
+
+    MALI_Blitter_DeinitChain(blitter);
+
+    blitter->glBindTexture(GL_TEXTURE_2D, 0);
+    for (i = 0; i < windata->num_buffers; i++) {
+        blitter->glDeleteTextures(1, &surfaces[i].texture);
+        blitter->eglDestroyImageKHR(blitter->egl_display, surfaces[i].egl_image);
+        surfaces[i].texture = 0;
+        surfaces[i].egl_image = EGL_NO_IMAGE_KHR;
+    }
+}
+
+int
+MALI_InitBlitterContext(_THIS, MALI_Blitter *blitter, SDL_WindowData *windata, NativeWindowType nw, int rotation, int set)
+{
+    GLchar blit_vert[2][2048] = {};
+    const GLchar *blit_frag[MALI_SCALER_COUNT] = {
+        blit_frag_standard, blit_frag_standard, blit_frag_bilinear_simple, blit_frag_quilez
+    };
+    const char *rotation_src =
+        (rotation == 0) ? "vTexCoord = aTexCoord;" :
+        (rotation == 1) ? "vTexCoord = vec2(aTexCoord.y, -aTexCoord.x);" :
+        (rotation == 2) ? "vTexCoord = vec2(-aTexCoord.x, -aTexCoord.y);" :
+        (rotation == 3) ? "vTexCoord = vec2(-aTexCoord.y, aTexCoord.x);" :
+        "#error Orientation out of scope";
+    MALI_BlitterProgram *program;
+    int i;
 
     /* The blitter thread needs to have an OpenGL ES 2.0 context available! */
     if (!MALI_Blitter_CreateContext(_this, blitter, nw)) {
@@ -280,66 +744,45 @@ MALI_InitBlitterContext(_THIS, MALI_Blitter *blitter, SDL_WindowData *windata, N
         return 0;
     }
 
-    /* Setup vertex shader coord orientation */
-    SDL_snprintf(blit_vert, sizeof(blit_vert), blit_vert_fmt,
-        /* rotation */
-        (rotation == 0) ? "vTexCoord = aTexCoord;" :
-        (rotation == 1) ? "vTexCoord = vec2(aTexCoord.y, -aTexCoord.x);" :
-        (rotation == 2) ? "vTexCoord = vec2(-aTexCoord.x, -aTexCoord.y);" :
-        (rotation == 3) ? "vTexCoord = vec2(-aTexCoord.y, aTexCoord.x);" :
-        "#error Orientation out of scope",
-        /* scalers */
-        (blitter->scaler >= 2) ? "vTexCoord = vTexCoord;"
-                               : "vTexCoord = vTexCoord / uTexSize;");
-
-    /* Compile vertex shader */
-    blitter->vert = blitter->glCreateShader(GL_VERTEX_SHADER);
-    blitter->glShaderSource(blitter->vert, 1, &sources[0], NULL);
-    blitter->glCompileShader(blitter->vert);
-    blitter->glGetShaderInfoLog(blitter->vert, sizeof(msg), NULL, msg);
-    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "Blitter Vertex Shader Info: %s\n", msg);
-
-    /* Compile the fragment shader */
-    blitter->frag = blitter->glCreateShader(GL_FRAGMENT_SHADER);
-    blitter->glShaderSource(blitter->frag, 1, &sources[1], NULL);
-    blitter->glCompileShader(blitter->frag);
-    blitter->glGetShaderInfoLog(blitter->frag, sizeof(msg), NULL, msg);
-    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "Blitter Fragment Shader Info: %s\n", msg);
-
-    blitter->prog = blitter->glCreateProgram();
-    blitter->glAttachShader(blitter->prog, blitter->vert);
-    blitter->glAttachShader(blitter->prog, blitter->frag);
-
-    blitter->glLinkProgram(blitter->prog);
-    blitter->loc_aVertCoord = blitter->glGetAttribLocation(blitter->prog, "aVertCoord");
-    blitter->loc_aTexCoord = blitter->glGetAttribLocation(blitter->prog, "aTexCoord");
-    blitter->loc_uFBOtex = blitter->glGetUniformLocation(blitter->prog, "uFBOTex");
-    blitter->loc_uProj = blitter->glGetUniformLocation(blitter->prog, "uProj");
-    blitter->loc_uTexSize = blitter->glGetUniformLocation(blitter->prog, "uTexSize");
-    blitter->loc_uScale = blitter->glGetUniformLocation(blitter->prog, "uScale");
-
-    blitter->glGetProgramInfoLog(blitter->prog, sizeof(msg), NULL, msg);
-    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "Blitter Program Info: %s\n", msg);
+    MALI_Blitter_LoadExtensions(blitter);
+    MALI_Blitter_LoadEGLExtensions(blitter);
 
-    /* Setup programs */
-    blitter->glUseProgram(blitter->prog);
-    blitter->glUniform1i(blitter->loc_uFBOtex, 0);
+    /* Setup vertex shader coord orientation, the HQ scalers work on texel coordinates. */
+    SDL_snprintf(blit_vert[0], sizeof(blit_vert[0]), blit_vert_fmt, rotation_src, "vTexCoord = vTexCoord / uTexSize;");
+    SDL_snprintf(blit_vert[1], sizeof(blit_vert[1]), blit_vert_fmt, rotation_src, "vTexCoord = vTexCoord;");
 
-    /* Prepare projection and aspect corrected bounds */
+    /* Prepare projection */
     mat_ortho(0, blitter->viewport_width, 0, blitter->viewport_height, blitter->mat_projection);
-    get_aspect_correct_coords(
-        (int [2]){blitter->viewport_width, blitter->viewport_height},
-        (int [2]){blitter->plane_width, blitter->plane_height},
-        rotation,
-        blitter->vert_buffer_data,
-        scale
-    );
 
-    /* Setup viewport, projection, scale, texture size */
+    /* Build every scaler up front, so switching between them is just a glUseProgram. */
+    for (i = 0; i < MALI_SCALER_COUNT; i++) {
+        program = &blitter->programs[i];
+        if (i == 1) {
+            /* Linear filtering only differs in texture state */
+            *program = blitter->programs[0];
+            continue;
+        }
+
+        program->prog = MALI_Blitter_BuildProgram(blitter, blit_vert[i >= 2], blit_frag[i]);
+        program->loc_uFBOtex = blitter->glGetUniformLocation(program->prog, "uFBOTex");
+        program->loc_uProj = blitter->glGetUniformLocation(program->prog, "uProj");
+        program->loc_uTexSize = blitter->glGetUniformLocation(program->prog, "uTexSize");
+        program->loc_uScale = blitter->glGetUniformLocation(program->prog, "uScale");
+
+        /* Setup projection, scale and texture size follow the buffer set */
+        blitter->glUseProgram(program->prog);
+        blitter->glUniform1i(program->loc_uFBOtex, 0);
+        blitter->glUniformMatrix4fv(program->loc_uProj, 1, 0, (GLfloat*)blitter->mat_projection);
+    }
+
+    /* The other scalers fall back to it, but without this one there's nothing to show */
+    if (blitter->programs[0].prog == 0) {
+        SDL_SetError("mali-fbdev: Unable to build the blitter program");
+        return 0;
+    }
+
+    /* Setup viewport */
     blitter->glViewport(0, 0, blitter->viewport_width, blitter->viewport_height);
-    blitter->glUniformMatrix4fv(blitter->loc_uProj, 1, 0, (GLfloat*)blitter->mat_projection);
-    blitter->glUniform2f(blitter->loc_uScale, scale[0], scale[1]);
-    blitter->glUniform2f(blitter->loc_uTexSize, blitter->plane_width, blitter->plane_height);
 
     /* Generate buffers */
     blitter->glGenBuffers(1, &blitter->vbo);
@@ -348,15 +791,15 @@ MALI_InitBlitterContext(_THIS, MALI_Blitter *blitter, SDL_WindowData *windata, N
     /* Populate buffers */
     blitter->glBindVertexArrayOES(blitter->vao);
     blitter->glBindBuffer(GL_ARRAY_BUFFER, blitter->vbo);
-    blitter->glEnableVertexAttribArray(blitter->loc_aVertCoord);
-    blitter->glEnableVertexAttribArray(blitter->loc_aTexCoord);
-    blitter->glVertexAttribPointer(blitter->loc_aVertCoord, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(0 * sizeof(float)));
-    blitter->glVertexAttribPointer(blitter->loc_aTexCoord, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    blitter->glBufferData(GL_ARRAY_BUFFER, sizeof(blitter->vert_buffer_data), blitter->vert_buffer_data, GL_STATIC_DRAW);
-    
-    for (int i = 0; i < SDL_arraysize(windata->surface); i++) {
-        MALI_Blitter_GetTexture(_this, blitter, &windata->surface[i]);
-    }
+    blitter->glEnableVertexAttribArray(MALI_ATTRIB_VERTCOORD);
+    blitter->glEnableVertexAttribArray(MALI_ATTRIB_TEXCOORD);
+    blitter->glVertexAttribPointer(MALI_ATTRIB_VERTCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(0 * sizeof(float)));
+    blitter->glVertexAttribPointer(MALI_ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    blitter->glBufferData(GL_ARRAY_BUFFER, sizeof(blitter->vert_buffer_data), NULL, GL_DYNAMIC_DRAW);
+
+    MALI_Blitter_InitOverlays(blitter);
+    MALI_Blitter_InitStack(blitter);
+    MALI_Blitter_BindSet(_this, blitter, windata, set);
 
     blitter->was_initialized = 1;
     return 1;
@@ -365,7 +808,6 @@ MALI_InitBlitterContext(_THIS, MALI_Blitter *blitter, SDL_WindowData *windata, N
 void
 MALI_DeinitBlitterContext(_THIS, MALI_Blitter *blitter)
 {
-    int i;
     SDL_Window *window;
     SDL_WindowData *windata;
 
@@ -374,12 +816,15 @@ MALI_DeinitBlitterContext(_THIS, MALI_Blitter *blitter)
         window = blitter->window;
         windata = (SDL_WindowData *)window->driverdata;
 
-        blitter->glBindTexture(GL_TEXTURE_2D, 0);
-        for (i = 0; i < SDL_arraysize(windata->surface); i++) {
-            blitter->glDeleteTextures(1, &windata->surface[i].texture);
-            blitter->eglDestroyImageKHR(blitter->egl_display, windata->surface[i].egl_image);
-        }
+        MALI_Blitter_UnbindSet(blitter, windata);
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "MALI_BlitterThread: %d frames submitted, %d presented, %d dropped.\n",
+            SDL_AtomicGet(&windata->stats.submitted),
+            SDL_AtomicGet(&windata->stats.presented),
+            SDL_AtomicGet(&windata->stats.dropped));
     }
+    MALI_Blitter_DeinitOverlays(blitter);
+    MALI_Blitter_DeinitStack(blitter);
 
     /* Tear down egl */
     blitter->eglMakeCurrent(blitter->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
@@ -387,7 +832,6 @@ MALI_DeinitBlitterContext(_THIS, MALI_Blitter *blitter)
     blitter->eglDestroyContext(blitter->egl_display, blitter->gl_context);
     blitter->eglReleaseThread();
 
-    blitter->window = NULL;
     blitter->was_initialized = 0;
     SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "MALI_BlitterThread: Released thread.\n");
 }
@@ -395,10 +839,123 @@ MALI_DeinitBlitterContext(_THIS, MALI_Blitter *blitter)
 void
 MALI_Blitter_Blit(_THIS, MALI_Blitter *blitter, GLuint texture)
 {
+    if (blitter->num_passes > 0)
+        MALI_Blitter_RunChain(blitter, &texture);
+
     /* Simple quad rendering. */
     blitter->glBindVertexArrayOES(blitter->vao);
     blitter->glBindTexture(GL_TEXTURE_2D, texture);
     blitter->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    MALI_Blitter_DrawStack(blitter);
+    MALI_Blitter_DrawOverlays(blitter);
+}
+
+/* Maps a window space rect to screen space (bottom-left origin), following the rotation. */
+static void
+MALI_Blitter_MapDamage(MALI_Blitter *blitter, const SDL_Rect *rect, SDL_Rect *result)
+{
+    float s[2], t[2], u[2], v[2], x, y, w, h;
+    int margin_x, margin_y;
+    SDL_Rect viewport = { 0, 0, blitter->viewport_width, blitter->viewport_height };
+
+    /* Texture space, where t grows upwards. Damage is in drawable pixels, which may be fewer than the window's. */
+    s[0] = (float)rect->x / blitter->plane_width;
+    s[1] = (float)(rect->x + rect->w) / blitter->plane_width;
+    t[0] = (float)(blitter->plane_height - rect->y - rect->h) / blitter->plane_height;
+    t[1] = (float)(blitter->plane_height - rect->y) / blitter->plane_height;
+
+    /* Inverse of the vertex shader rotation */
+    switch (blitter->rotation) {
+    case 1:  u[0] = 1.0f - t[1]; u[1] = 1.0f - t[0]; v[0] = s[0]; v[1] = s[1]; break;
+    case 2:  u[0] = 1.0f - s[1]; u[1] = 1.0f - s[0]; v[0] = 1.0f - t[1]; v[1] = 1.0f - t[0]; break;
+    case 3:  u[0] = t[0]; u[1] = t[1]; v[0] = 1.0f - s[1]; v[1] = 1.0f - s[0]; break;
+    default: u[0] = s[0]; u[1] = s[1]; v[0] = t[0]; v[1] = t[1]; break;
+    }
+
+    x = blitter->vert_buffer_data[0][0];
+    y = blitter->vert_buffer_data[0][1];
+    w = blitter->vert_buffer_data[3][0] - x;
+    h = blitter->vert_buffer_data[3][1] - y;
+
+    /* The filters sample neighbouring texels, grow the rect to cover them. */
+    margin_x = (int)SDL_ceilf(SDL_max(blitter->scale[0], blitter->scale[1])) + 1;
+    margin_y = margin_x;
+
+    result->x = (int)SDL_floorf(x + u[0] * w) - margin_x;
+    result->y = (int)SDL_floorf(y + v[0] * h) - margin_y;
+    result->w = (int)SDL_ceilf(x + u[1] * w) + margin_x - result->x;
+    result->h = (int)SDL_ceilf(y + v[1] * h) + margin_y - result->y;
+    if (!SDL_IntersectRect(result, &viewport, result))
+        SDL_zerop(result);
+}
+
+/* Draws the frame into the blitter surface, limited to what changed when possible. */
+static int
+MALI_Blitter_Present(_THIS, MALI_Blitter *blitter, SDL_Window *window, const MALI_Damage *damage, GLuint texture)
+{
+    SDL_Rect region;
+    EGLint age = 0, rect[4];
+    SDL_bool partial;
+    int i;
+
+    /* Post-processing passes may sample anywhere, always redraw those fully. */
+    partial = !damage->full && blitter->num_passes == 0 && blitter->has_buffer_age;
+    if (partial) {
+        MALI_Blitter_MapDamage(blitter, &damage->rect, &region);
+
+        /* The back buffer is missing whatever changed since it was last shown. */
+        if (!blitter->eglQuerySurface(blitter->egl_display, blitter->egl_surface, EGL_BUFFER_AGE_EXT, &age) ||
+            age < 1 || age > blitter->damage_frames) {
+            partial = SDL_FALSE;
+        } else {
+            for (i = 0; i < age - 1; i++) {
+                SDL_UnionRect(&region, &blitter->damage_history[i], &region);
+            }
+        }
+    }
+
+    if (!partial) {
+        region.x = region.y = 0;
+        region.w = blitter->viewport_width;
+        region.h = blitter->viewport_height;
+    }
+
+    SDL_memmove(&blitter->damage_history[1], &blitter->damage_history[0], sizeof(blitter->damage_history) - sizeof(blitter->damage_history[0]));
+    blitter->damage_history[0] = partial ? region : (SDL_Rect){ 0, 0, blitter->viewport_width, blitter->viewport_height };
+    if (blitter->damage_frames < MALI_DAMAGE_HISTORY)
+        blitter->damage_frames++;
+
+    rect[0] = region.x;
+    rect[1] = region.y;
+    rect[2] = region.w;
+    rect[3] = region.h;
+
+    if (partial) {
+        if (blitter->eglSetDamageRegionKHR)
+            blitter->eglSetDamageRegionKHR(blitter->egl_display, blitter->egl_surface, rect, 1);
+        blitter->glEnable(GL_SCISSOR_TEST);
+        blitter->glScissor(region.x, region.y, region.w, region.h);
+    }
+
+    /* Discarding previous data... */
+    blitter->glClear(GL_COLOR_BUFFER_BIT);
+
+    /* Perform blitting */
+    MALI_Blitter_Blit(_this, blitter, texture);
+
+    if (partial)
+        blitter->glDisable(GL_SCISSOR_TEST);
+
+    /* Perform the final buffer swap. */
+#if SDL_VIDEO_DRIVER_MALI_SIM
+    return MALI_Sim_SwapBuffers(blitter, _this->egl_data->egl_swapinterval);
+#else
+    if (partial && blitter->eglSwapBuffersWithDamage)
+        return blitter->eglSwapBuffersWithDamage(blitter->egl_display, blitter->egl_surface, rect, 1);
+
+    return blitter->eglSwapBuffers(blitter->egl_display, blitter->egl_surface);
+#endif
 }
 
 static void MALI_Blitter_LoadFuncs(MALI_Blitter *blitter)
@@ -435,64 +992,388 @@ static void MALI_Blitter_LoadFuncs(MALI_Blitter *blitter)
     }
 }
 
+/* Sleeps until woken up or the timeout in nanoseconds passes, negative waits forever. */
+static void
+MALI_Blitter_Sleep(MALI_Blitter *blitter, Sint64 timeout_ns)
+{
+    struct pollfd pfd = { blitter->event_fd, POLLIN, 0 };
+    struct timespec timeout;
+    eventfd_t value;
+
+    timeout.tv_sec = timeout_ns / 1000000000;
+    timeout.tv_nsec = timeout_ns % 1000000000;
+
+    /* Wakeups are merged, one read takes all of them */
+    if (ppoll(&pfd, 1, (timeout_ns < 0) ? NULL : &timeout, NULL) > 0)
+        eventfd_read(blitter->event_fd, &value);
+}
+
+/* Sleeps until woken up, meanwhile handing pool buffers that timed out back to the kernel. */
+static void
+MALI_Blitter_SleepIdle(MALI_Blitter *blitter)
+{
+    int next = MALI_PoolTrim(SDL_GetDisplayDriverData(0));
+
+    MALI_Blitter_Sleep(blitter, (next < 0) ? -1 : (Sint64)next * 1000000);
+}
+
+/*
+ * Deadline-driven presentation. Rather than blitting each frame as soon as
+ * it's queued and blocking on its fence, the blitter wakes up a margin before
+ * the next vblank and latches the queued frame only if it's done rendering.
+ * A frame that isn't ready is left in the mailbox for the next vblank, where
+ * a newer frame from the application may replace it.
+ *
+ * The vblank phase comes from the display's vblank clock.
+ */
+static Uint64
+MALI_Blitter_NextVblank(MALI_Blitter *blitter, Uint64 now)
+{
+    Uint64 vblank, interval;
+
+    MALI_VblankGet(blitter->vblank, &vblank, &interval, NULL);
+
+    /* No vblank seen yet, the phase is unknown */
+    if (vblank == 0)
+        return now;
+
+    if (vblank <= now)
+        vblank += ((now - vblank) / interval + 1) * interval;
+
+    /* Only latch once per vblank */
+    while (vblank <= blitter->latched_vblank)
+        vblank += interval;
+
+    return vblank;
+}
+
+/*
+ * Whether the blitter has nothing to do until it's woken up. Checked right
+ * before sleeping without a timeout, as the wakeup for a stop or a frame may
+ * have been taken while waiting on something else.
+ */
+static SDL_bool
+MALI_Blitter_Idle(MALI_Blitter *blitter, SDL_WindowData *windata)
+{
+    if (SDL_AtomicGet(&blitter->thread_stop) != 0)
+        return SDL_FALSE;
+
+    /* Until the blitter is set up, only the first frame's own wakeup matters */
+    if (!blitter->was_initialized)
+        return SDL_TRUE;
+
+    if (SDL_AtomicGet(&windata->queued_buffer) & MALI_BUFFER_FRESH)
+        return SDL_FALSE;
+
+    return !SDL_AtomicGet(&blitter->overlay_changed) && !MALI_Blitter_StackPending(blitter);
+}
+
+/* Sleeps until it's time to latch a frame, returns the vblank it's for, or 0 on thread stop. */
+static Uint64
+MALI_Blitter_WaitLatch(MALI_Blitter *blitter, SDL_WindowData *windata)
+{
+    Uint64 now, vblank, freq = SDL_GetPerformanceFrequency();
+
+    for (;;) {
+        if (SDL_AtomicGet(&blitter->thread_stop) != 0)
+            return 0;
+
+        /* Nothing to show, sleep until the application queues something */
+        if (MALI_Blitter_Idle(blitter, windata)) {
+            MALI_Blitter_SleepIdle(blitter);
+            continue;
+        }
+
+        now = SDL_GetPerformanceCounter();
+        vblank = MALI_Blitter_NextVblank(blitter, now);
+        if (vblank <= now + blitter->latch_margin)
+            return vblank;
+
+        /* New frames wake us up early, they're only looked at once the deadline comes */
+        MALI_Blitter_Sleep(blitter, (Sint64)((vblank - blitter->latch_margin - now) * 1000000000 / freq));
+    }
+}
+
+/* Non-blocking check on whether the GPU is done with a frame */
+SDL_bool
+MALI_Blitter_FrameReady(MALI_Blitter *blitter, MALI_EGL_Surface *surface)
+{
+    struct pollfd pfd = { surface->fence_fd, POLLIN, 0 };
+
+    if (surface->fence_fd >= 0)
+        return poll(&pfd, 1, 0) != 0;
+
+    if (surface->egl_fence == EGL_NO_SYNC)
+        return SDL_TRUE;
+
+    return blitter->eglClientWaitSyncKHR(blitter->egl_display, surface->egl_fence, 0, 0) == EGL_CONDITION_SATISFIED_KHR;
+}
+
+/*
+ * When the GPU finished a frame, as recorded in its signaled sync file, or 0
+ * when unknown. Fences are timestamped on CLOCK_MONOTONIC, which is brought
+ * over to the performance counter through the time elapsed since.
+ */
+static Uint64
+MALI_Blitter_FenceTime(int fence_fd)
+{
+    struct sync_fence_info fences[4];
+    struct sync_file_info info;
+    struct timespec now;
+    Uint64 counter, now_ns, signaled_ns = 0;
+    Uint32 i;
+
+    SDL_zero(info);
+    SDL_zeroa(fences);
+    info.num_fences = SDL_arraysize(fences);
+    info.sync_fence_info = (Uint64)(uintptr_t)fences;
+    if (fence_fd < 0 || ioctl(fence_fd, SYNC_IOC_FILE_INFO, &info) < 0 || info.status != 1)
+        return 0;
+
+    for (i = 0; i < info.num_fences; i++)
+        signaled_ns = SDL_max(signaled_ns, fences[i].timestamp_ns);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    counter = SDL_GetPerformanceCounter();
+    now_ns = (Uint64)now.tv_sec * 1000000000 + now.tv_nsec;
+
+    /* Not stamped, or too long ago to matter */
+    if (signaled_ns == 0 || signaled_ns > now_ns || now_ns - signaled_ns >= 1000000000)
+        return 0;
+
+    return counter - (now_ns - signaled_ns) * SDL_GetPerformanceFrequency() / 1000000000;
+}
+
+/*
+ * Waits for a frame to finish rendering, returns the frame to present or -1.
+ * A frame with a sync file is waited on together with the blitter's wakeups,
+ * so a thread stop doesn't have to wait for the GPU, and a newer frame that
+ * finishes first replaces the one waited on. Without a sync file, the wait
+ * blocks in EGL.
+ */
+static int
+MALI_Blitter_WaitFrame(MALI_Blitter *blitter, SDL_WindowData *windata, int page)
+{
+    MALI_EGL_Surface *surface;
+    struct pollfd pfd[2];
+    eventfd_t value;
+    int next;
+
+    for (;;) {
+        surface = &windata->surface[page & MALI_BUFFER_INDEX_MASK];
+
+        /* CPU drawn frames come without a fence */
+        if (surface->fence_fd < 0) {
+            if (surface->egl_fence != EGL_NO_SYNC && !MALI_Blitter_FrameReady(blitter, surface)) {
+                if (!blitter->eglClientWaitSyncKHR(blitter->egl_display, surface->egl_fence, 0, EGL_FOREVER_NV)) {
+                    SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "Sync %p failed.", surface->egl_fence);
+                    break;
+                }
+
+                /* Seen signaling, which is about when the GPU was done with it */
+                surface->timing.completed = SDL_GetPerformanceCounter();
+            }
+            return page;
+        }
+
+        pfd[0].fd = surface->fence_fd;
+        pfd[0].events = POLLIN;
+        pfd[0].revents = 0;
+        pfd[1].fd = blitter->event_fd;
+        pfd[1].events = POLLIN;
+        pfd[1].revents = 0;
+        if (poll(pfd, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "Sync file %d failed.", surface->fence_fd);
+            break;
+        }
+
+        /* Signaled, an error wouldn't go away by waiting either */
+        if (pfd[0].revents != 0)
+            return page;
+
+        /* A stop is flagged before its wakeup, leave one pending for the thread loop to handle it */
+        eventfd_read(blitter->event_fd, &value);
+        if (SDL_AtomicGet(&blitter->thread_stop) != 0) {
+            MALI_BlitterWake(blitter);
+            break;
+        }
+
+        next = SDL_AtomicSet(&windata->queued_buffer, MALI_BUFFER_EMPTY);
+        if ((next & MALI_BUFFER_FRESH) == 0)
+            continue;
+
+        if (MALI_Blitter_FrameReady(blitter, &windata->surface[next & MALI_BUFFER_INDEX_MASK])) {
+            /* The newer frame finished first, the slow one is never shown */
+            SDL_AtomicIncRef(&windata->stats.dropped);
+            MALI_CarryDamage(windata, page & MALI_BUFFER_INDEX_MASK, next & MALI_BUFFER_INDEX_MASK);
+            MALI_ReleaseBuffer(windata, page & MALI_BUFFER_INDEX_MASK);
+            page = next;
+        } else if (SDL_AtomicCAS(&windata->queued_buffer, MALI_BUFFER_EMPTY, next)) {
+            /* Back in the mailbox, its wakeup was taken above */
+            MALI_BlitterWake(blitter);
+        } else {
+            /* Not done either, and replaced by an even newer one meanwhile */
+            SDL_AtomicIncRef(&windata->stats.dropped);
+            MALI_CarryDamage(windata, next & MALI_BUFFER_INDEX_MASK, -1);
+            MALI_ReleaseBuffer(windata, next & MALI_BUFFER_INDEX_MASK);
+        }
+    }
+
+    MALI_ReleaseBuffer(windata, page & MALI_BUFFER_INDEX_MASK);
+    return -1;
+}
+
 int MALI_BlitterThread(void *data)
 {
-    int prevSwapInterval = -1;
+    int prevSwapInterval = -1, stop, page;
     MALI_Blitter *blitter = (MALI_Blitter*)data;
     _THIS = blitter->_this;
     SDL_Window *window = NULL;
     SDL_WindowData *windata = NULL;
     SDL_VideoDisplay *display = NULL;
     SDL_DisplayData *dispdata = SDL_GetDisplayDriverData(0);
-    unsigned int page;
     MALI_EGL_Surface *current_surface = NULL;
-    
-    MALI_Blitter_LoadFuncs(blitter);
+    static const MALI_Damage full_damage = { SDL_TRUE, { 0, 0, 0, 0 } };
+    MALI_Damage damage;
+    Uint64 latch_vblank, blit;
+    SDL_bool stack_changed, overlays_changed;
+    const char *priority, *affinity;
 
-    /* Signal triplebuf available */
-    SDL_LockMutex(blitter->mutex);
-    SDL_CondSignal(blitter->cond);
+    /*
+     * SDL_MALI_BLITTER_PRIORITY: Scheduling of the blitter thread, so it isn't
+     * preempted right before a vblank:
+     * - "normal": Like any other thread
+     * - "high": Raised nice level (default)
+     * - "fifo": SCHED_FIFO, directly when privileged or through rtkit
+     *
+     * SDL_MALI_BLITTER_AFFINITY: Cores the blitter thread runs on:
+     * - "big": The fastest cluster of big.LITTLE SoCs, any core elsewhere (default)
+     * - "little": The slowest cluster of big.LITTLE SoCs
+     * - "none": Any core
+     * - A list of cores, such as "3" or "4-5,7"
+     */
+    priority = SDL_GetHint("SDL_MALI_BLITTER_PRIORITY");
+    affinity = SDL_GetHint("SDL_MALI_BLITTER_AFFINITY");
+    MALI_SetThreadScheduling("MALI_BlitterThread", priority ? priority : "high", affinity ? affinity : "big");
+
+    MALI_Blitter_LoadFuncs(blitter);
 
     for (;;) {
-        SDL_CondWait(blitter->cond, blitter->mutex);        
+        /* Without vsync there's no deadline to work towards */
+        if (blitter->was_initialized && blitter->latch_margin && _this->egl_data->egl_swapinterval != 0) {
+            latch_vblank = MALI_Blitter_WaitLatch(blitter, windata);
+        } else {
+            latch_vblank = 0;
+            if (MALI_Blitter_Idle(blitter, windata))
+                MALI_Blitter_SleepIdle(blitter);
+        }
 
         // A thread stop can be either due to reconfigure requested, or due to
         // SDL teardown, in both cases, we will destroy some resources.
-        if (blitter->thread_stop != 0) {
-            if (blitter->was_initialized) {
-                MALI_DeinitBlitterContext(_this, blitter);
-                prevSwapInterval = -1;
+        stop = SDL_AtomicGet(&blitter->thread_stop);
+        if (stop != 0) {
+            SDL_LockMutex(blitter->mutex);
+            if (stop == 1 && blitter->released_window != blitter->window) {
+                /* A stacked window going away, the others keep showing */
+                MALI_Blitter_UnstackWindow(blitter, blitter->released_window);
+            } else {
+                if (blitter->was_initialized) {
+                    MALI_DeinitBlitterContext(_this, blitter);
+                    prevSwapInterval = -1;
+                    current_surface = NULL;
+                }
+
+                /* The lowest stacked window takes over, starting with its next frame */
+                blitter->window = (stop == 1) ? MALI_Blitter_PopStack(blitter) : NULL;
             }
+            SDL_UnlockMutex(blitter->mutex);
 
             // Done tearing down.
-            blitter->thread_stop = 0;
+            SDL_AtomicSet(&blitter->thread_stop, 0);
 
             // Signal 2 means we want to quit.
-            if (blitter->thread_stop == 2)
+            if (stop == 2)
                 break;
 
             continue;
         }
 
-        if (blitter->window == NULL) {
-            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "MALI_BlitterThread: NULL window.");
-            continue;
-        }
-
         /* If we haven't initialized the blitter, the first valid frame does it. */
         if (blitter->was_initialized == 0)
         {
+            SDL_LockMutex(blitter->mutex);
+            if (blitter->window == NULL) {
+                SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "MALI_BlitterThread: NULL window.");
+                SDL_UnlockMutex(blitter->mutex);
+                continue;
+            }
+
             /* Acquire pointers for the resources needed here. */
             window = blitter->window;
             windata = (SDL_WindowData *)window->driverdata;
             display = SDL_GetDisplayForWindow(window);
             dispdata = (SDL_DisplayData *)display->driverdata;
 
-            if (!MALI_InitBlitterContext(_this, blitter, windata, (NativeWindowType)&dispdata->native_display, blitter->rotation))
+            /* Nothing to show yet, or to tell which buffer set to start with. */
+            page = SDL_AtomicGet(&windata->queued_buffer);
+            if ((page & MALI_BUFFER_FRESH) == 0) {
+                SDL_UnlockMutex(blitter->mutex);
+                continue;
+            }
+
+            if (!MALI_InitBlitterContext(_this, blitter, windata, (NativeWindowType)&dispdata->native_display, blitter->rotation,
+                                         MALI_BUFFER_SET(page & MALI_BUFFER_INDEX_MASK)))
             {
                 SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "Failed to initialize blitter thread");
                 SDL_Quit();
-            }            
+            }
+            SDL_UnlockMutex(blitter->mutex);
+        }
+
+        /* Wakeups may be merged, only act when there's a new frame to show */
+        page = SDL_AtomicSet(&windata->queued_buffer, MALI_BUFFER_EMPTY);
+        if ((page & MALI_BUFFER_FRESH) && latch_vblank != 0 &&
+            !MALI_Blitter_FrameReady(blitter, &windata->surface[page & MALI_BUFFER_INDEX_MASK])) {
+            SDL_AtomicIncRef(&windata->dynres.missed);
+            if (!SDL_AtomicCAS(&windata->queued_buffer, MALI_BUFFER_EMPTY, page)) {
+                /* Replaced by a newer frame meanwhile, which gets its chance right away */
+                SDL_AtomicIncRef(&windata->stats.dropped);
+                MALI_CarryDamage(windata, page & MALI_BUFFER_INDEX_MASK, -1);
+                MALI_ReleaseBuffer(windata, page & MALI_BUFFER_INDEX_MASK);
+                continue;
+            }
+
+            /* Still rendering, keep showing the current frame for now */
+            page = MALI_BUFFER_EMPTY;
+        }
+
+        if ((page & MALI_BUFFER_FRESH) == 0) {
+            if (latch_vblank != 0)
+                blitter->latched_vblank = latch_vblank;
+
+            /* Stacked windows or overlays changed on their own, show them over the current frame */
+            stack_changed = MALI_Blitter_UpdateStack(_this, blitter, latch_vblank == 0);
+            overlays_changed = MALI_Blitter_UpdateOverlays(blitter, window);
+            if (current_surface && (stack_changed || overlays_changed)) {
+                blitter->damage_frames = 0;
+                blit = SDL_GetPerformanceCounter();
+                if (!MALI_Blitter_Present(_this, blitter, window, &full_damage, current_surface->texture)) {
+                    SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "eglSwapBuffers failed");
+                    return 0;
+                }
+                MALI_Blitter_FinishStack(blitter, blit, SDL_GetPerformanceCounter());
+            }
+            continue;
+        }
+
+        if (latch_vblank != 0) {
+            blitter->latched_vblank = latch_vblank;
+        } else {
+            page = MALI_Blitter_WaitFrame(blitter, windata, page);
+            if (page < 0)
+                continue;
         }
 
         if (prevSwapInterval != _this->egl_data->egl_swapinterval) {
@@ -500,48 +1381,73 @@ int MALI_BlitterThread(void *data)
             prevSwapInterval = _this->egl_data->egl_swapinterval;
         }
 
-        /* Flip the most recent back buffer with the front buffer */
-        page = windata->front_buffer;
-        windata->front_buffer = windata->queued_buffer;
-        windata->queued_buffer = page;
+        if (SDL_AtomicGet(&blitter->scale_changed))
+            MALI_Blitter_UpdateQuad(blitter, windata);
+        else if (blitter->scaler != SDL_AtomicGet(&blitter->next_scaler))
+            MALI_Blitter_SetScaler(blitter, windata, SDL_AtomicGet(&blitter->next_scaler));
+
+        /*
+         * Hand the previous front buffer back and show the most recent frame.
+         * A frame from the other buffer set means the window was resized, the
+         * old set is never shown again.
+         */
+        if (MALI_BUFFER_SET(page & MALI_BUFFER_INDEX_MASK) != blitter->buffer_set) {
+            MALI_Blitter_UnbindSet(blitter, windata);
+            MALI_Blitter_BindSet(_this, blitter, windata, MALI_BUFFER_SET(page & MALI_BUFFER_INDEX_MASK));
+        } else if (!MALI_CaptureHold(windata, windata->front_buffer)) {
+            MALI_ReleaseBuffer(windata, windata->front_buffer);
+        }
+        windata->front_buffer = page & MALI_BUFFER_INDEX_MASK;
 
-        /* select surface to wait and blit */
+        /* select surface to blit, its fence already signaled */
         current_surface = &windata->surface[windata->front_buffer];
-
-        /* wait for fence and flip display */
-        if (blitter->eglClientWaitSyncKHR(
-            blitter->egl_display,
-            current_surface->egl_fence, 
-            0,
-            EGL_FOREVER_NV))
-        {
+        SDL_AtomicLock(&windata->damage_lock);
+        damage = current_surface->damage;
+        SDL_AtomicUnlock(&windata->damage_lock);
+        if (current_surface->egl_fence != EGL_NO_SYNC) {
             /* 
                 JohnnyonFlame: Mali bug. If we don't manually destroy the fence here
                 this is going to leak and crash.
             */
             blitter->eglDestroySyncKHR(blitter->egl_display, current_surface->egl_fence);
             current_surface->egl_fence = EGL_NO_SYNC;
-
-            /* Discarding previous data... */
-            blitter->glClear(GL_COLOR_BUFFER_BIT);
-
-            /* Perform blitting */
-            MALI_Blitter_Blit(_this, blitter, current_surface->texture);
-
-            /* Perform the final buffer swap. */
-            if (!(blitter->eglSwapBuffers(blitter->egl_display, blitter->egl_surface))) {
-                SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "eglSwapBuffers failed");
-                return 0;
-            }
         }
-        else
-        {
-            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "Sync %p failed.", current_surface->egl_fence);
+        if (current_surface->fence_fd >= 0) {
+            current_surface->timing.completed = MALI_Blitter_FenceTime(current_surface->fence_fd);
+            close(current_surface->fence_fd);
+            current_surface->fence_fd = -1;
+        }
+        current_surface->timing.signaled = SDL_GetPerformanceCounter();
+#if SDL_VIDEO_DRIVER_MALI_SIM
+        MALI_Sim_UploadTexture(blitter, current_surface);
+#endif
+        if (latch_vblank == 0)
+            MALI_DynResRecord(&windata->dynres, &current_surface->timing);
+
+        /* Stacked windows and overlays that changed are redrawn in full */
+        if (MALI_Blitter_UpdateStack(_this, blitter, latch_vblank == 0))
+            blitter->damage_frames = 0;
+        if (MALI_Blitter_UpdateOverlays(blitter, window))
+            blitter->damage_frames = 0;
+
+        /* flip display */
+        current_surface->timing.blit = SDL_GetPerformanceCounter();
+        if (!MALI_Blitter_Present(_this, blitter, window, &damage, current_surface->texture)) {
+            SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "eglSwapBuffers failed");
+            return 0;
         }
+
+        current_surface->timing.present = SDL_GetPerformanceCounter();
+        if (_this->egl_data->egl_swapinterval != 0)
+            MALI_VblankRecord(blitter->vblank, current_surface->timing.present);
+        SDL_AtomicIncRef(&windata->stats.presented);
+        MALI_StatsRecord(&windata->stats, &current_surface->timing);
+        MALI_Blitter_FinishStack(blitter, current_surface->timing.blit, current_surface->timing.present);
+
+        if (windata->capture)
+            MALI_CaptureFrame(windata, windata->front_buffer);
     }    
 
-    /* Signal thread done */
-    SDL_UnlockMutex(blitter->mutex);
     return 0;
 }
 
@@ -550,9 +1456,13 @@ void MALI_BlitterInit(_THIS, MALI_Blitter *blitter)
     if (!blitter)
         return;
     
-    blitter->thread_stop = 1;
+    SDL_AtomicSet(&blitter->thread_stop, 0);
+    SDL_AddHintCallback("SDL_HQ_SCALER", MALI_Blitter_ScalerChanged, blitter);
+    SDL_AddHintCallback("SDL_MALI_SCALE_MODE", MALI_Blitter_ScaleModeChanged, blitter);
     blitter->mutex = SDL_CreateMutex();
-    blitter->cond = SDL_CreateCond();
+    blitter->event_fd = eventfd(0, EFD_CLOEXEC);
+    if (blitter->event_fd < 0)
+        SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Could not create the blitter eventfd");
     blitter->thread = SDL_CreateThread(MALI_BlitterThread, "MALI_BlitterThread", blitter);
 }
 
@@ -565,8 +1475,11 @@ void MALI_BlitterReconfigure(_THIS, SDL_Window *window, MALI_Blitter *blitter)
         return;
 
     SDL_LockMutex(blitter->mutex);
-    if (blitter->was_initialized) {
-        SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Reconfiguring a device that wasn't torn down.\n");
+    if (blitter->window) {
+        /* Another window is shown already, this one goes over it */
+        if (!MALI_Blitter_StackWindow(blitter, window))
+            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: More than %d windows, window %u isn't shown.\n",
+                        MALI_MAX_STACKED + 1, window->id);
         goto blit_reconfig_done;
     }
 
@@ -575,10 +1488,16 @@ void MALI_BlitterReconfigure(_THIS, SDL_Window *window, MALI_Blitter *blitter)
     blitter->egl_display = _this->egl_data->egl_display;
     blitter->viewport_width = dispdata->native_display.width,
     blitter->viewport_height = dispdata->native_display.height,
-    blitter->plane_width = window->w;
-    blitter->plane_height = window->h;
-    blitter->plane_pitch = dispdata->stride;
     blitter->rotation = dispdata->rotation;
+
+    /*
+     * SDL_MALI_LATCH_MARGIN: How long before vblank, in microseconds, a frame
+     * is picked for presentation. 0 (default) presents frames as soon as they
+     * are queued, waiting for them to finish rendering.
+     */
+    blitter->latch_margin = (Uint64)SDL_max(MALI_GetHintInt("SDL_MALI_LATCH_MARGIN", 0), 0) * SDL_GetPerformanceFrequency() / 1000000;
+    blitter->vblank = &dispdata->vblank;
+    blitter->latched_vblank = 0;
 blit_reconfig_done:
     SDL_UnlockMutex(blitter->mutex);
 }
@@ -588,16 +1507,16 @@ void MALI_BlitterRelease(_THIS, SDL_Window *window, MALI_Blitter *blitter)
     if (!blitter)
         return;
 
-    /* Flag a release request */
-    SDL_LockMutex(blitter->mutex);
-    blitter->thread_stop = 1;
-
-    /* Signal thread in order to perform stop */
-    SDL_CondSignal(blitter->cond);
-    SDL_UnlockMutex(blitter->mutex);
+    /*
+     * Flag a release request and wake the thread up to perform it. Only the
+     * first window takes the context down, stacked ones just drop their part.
+     */
+    blitter->released_window = window;
+    SDL_AtomicSet(&blitter->thread_stop, 1);
+    MALI_BlitterWake(blitter);
 
     /* Wait until the blitter thread is done tearing itself down */
-    while (blitter->thread_stop != 0)
+    while (SDL_AtomicGet(&blitter->thread_stop) != 0)
         SDL_Delay(0);
 }
 
@@ -606,19 +1525,25 @@ void MALI_BlitterQuit(MALI_Blitter *blitter)
     if (blitter == NULL)
         return;
 
-    /* Flag a stop request */
-    SDL_LockMutex(blitter->mutex);
-    blitter->thread_stop = 2;
+    SDL_DelHintCallback("SDL_HQ_SCALER", MALI_Blitter_ScalerChanged, blitter);
+    SDL_DelHintCallback("SDL_MALI_SCALE_MODE", MALI_Blitter_ScaleModeChanged, blitter);
 
-    /* Signal thread in order to perform stop */
-    SDL_CondSignal(blitter->cond);
-    SDL_UnlockMutex(blitter->mutex);
+    /* Flag a stop request and wake the thread up to perform it */
+    SDL_AtomicSet(&blitter->thread_stop, 2);
+    MALI_BlitterWake(blitter);
 
     /* Wait and perform teardown */
     SDL_WaitThread(blitter->thread, NULL);
     blitter->thread = NULL;
     SDL_DestroyMutex(blitter->mutex);
-    SDL_DestroyCond(blitter->cond);
+    close(blitter->event_fd);
+    MALI_Blitter_FreeOverlays(blitter);
+}
+
+/* Wakes the blitter thread up to look at the mailbox and its stop flag. */
+void MALI_BlitterWake(MALI_Blitter *blitter)
+{
+    eventfd_write(blitter->event_fd, 1);
 }
 
 #endif /* SDL_VIDEO_OPENGL_EGL */
\ No newline at end of file
@@ -11,6 +11,65 @@
 #include "SDL_egl.h"
 #include "SDL_opengl.h"
 
+#define MALI_SCALER_COUNT 4
+
+/* Frame placement on the screen, see SDL_MALI_SCALE_MODE */
+enum
+{
+    MALI_SCALE_FIT,
+    MALI_SCALE_INTEGER,
+    MALI_SCALE_FILL,
+    MALI_SCALE_STRETCH,
+    MALI_SCALE_CUSTOM
+};
+
+/* Fixed attribute locations, shared by all programs through a single VAO */
+#define MALI_ATTRIB_VERTCOORD 0
+#define MALI_ATTRIB_TEXCOORD 1
+
+typedef struct MALI_BlitterProgram {
+    GLuint prog;
+    GLint loc_uFBOtex, loc_uProj, loc_uTexSize, loc_uScale;
+} MALI_BlitterProgram;
+
+/* A post-processing pass, see SDL_maliblitter_chain.c */
+#define MALI_MAX_PASSES 8
+
+typedef struct MALI_BlitterPass {
+    GLuint prog, fbo, texture;
+    GLint filter;
+    GLsizei width, height;
+} MALI_BlitterPass;
+
+/* A layer composited over the frame, see SDL_maliblitter_overlay.c */
+#define MALI_MAX_OVERLAYS 4
+#define MALI_OVERLAY_CURSOR MALI_MAX_OVERLAYS
+
+typedef struct MALI_BlitterOverlay {
+    /* Handed over to the blitter thread under overlay_lock */
+    Uint32 *pending;
+    int pending_w, pending_h;
+    SDL_Rect pending_dst;
+    SDL_bool has_pending;
+
+    /* Owned by the blitter thread, pixels is only written under overlay_lock */
+    Uint32 *pixels;         /* RGBA, NULL when hidden */
+    int w, h;
+    SDL_Rect dst;           /* display coordinates, relative to the pointer for the cursor */
+    GLuint texture;
+    SDL_bool uploaded;
+} MALI_BlitterOverlay;
+
+/* A window shown over the first one, see SDL_maliblitter_stack.c */
+#define MALI_MAX_STACKED 4
+
+typedef struct MALI_BlitterStacked {
+    SDL_Window *window;
+    SDL_Rect rect;          /* display coordinates */
+    float opacity;
+    SDL_bool visible;
+} MALI_BlitterStacked;
+
 typedef struct MALI_Blitter {
     /* OpenGL Surface and Context */
     _THIS;
@@ -20,34 +79,118 @@ typedef struct MALI_Blitter {
     SDL_GLContext *gl_context;
     SDL_Window *window;
     EGLConfig config;
-    GLuint frag, vert, prog, vbo, vao;
-    GLint loc_aVertCoord, loc_aTexCoord, loc_uFBOtex, loc_uProj, loc_uTexSize, loc_uScale;
+    MALI_BlitterProgram programs[MALI_SCALER_COUNT];
+    MALI_BlitterPass *passes;
+    int num_passes;
+    GLuint vbo, vao, pass_vbo, pass_vao;
     GLsizei viewport_width, viewport_height;
     GLint plane_width, plane_height, plane_pitch;
+    GLint source_width, source_height;
     float mat_projection[4][4];
     float vert_buffer_data[4][4];
+    float scale[2];
+    GLuint scaler_prog;         /* program of the scaler in use */
+
+    /* Screen regions redrawn in the last frames, most recent first */
+    #define MALI_DAMAGE_HISTORY 4
+    SDL_Rect damage_history[MALI_DAMAGE_HISTORY];
+    int damage_frames;
 
     // Triple buffering thread
     SDL_mutex *mutex;
-    SDL_cond *cond;
+    int event_fd;               /* wakes the thread up, see MALI_BlitterWake */
     SDL_Thread *thread;
-    int thread_stop;
+    SDL_atomic_t thread_stop;
     int rotation;
     int next;
     int scaler;
+    SDL_atomic_t next_scaler;
+    SDL_bool integer_scale;     /* the quad is a whole multiple of the source */
+
+    /* Requested scale mode, picked up by the thread when scale_changed is set */
+    SDL_SpinLock scale_lock;
+    int scale_mode;
+    SDL_Rect scale_rect;
+    SDL_atomic_t scale_changed;
+    int buffer_set;
     int was_initialized;
 
+    /* Deadline-driven presentation, all in performance counter ticks */
+    MALI_VblankClock *vblank;
+    Uint64 latch_margin;
+    Uint64 latched_vblank;
+
+    /* Overlay layers, the last one is the cursor */
+    SDL_SpinLock overlay_lock;
+    SDL_atomic_t overlay_changed;
+    MALI_BlitterOverlay overlays[MALI_MAX_OVERLAYS + 1];
+    SDL_Window *cursor_window;  /* under overlay_lock, the window the pointer is over */
+    int cursor_x, cursor_y;     /* under overlay_lock, window coordinates */
+    GLuint overlay_prog, overlay_vbo, overlay_vao;
+    GLuint overlay_textures[MALI_MAX_OVERLAYS + 1];
+    int num_overlay_quads;
+
+    /* Windows stacked over the first one, bottom first */
+    SDL_SpinLock stack_lock;
+    SDL_atomic_t stack_changed;
+    MALI_BlitterStacked stack[MALI_MAX_STACKED];   /* under stack_lock */
+    int stack_size;                                 /* under stack_lock */
+    SDL_Window *released_window;
+    GLuint stack_prog, stack_vbo, stack_vao;
+    GLint loc_stack_opacity;
+    GLuint stack_textures[MALI_MAX_STACKED];
+    float stack_opacity[MALI_MAX_STACKED];
+    int num_stack_quads;
+
     void *user_data;
 
     #define SDL_PROC(ret,func,params) ret (APIENTRY *func) params;
     #include "SDL_maliblitter_egl_funcs.h"
     #include "SDL_maliblitter_gles_funcs.h"
     #undef SDL_PROC
+
+    /* EGL_KHR_partial_update and EGL_{KHR,EXT}_swap_buffers_with_damage, NULL when unavailable */
+    SDL_bool has_buffer_age;
+    EGLBoolean (APIENTRY *eglSetDamageRegionKHR)(EGLDisplay, EGLSurface, EGLint *, EGLint);
+    EGLBoolean (APIENTRY *eglSwapBuffersWithDamage)(EGLDisplay, EGLSurface, const EGLint *, EGLint);
+
+    /* GL_OES_get_program_binary, NULL when unavailable */
+    void (APIENTRY *glGetProgramBinaryOES)(GLuint, GLsizei, GLsizei *, GLenum *, void *);
+    void (APIENTRY *glProgramBinaryOES)(GLuint, GLenum, const void *, GLint);
 } MALI_Blitter;
 
-extern int MALI_InitBlitterContext(_THIS, MALI_Blitter *blitter, SDL_WindowData *windata, NativeWindowType nw, int rotation);
+extern int MALI_InitBlitterContext(_THIS, MALI_Blitter *blitter, SDL_WindowData *windata, NativeWindowType nw, int rotation, int set);
 extern int MALI_BlitterThread(void *data);
+extern GLuint MALI_Blitter_BuildProgram(MALI_Blitter *blitter, const GLchar *vert_src, const GLchar *frag_src);
+extern int MALI_Blitter_InitChain(MALI_Blitter *blitter, MALI_EGL_Surface *surfaces, int num_surfaces, GLint *width, GLint *height);
+extern void MALI_Blitter_DeinitChain(MALI_Blitter *blitter);
+extern void MALI_Blitter_RunChain(MALI_Blitter *blitter, GLuint *texture);
+extern void MALI_Blitter_MapDisplayRect(MALI_Blitter *blitter, const SDL_Rect *rect, SDL_Rect *result);
+extern void MALI_Blitter_GetTexture(_THIS, MALI_Blitter *blitter, MALI_EGL_Surface *surf);
+extern SDL_bool MALI_Blitter_FrameReady(MALI_Blitter *blitter, MALI_EGL_Surface *surface);
+extern void MALI_Blitter_MakeQuad(MALI_Blitter *blitter, const SDL_Rect *rect, GLfloat quad[4][4]);
+extern void MALI_Blitter_InitOverlays(MALI_Blitter *blitter);
+extern void MALI_Blitter_DeinitOverlays(MALI_Blitter *blitter);
+extern void MALI_Blitter_FreeOverlays(MALI_Blitter *blitter);
+extern void MALI_Blitter_SetOverlay(MALI_Blitter *blitter, int layer, Uint32 *pixels, int w, int h, const SDL_Rect *dst);
+extern void MALI_Blitter_MoveCursor(MALI_Blitter *blitter, SDL_Window *window, int x, int y);
+extern SDL_bool MALI_Blitter_UpdateOverlays(MALI_Blitter *blitter, SDL_Window *window);
+extern void MALI_Blitter_DrawOverlays(MALI_Blitter *blitter);
+extern SDL_bool MALI_Blitter_StackWindow(MALI_Blitter *blitter, SDL_Window *window);
+extern void MALI_Blitter_UnstackWindow(MALI_Blitter *blitter, SDL_Window *window);
+extern SDL_Window *MALI_Blitter_PopStack(MALI_Blitter *blitter);
+extern void MALI_Blitter_PlaceWindow(MALI_Blitter *blitter, SDL_Window *window, const SDL_Rect *rect, SDL_bool visible, float opacity);
+extern void MALI_Blitter_RaiseWindow(MALI_Blitter *blitter, SDL_Window *window);
+extern SDL_Window *MALI_Blitter_GetTopWindow(MALI_Blitter *blitter);
+extern SDL_bool MALI_Blitter_GetStackedRect(MALI_Blitter *blitter, SDL_Window *window, SDL_Rect *rect);
+extern void MALI_Blitter_InitStack(MALI_Blitter *blitter);
+extern void MALI_Blitter_DeinitStack(MALI_Blitter *blitter);
+extern SDL_bool MALI_Blitter_StackPending(MALI_Blitter *blitter);
+extern SDL_bool MALI_Blitter_UpdateStack(_THIS, MALI_Blitter *blitter, SDL_bool wait);
+extern void MALI_Blitter_DrawStack(MALI_Blitter *blitter);
+extern void MALI_Blitter_FinishStack(MALI_Blitter *blitter, Uint64 blit, Uint64 present);
 void MALI_BlitterInit(_THIS, MALI_Blitter *blitter);
+extern void MALI_BlitterWake(MALI_Blitter *blitter);
 extern void MALI_BlitterReconfigure(_THIS, SDL_Window *window, MALI_Blitter *blitter);
 extern void MALI_BlitterRelease(_THIS, SDL_Window *window, MALI_Blitter *blitter);
 extern void MALI_BlitterQuit(MALI_Blitter *blitter);
@@ -0,0 +1,332 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_OPENGL_EGL
+
+#include "SDL.h"
+#include "SDL_egl.h"
+#include "SDL_opengl.h"
+
+#include "SDL_malivideo.h"
+#include "SDL_maliblitter.h"
+
+/*
+ * Post-processing chain, loaded from the preset file named by the
+ * SDL_MALI_SHADER_PRESET hint when the blitter initializes. The preset is a
+ * list of "key = value" lines, '#' starts a comment:
+ *
+ *   shaders = 2
+ *   shader0 = crt.glsl          # fragment shader, relative to the preset
+ *   scale0 = 3.0                # output size relative to the pass input
+ *   filter_linear0 = false      # how the pass samples its input
+ *   shader1 = ...
+ *
+ * Each pass renders into its own texture, allocated once, which feeds the
+ * next pass. The last one is then drawn by the regular scaler, which takes
+ * care of rotation and aspect correction. Pass shaders get the normalized
+ * vTexCoord varying and the uFBOTex, uTexSize (input size in pixels) and
+ * uOutputSize uniforms.
+ */
+
+static const GLchar *pass_vert =
+"#version 100\n"
+"varying vec2 vTexCoord;\n"
+"attribute vec2 aVertCoord;\n"
+"attribute vec2 aTexCoord;\n"
+"void main() {\n"
+"   vTexCoord = aTexCoord;\n"
+"   gl_Position = vec4(aVertCoord, 0.0, 1.0);\n"
+"}";
+
+static const GLfloat pass_quad[4][4] = {
+    { -1.0f, -1.0f, 0.0f, 0.0f },
+    { -1.0f,  1.0f, 0.0f, 1.0f },
+    {  1.0f, -1.0f, 1.0f, 0.0f },
+    {  1.0f,  1.0f, 1.0f, 1.0f },
+};
+
+typedef struct MALI_ChainPreset
+{
+    int count;
+    char *shader[MALI_MAX_PASSES];
+    float scale[MALI_MAX_PASSES];
+    SDL_bool linear[MALI_MAX_PASSES];
+} MALI_ChainPreset;
+
+static char *
+trim(char *str)
+{
+    char *end;
+
+    while (*str == ' ' || *str == '\t' || *str == '"')
+        str++;
+
+    end = str + SDL_strlen(str);
+    while (end > str && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '"'))
+        end--;
+    *end = '\0';
+
+    return str;
+}
+
+/* Matches "<prefix><index>", returning the index or -1. */
+static int
+preset_index(const char *key, const char *prefix)
+{
+    size_t len = SDL_strlen(prefix);
+    int index;
+
+    if (SDL_strncmp(key, prefix, len) != 0 || key[len] < '0' || key[len] > '9')
+        return -1;
+
+    index = SDL_atoi(key + len);
+    return (index < MALI_MAX_PASSES) ? index : -1;
+}
+
+static void
+MALI_Chain_ParsePreset(char *text, MALI_ChainPreset *preset)
+{
+    char *line, *next, *key, *value;
+    int i;
+
+    for (i = 0; i < MALI_MAX_PASSES; i++) {
+        preset->shader[i] = NULL;
+        preset->scale[i] = 1.0f;
+        preset->linear[i] = SDL_FALSE;
+    }
+    preset->count = 0;
+
+    for (line = text; line != NULL; line = next) {
+        if ((next = SDL_strchr(line, '\n')) != NULL)
+            *next++ = '\0';
+        if ((value = SDL_strchr(line, '#')) != NULL)
+            *value = '\0';
+        if ((value = SDL_strchr(line, '=')) == NULL)
+            continue;
+
+        *value++ = '\0';
+        key = trim(line);
+        value = trim(value);
+
+        if (SDL_strcmp(key, "shaders") == 0)
+            preset->count = SDL_clamp(SDL_atoi(value), 0, MALI_MAX_PASSES);
+        else if ((i = preset_index(key, "shader")) >= 0)
+            preset->shader[i] = value;
+        else if ((i = preset_index(key, "scale")) >= 0)
+            preset->scale[i] = (float)SDL_atof(value);
+        else if ((i = preset_index(key, "filter_linear")) >= 0)
+            preset->linear[i] = (SDL_strcmp(value, "true") == 0 || SDL_strcmp(value, "1") == 0);
+    }
+}
+
+static char *
+MALI_Chain_LoadShader(const char *preset_path, const char *shader)
+{
+    const char *slash = SDL_strrchr(preset_path, '/');
+    size_t dirlen = (shader[0] != '/' && slash) ? (size_t)(slash - preset_path + 1) : 0;
+    size_t len = dirlen + SDL_strlen(shader) + 1;
+    char *path, *source;
+
+    if ((path = SDL_malloc(len)) == NULL)
+        return NULL;
+
+    SDL_snprintf(path, len, "%.*s%s", (int)dirlen, preset_path, shader);
+    source = SDL_LoadFile(path, NULL);
+    if (source == NULL)
+        SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Can't load shader %s: %s", path, SDL_GetError());
+
+    SDL_free(path);
+    return source;
+}
+
+static SDL_bool
+MALI_Chain_InitPass(MALI_Blitter *blitter, MALI_BlitterPass *pass, const GLchar *frag, GLsizei in_w, GLsizei in_h)
+{
+    /* Output target, only ever written by this pass and read by the next */
+    blitter->glGenTextures(1, &pass->texture);
+    blitter->glBindTexture(GL_TEXTURE_2D, pass->texture);
+    blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    blitter->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, pass->width, pass->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    blitter->glGenFramebuffers(1, &pass->fbo);
+    blitter->glBindFramebuffer(GL_FRAMEBUFFER, pass->fbo);
+    blitter->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pass->texture, 0);
+    if (blitter->glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        blitter->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Incomplete framebuffer for a %dx%d pass", pass->width, pass->height);
+        return SDL_FALSE;
+    }
+    blitter->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    /* Sizes never change for the lifetime of the pass, set them once */
+    pass->prog = MALI_Blitter_BuildProgram(blitter, pass_vert, frag);
+    if (pass->prog == 0)
+        return SDL_FALSE;
+
+    blitter->glUseProgram(pass->prog);
+    blitter->glUniform1i(blitter->glGetUniformLocation(pass->prog, "uFBOTex"), 0);
+    blitter->glUniform2f(blitter->glGetUniformLocation(pass->prog, "uTexSize"), in_w, in_h);
+    blitter->glUniform2f(blitter->glGetUniformLocation(pass->prog, "uOutputSize"), pass->width, pass->height);
+
+    return SDL_TRUE;
+}
+
+int
+MALI_Blitter_InitChain(MALI_Blitter *blitter, MALI_EGL_Surface *surfaces, int num_surfaces, GLint *width, GLint *height)
+{
+    const char *preset_path = SDL_GetHint("SDL_MALI_SHADER_PRESET");
+    MALI_ChainPreset preset;
+    MALI_BlitterPass *pass;
+    char *text, *frag;
+    GLsizei in_w = *width, in_h = *height;
+    int i;
+
+    blitter->passes = NULL;
+    blitter->num_passes = 0;
+    if (!preset_path || !*preset_path)
+        return 0;
+
+    if ((text = SDL_LoadFile(preset_path, NULL)) == NULL) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Can't load shader preset %s: %s", preset_path, SDL_GetError());
+        return 0;
+    }
+
+    MALI_Chain_ParsePreset(text, &preset);
+    if (preset.count > 0)
+        blitter->passes = (MALI_BlitterPass *)SDL_calloc(preset.count, sizeof(MALI_BlitterPass));
+    if (!blitter->passes) {
+        SDL_free(text);
+        return 0;
+    }
+
+    for (i = 0; i < preset.count; i++) {
+        pass = &blitter->passes[i];
+        pass->filter = preset.linear[i] ? GL_LINEAR : GL_NEAREST;
+        pass->width = SDL_max(1, (GLsizei)(in_w * preset.scale[i] + 0.5f));
+        pass->height = SDL_max(1, (GLsizei)(in_h * preset.scale[i] + 0.5f));
+
+        frag = preset.shader[i] ? MALI_Chain_LoadShader(preset_path, preset.shader[i]) : NULL;
+        blitter->num_passes++;
+        if (!frag || !MALI_Chain_InitPass(blitter, pass, frag, in_w, in_h)) {
+            SDL_free(frag);
+            SDL_free(text);
+            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Shader preset pass %d failed, disabling post-processing", i);
+            MALI_Blitter_DeinitChain(blitter);
+            return 0;
+        }
+
+        SDL_free(frag);
+        in_w = pass->width;
+        in_h = pass->height;
+    }
+    SDL_free(text);
+
+    /* One quad covering the whole target, shared by every pass */
+    blitter->glGenBuffers(1, &blitter->pass_vbo);
+    blitter->glGenVertexArraysOES(1, &blitter->pass_vao);
+    blitter->glBindVertexArrayOES(blitter->pass_vao);
+    blitter->glBindBuffer(GL_ARRAY_BUFFER, blitter->pass_vbo);
+    blitter->glEnableVertexAttribArray(MALI_ATTRIB_VERTCOORD);
+    blitter->glEnableVertexAttribArray(MALI_ATTRIB_TEXCOORD);
+    blitter->glVertexAttribPointer(MALI_ATTRIB_VERTCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(0 * sizeof(float)));
+    blitter->glVertexAttribPointer(MALI_ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    blitter->glBufferData(GL_ARRAY_BUFFER, sizeof(pass_quad), pass_quad, GL_STATIC_DRAW);
+    blitter->glBindVertexArrayOES(0);
+
+    /* The first pass samples the window surfaces with its own filter */
+    for (i = 0; i < num_surfaces; i++) {
+        blitter->glBindTexture(GL_TEXTURE_2D, surfaces[i].texture);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, blitter->passes[0].filter);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, blitter->passes[0].filter);
+    }
+
+    /* Every following pass samples the previous pass output */
+    for (i = 1; i < blitter->num_passes; i++) {
+        blitter->glBindTexture(GL_TEXTURE_2D, blitter->passes[i - 1].texture);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, blitter->passes[i].filter);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, blitter->passes[i].filter);
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Loaded %d pass shader preset %s (%dx%d output)",
+        blitter->num_passes, preset_path, in_w, in_h);
+
+    *width = in_w;
+    *height = in_h;
+    return blitter->num_passes;
+}
+
+void
+MALI_Blitter_DeinitChain(MALI_Blitter *blitter)
+{
+    MALI_BlitterPass *pass;
+    int i;
+
+    for (i = 0; i < blitter->num_passes; i++) {
+        pass = &blitter->passes[i];
+        if (pass->prog)
+            blitter->glDeleteProgram(pass->prog);
+        if (pass->fbo)
+            blitter->glDeleteFramebuffers(1, &pass->fbo);
+        if (pass->texture)
+            blitter->glDeleteTextures(1, &pass->texture);
+    }
+
+    if (blitter->pass_vao) {
+        blitter->glDeleteVertexArraysOES(1, &blitter->pass_vao);
+        blitter->glDeleteBuffers(1, &blitter->pass_vbo);
+        blitter->pass_vao = blitter->pass_vbo = 0;
+    }
+
+    SDL_free(blitter->passes);
+    blitter->passes = NULL;
+    blitter->num_passes = 0;
+}
+
+void
+MALI_Blitter_RunChain(MALI_Blitter *blitter, GLuint *texture)
+{
+    MALI_BlitterPass *pass;
+    int i;
+
+    blitter->glBindVertexArrayOES(blitter->pass_vao);
+    for (i = 0; i < blitter->num_passes; i++) {
+        pass = &blitter->passes[i];
+        blitter->glBindFramebuffer(GL_FRAMEBUFFER, pass->fbo);
+        blitter->glViewport(0, 0, pass->width, pass->height);
+        blitter->glUseProgram(pass->prog);
+        blitter->glBindTexture(GL_TEXTURE_2D, *texture);
+        blitter->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        *texture = pass->texture;
+    }
+
+    /* Back to the screen for the final, scaled pass */
+    blitter->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    blitter->glViewport(0, 0, blitter->viewport_width, blitter->viewport_height);
+    blitter->glUseProgram(blitter->scaler_prog);
+}
+
+#endif /* SDL_VIDEO_OPENGL_EGL */
+
+/* vi: set ts=4 sw=4 expandtab: */
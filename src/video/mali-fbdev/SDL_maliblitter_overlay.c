@@ -0,0 +1,332 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_OPENGL_EGL
+
+#include "SDL.h"
+#include "SDL_egl.h"
+#include "SDL_opengl.h"
+
+#include "SDL_malivideo.h"
+#include "SDL_maliblitter.h"
+
+/*
+ * Overlay layers are composited in the same pass as the frame, each one a
+ * quad of its own sampling a small texture. They're placed in display
+ * coordinates and shown upright at the panel's resolution, whatever the
+ * scaling of the frame below, without the application redrawing anything.
+ * The cursor layer follows the pointer over the frame and goes above the
+ * others.
+ *
+ * Layer contents are handed over through their pending fields under
+ * overlay_lock. The blitter picks them up with its next frame, or right away
+ * when woken up without one, and keeps them to upload again after a context
+ * reset. Layer textures are uploaded top row first, the texture coordinates
+ * of the quads keep that row at the top in display space.
+ */
+
+static const GLchar *overlay_vert =
+"#version 100\n"
+"varying vec2 vTexCoord;\n"
+"attribute vec2 aVertCoord;\n"
+"attribute vec2 aTexCoord;\n"
+"uniform mat4 uProj;\n"
+"void main() {\n"
+"   vTexCoord = aTexCoord;\n"
+"   gl_Position = uProj * vec4(aVertCoord, 0.0, 1.0);\n"
+"}";
+
+static const GLchar *overlay_frag =
+"#version 100\n"
+"precision mediump float;\n"
+"varying vec2 vTexCoord;\n"
+"uniform sampler2D uFBOTex;\n"
+"void main() {\n"
+"   gl_FragColor = texture2D(uFBOTex, vTexCoord);\n"
+"}\n";
+
+/* Maps a screen space point (bottom-left origin) to display space (top-left origin), following the rotation. */
+static void
+MALI_Overlay_UnmapPoint(MALI_Blitter *blitter, float x, float y, float *dx, float *dy)
+{
+    const float w = blitter->viewport_width, h = blitter->viewport_height;
+
+    switch (blitter->rotation) {
+    case 1:  *dx = y;     *dy = x;     break;
+    case 2:  *dx = w - x; *dy = y;     break;
+    case 3:  *dx = h - y; *dy = w - x; break;
+    default: *dx = x;     *dy = h - y; break;
+    }
+}
+
+/* Builds the quad showing a layer upright at rect, in display coordinates. */
+void
+MALI_Blitter_MakeQuad(MALI_Blitter *blitter, const SDL_Rect *rect, GLfloat quad[4][4])
+{
+    SDL_Rect screen;
+    float dx, dy;
+    int i;
+
+    MALI_Blitter_MapDisplayRect(blitter, rect, &screen);
+
+    /* Same corner order as the frame quad */
+    for (i = 0; i < 4; i++) {
+        quad[i][0] = screen.x + ((i & 2) ? screen.w : 0);
+        quad[i][1] = screen.y + ((i & 1) ? screen.h : 0);
+
+        MALI_Overlay_UnmapPoint(blitter, quad[i][0], quad[i][1], &dx, &dy);
+        quad[i][2] = (dx - rect->x) / rect->w;
+        quad[i][3] = (dy - rect->y) / rect->h;
+    }
+}
+
+/* Where the frame quad is, in display coordinates. */
+static void
+MALI_Overlay_GetFrameRect(MALI_Blitter *blitter, SDL_Rect *rect)
+{
+    float x0, y0, x1, y1;
+
+    MALI_Overlay_UnmapPoint(blitter, blitter->vert_buffer_data[0][0], blitter->vert_buffer_data[0][1], &x0, &y0);
+    MALI_Overlay_UnmapPoint(blitter, blitter->vert_buffer_data[3][0], blitter->vert_buffer_data[3][1], &x1, &y1);
+
+    rect->x = (int)SDL_min(x0, x1);
+    rect->y = (int)SDL_min(y0, y1);
+    rect->w = (int)SDL_fabs(x1 - x0);
+    rect->h = (int)SDL_fabs(y1 - y0);
+}
+
+void
+MALI_Blitter_InitOverlays(MALI_Blitter *blitter)
+{
+    blitter->overlay_prog = MALI_Blitter_BuildProgram(blitter, overlay_vert, overlay_frag);
+    blitter->glUseProgram(blitter->overlay_prog);
+    blitter->glUniform1i(blitter->glGetUniformLocation(blitter->overlay_prog, "uFBOTex"), 0);
+    blitter->glUniformMatrix4fv(blitter->glGetUniformLocation(blitter->overlay_prog, "uProj"), 1, 0, (GLfloat*)blitter->mat_projection);
+
+    blitter->glGenBuffers(1, &blitter->overlay_vbo);
+    blitter->glGenVertexArraysOES(1, &blitter->overlay_vao);
+    blitter->glBindVertexArrayOES(blitter->overlay_vao);
+    blitter->glBindBuffer(GL_ARRAY_BUFFER, blitter->overlay_vbo);
+    blitter->glEnableVertexAttribArray(MALI_ATTRIB_VERTCOORD);
+    blitter->glEnableVertexAttribArray(MALI_ATTRIB_TEXCOORD);
+    blitter->glVertexAttribPointer(MALI_ATTRIB_VERTCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(0 * sizeof(float)));
+    blitter->glVertexAttribPointer(MALI_ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    blitter->glBufferData(GL_ARRAY_BUFFER, (MALI_MAX_OVERLAYS + 1) * sizeof(blitter->vert_buffer_data), NULL, GL_DYNAMIC_DRAW);
+    blitter->glBindVertexArrayOES(0);
+
+    /* Everything has to be uploaded again */
+    blitter->num_overlay_quads = 0;
+    SDL_AtomicSet(&blitter->overlay_changed, 1);
+}
+
+void
+MALI_Blitter_DeinitOverlays(MALI_Blitter *blitter)
+{
+    MALI_BlitterOverlay *overlay;
+    int i;
+
+    for (i = 0; i <= MALI_MAX_OVERLAYS; i++) {
+        overlay = &blitter->overlays[i];
+        if (overlay->texture)
+            blitter->glDeleteTextures(1, &overlay->texture);
+        overlay->texture = 0;
+        overlay->uploaded = SDL_FALSE;
+    }
+
+    if (blitter->overlay_vao) {
+        blitter->glDeleteVertexArraysOES(1, &blitter->overlay_vao);
+        blitter->glDeleteBuffers(1, &blitter->overlay_vbo);
+        blitter->overlay_vao = blitter->overlay_vbo = 0;
+    }
+    if (blitter->overlay_prog)
+        blitter->glDeleteProgram(blitter->overlay_prog);
+    blitter->overlay_prog = 0;
+    blitter->num_overlay_quads = 0;
+}
+
+/* Frees the layer contents, once the blitter thread is gone. */
+void
+MALI_Blitter_FreeOverlays(MALI_Blitter *blitter)
+{
+    int i;
+
+    for (i = 0; i <= MALI_MAX_OVERLAYS; i++) {
+        SDL_free(blitter->overlays[i].pending);
+        SDL_free(blitter->overlays[i].pixels);
+        SDL_zero(blitter->overlays[i]);
+    }
+}
+
+/*
+ * Replaces the contents of a layer, taking ownership of pixels: RGBA bytes,
+ * tightly packed, or NULL to hide it. Any thread may call this.
+ */
+void
+MALI_Blitter_SetOverlay(MALI_Blitter *blitter, int layer, Uint32 *pixels, int w, int h, const SDL_Rect *dst)
+{
+    MALI_BlitterOverlay *overlay = &blitter->overlays[layer];
+    Uint32 *retired;
+
+    SDL_AtomicLock(&blitter->overlay_lock);
+    retired = overlay->pending;
+    overlay->pending = pixels;
+    overlay->pending_w = w;
+    overlay->pending_h = h;
+    overlay->pending_dst = *dst;
+    overlay->has_pending = SDL_TRUE;
+    SDL_AtomicUnlock(&blitter->overlay_lock);
+
+    SDL_free(retired);
+    SDL_AtomicSet(&blitter->overlay_changed, 1);
+    MALI_BlitterWake(blitter);
+}
+
+/* Moves the cursor layer to follow the pointer, in coordinates of the window it's over. */
+void
+MALI_Blitter_MoveCursor(MALI_Blitter *blitter, SDL_Window *window, int x, int y)
+{
+    MALI_BlitterOverlay *cursor = &blitter->overlays[MALI_OVERLAY_CURSOR];
+    SDL_bool visible;
+
+    SDL_AtomicLock(&blitter->overlay_lock);
+    blitter->cursor_window = window;
+    blitter->cursor_x = x;
+    blitter->cursor_y = y;
+    visible = cursor->has_pending ? (cursor->pending != NULL) : (cursor->pixels != NULL);
+    SDL_AtomicUnlock(&blitter->overlay_lock);
+
+    /* Nothing to redraw for a hidden cursor */
+    if (visible) {
+        SDL_AtomicSet(&blitter->overlay_changed, 1);
+        MALI_BlitterWake(blitter);
+    }
+}
+
+/* Takes the pending layer changes, returns whether anything changed on screen. */
+SDL_bool
+MALI_Blitter_UpdateOverlays(MALI_Blitter *blitter, SDL_Window *window)
+{
+    GLfloat quads[MALI_MAX_OVERLAYS + 1][4][4];
+    Uint32 *retired[MALI_MAX_OVERLAYS + 1];
+    MALI_BlitterOverlay *overlay;
+    SDL_Window *cursor_window;
+    SDL_Rect frame, rect, stacked;
+    int cursor_x, cursor_y, i;
+    SDL_bool was_visible;
+
+    if (!SDL_AtomicSet(&blitter->overlay_changed, 0))
+        return SDL_FALSE;
+
+    SDL_AtomicLock(&blitter->overlay_lock);
+    for (i = 0; i <= MALI_MAX_OVERLAYS; i++) {
+        overlay = &blitter->overlays[i];
+        retired[i] = NULL;
+        if (!overlay->has_pending)
+            continue;
+
+        retired[i] = overlay->pixels;
+        overlay->pixels = overlay->pending;
+        overlay->w = overlay->pending_w;
+        overlay->h = overlay->pending_h;
+        overlay->dst = overlay->pending_dst;
+        overlay->pending = NULL;
+        overlay->has_pending = SDL_FALSE;
+        overlay->uploaded = SDL_FALSE;
+    }
+    cursor_window = blitter->cursor_window;
+    cursor_x = blitter->cursor_x;
+    cursor_y = blitter->cursor_y;
+    SDL_AtomicUnlock(&blitter->overlay_lock);
+
+    MALI_Overlay_GetFrameRect(blitter, &frame);
+    was_visible = (blitter->num_overlay_quads > 0);
+    blitter->num_overlay_quads = 0;
+
+    for (i = 0; i <= MALI_MAX_OVERLAYS; i++) {
+        overlay = &blitter->overlays[i];
+        SDL_free(retired[i]);
+        if (!overlay->pixels)
+            continue;
+
+        if (!overlay->uploaded) {
+            if (!overlay->texture)
+                blitter->glGenTextures(1, &overlay->texture);
+            blitter->glBindTexture(GL_TEXTURE_2D, overlay->texture);
+            blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            blitter->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, overlay->w, overlay->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, overlay->pixels);
+            overlay->uploaded = SDL_TRUE;
+        }
+
+        /* The cursor's rect is relative to the pointer, the hotspot at its origin */
+        rect = overlay->dst;
+        if (i == MALI_OVERLAY_CURSOR && cursor_window != window &&
+            MALI_Blitter_GetStackedRect(blitter, cursor_window, &stacked)) {
+            /* Stacked windows aren't scaled */
+            rect.x += stacked.x + cursor_x;
+            rect.y += stacked.y + cursor_y;
+        } else if (i == MALI_OVERLAY_CURSOR) {
+            if (window->w <= 0 || window->h <= 0)
+                continue;
+            rect.x += frame.x + cursor_x * frame.w / window->w;
+            rect.y += frame.y + cursor_y * frame.h / window->h;
+        }
+
+        MALI_Blitter_MakeQuad(blitter, &rect, quads[blitter->num_overlay_quads]);
+        blitter->overlay_textures[blitter->num_overlay_quads++] = overlay->texture;
+    }
+
+    if (blitter->num_overlay_quads > 0) {
+        blitter->glBindBuffer(GL_ARRAY_BUFFER, blitter->overlay_vbo);
+        blitter->glBufferSubData(GL_ARRAY_BUFFER, 0, blitter->num_overlay_quads * sizeof(quads[0]), quads);
+    }
+
+    return was_visible || blitter->num_overlay_quads > 0;
+}
+
+/* Blends the layers over the frame just drawn. */
+void
+MALI_Blitter_DrawOverlays(MALI_Blitter *blitter)
+{
+    int i;
+
+    if (blitter->num_overlay_quads == 0)
+        return;
+
+    blitter->glEnable(GL_BLEND);
+    blitter->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    blitter->glUseProgram(blitter->overlay_prog);
+    blitter->glBindVertexArrayOES(blitter->overlay_vao);
+    for (i = 0; i < blitter->num_overlay_quads; i++) {
+        blitter->glBindTexture(GL_TEXTURE_2D, blitter->overlay_textures[i]);
+        blitter->glDrawArrays(GL_TRIANGLE_STRIP, i * 4, 4);
+    }
+    blitter->glDisable(GL_BLEND);
+
+    blitter->glUseProgram(blitter->scaler_prog);
+}
+
+#endif /* SDL_VIDEO_OPENGL_EGL */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,552 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_OPENGL_EGL
+
+#include "SDL.h"
+#include "SDL_egl.h"
+#include "SDL_opengl.h"
+
+#include "SDL_malivideo.h"
+#include "SDL_maliblitter.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+/*
+ * The first window is the one the blitter scales onto the screen. Windows
+ * created after it are stacked over it, each with buffers of its own, and
+ * composited in the same pass as quads at their position in display
+ * coordinates, 1:1 and upright, following SDL_RaiseWindow for their order,
+ * SDL_ShowWindow/SDL_HideWindow for their visibility and
+ * SDL_SetWindowOpacity for blending. When the first window goes away, the
+ * lowest stacked one takes its place from its next frame on.
+ *
+ * Their frames go through the same mailbox as the first window's, and are
+ * picked up with every pass of the blitter: with latching, a frame still
+ * rendering waits for the next vblank, otherwise the blitter waits for it.
+ * The stack itself is only changed by the application under stack_lock,
+ * except for the removal of a window, which the blitter thread does itself
+ * on release so that it never looks at a window that's gone.
+ */
+
+static const GLchar *stack_vert =
+"#version 100\n"
+"varying vec2 vTexCoord;\n"
+"attribute vec2 aVertCoord;\n"
+"attribute vec2 aTexCoord;\n"
+"uniform mat4 uProj;\n"
+"void main() {\n"
+"   vTexCoord = aTexCoord;\n"
+"   gl_Position = uProj * vec4(aVertCoord, 0.0, 1.0);\n"
+"}";
+
+/* Window buffers carry no meaningful alpha, the window opacity stands in */
+static const GLchar *stack_frag =
+"#version 100\n"
+"precision mediump float;\n"
+"varying vec2 vTexCoord;\n"
+"uniform sampler2D uFBOTex;\n"
+"uniform float uOpacity;\n"
+"void main() {\n"
+"   gl_FragColor = vec4(texture2D(uFBOTex, vTexCoord).rgb, uOpacity);\n"
+"}\n";
+
+/* Copies the stack out, the windows in there stay valid on the blitter thread. */
+static int
+MALI_Stack_Get(MALI_Blitter *blitter, MALI_BlitterStacked *stack)
+{
+    int count;
+
+    SDL_AtomicLock(&blitter->stack_lock);
+    count = blitter->stack_size;
+    SDL_memcpy(stack, blitter->stack, count * sizeof(*stack));
+    SDL_AtomicUnlock(&blitter->stack_lock);
+
+    return count;
+}
+
+static int
+MALI_Stack_Find(MALI_Blitter *blitter, SDL_Window *window)
+{
+    int i;
+
+    for (i = 0; i < blitter->stack_size; i++) {
+        if (blitter->stack[i].window == window)
+            return i;
+    }
+    return -1;
+}
+
+/* Imports the buffers of a set, without the chain and the quad of the first window. */
+static void
+MALI_Stack_BindSet(_THIS, MALI_Blitter *blitter, SDL_WindowData *windata, int set)
+{
+    MALI_EGL_Surface *surfaces = &windata->surface[MALI_SET_FIRST(set)];
+    int i;
+
+    for (i = 0; i < windata->num_buffers; i++) {
+        MALI_Blitter_GetTexture(_this, blitter, &surfaces[i]);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    windata->stack_set = set;
+
+    /* Caught up with the render thread, it can free the set it left behind. */
+    if (SDL_AtomicGet(&windata->resize_state) == MALI_RESIZE_SWITCHED && windata->buffer_set == set)
+        SDL_AtomicSet(&windata->resize_state, MALI_RESIZE_RETIRED);
+}
+
+static void
+MALI_Stack_UnbindSet(MALI_Blitter *blitter, SDL_WindowData *windata)
+{
+    MALI_EGL_Surface *surfaces;
+    int i;
+
+    if (windata->stack_set < 0)
+        return;
+
+    surfaces = &windata->surface[MALI_SET_FIRST(windata->stack_set)];
+    blitter->glBindTexture(GL_TEXTURE_2D, 0);
+    for (i = 0; i < windata->num_buffers; i++) {
+        blitter->glDeleteTextures(1, &surfaces[i].texture);
+        blitter->eglDestroyImageKHR(blitter->egl_display, surfaces[i].egl_image);
+        surfaces[i].texture = 0;
+        surfaces[i].egl_image = EGL_NO_IMAGE_KHR;
+    }
+    windata->stack_set = -1;
+}
+
+/*
+ * Waits for a stacked window's frame to finish rendering, or with wait unset
+ * only checks on it, putting it back into the mailbox when it's not done.
+ * Like the first window's, a sync file is waited on together with the
+ * blitter's wakeups: any of them ends the wait, so neither a thread stop nor
+ * the first window's next frame is held up by a slow stacked one. Without a
+ * sync file, the wait blocks in EGL. Returns whether the frame can be shown.
+ */
+static SDL_bool
+MALI_Stack_WaitFrame(MALI_Blitter *blitter, SDL_WindowData *windata, int page, SDL_bool wait)
+{
+    MALI_EGL_Surface *surface = &windata->surface[page & MALI_BUFFER_INDEX_MASK];
+    struct pollfd pfd[2] = { { surface->fence_fd, POLLIN, 0 }, { blitter->event_fd, POLLIN, 0 } };
+    eventfd_t value;
+    int ready;
+
+    if (MALI_Blitter_FrameReady(blitter, surface))
+        return SDL_TRUE;
+
+    if (wait && surface->fence_fd < 0) {
+        if (!blitter->eglClientWaitSyncKHR(blitter->egl_display, surface->egl_fence, 0, EGL_FOREVER_NV))
+            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "Sync %p failed.", surface->egl_fence);
+        return SDL_TRUE;
+    }
+
+    if (wait) {
+        while ((ready = poll(pfd, 2, -1)) < 0 && errno == EINTR) {
+        }
+
+        /* Signaled, an error wouldn't go away by waiting either */
+        if (ready < 0 || pfd[0].revents != 0)
+            return SDL_TRUE;
+
+        /* The thread loop checks on everything before sleeping again, only a stop is left pending for it */
+        eventfd_read(blitter->event_fd, &value);
+        if (SDL_AtomicGet(&blitter->thread_stop) != 0)
+            MALI_BlitterWake(blitter);
+    }
+
+    if (!SDL_AtomicCAS(&windata->queued_buffer, MALI_BUFFER_EMPTY, page)) {
+        /* Replaced by a newer frame meanwhile, which is looked at next time */
+        SDL_AtomicIncRef(&windata->stats.dropped);
+        MALI_CarryDamage(windata, page & MALI_BUFFER_INDEX_MASK, -1);
+        MALI_ReleaseBuffer(windata, page & MALI_BUFFER_INDEX_MASK);
+    }
+    return SDL_FALSE;
+}
+
+/* Makes the front buffer of a stacked window the one it shows. */
+static void
+MALI_Stack_TakeFrame(_THIS, MALI_Blitter *blitter, SDL_WindowData *windata, int page)
+{
+    MALI_EGL_Surface *surface;
+
+    /* A frame from another set means the window was resized, the old set is freed as a whole */
+    if (MALI_BUFFER_SET(windata->front_buffer) == MALI_BUFFER_SET(page))
+        MALI_ReleaseBuffer(windata, windata->front_buffer);
+    windata->front_buffer = page;
+    windata->stack_shown = SDL_TRUE;
+    windata->stack_fresh = SDL_TRUE;
+
+    if (MALI_BUFFER_SET(page) != windata->stack_set) {
+        MALI_Stack_UnbindSet(blitter, windata);
+        MALI_Stack_BindSet(_this, blitter, windata, MALI_BUFFER_SET(page));
+    }
+
+    surface = &windata->surface[page];
+    if (surface->egl_fence != EGL_NO_SYNC) {
+        /* Same Mali bug as with the first window's fences */
+        blitter->eglDestroySyncKHR(blitter->egl_display, surface->egl_fence);
+        surface->egl_fence = EGL_NO_SYNC;
+    }
+    if (surface->fence_fd >= 0) {
+        close(surface->fence_fd);
+        surface->fence_fd = -1;
+    }
+    surface->timing.signaled = SDL_GetPerformanceCounter();
+#if SDL_VIDEO_DRIVER_MALI_SIM
+    MALI_Sim_UploadTexture(blitter, surface);
+#endif
+}
+
+/*
+ * Puts a window on top of the stack, hidden until it's placed. Returns
+ * SDL_FALSE when the stack is full. Called by the application with the
+ * blitter mutex held.
+ */
+SDL_bool
+MALI_Blitter_StackWindow(MALI_Blitter *blitter, SDL_Window *window)
+{
+    SDL_WindowData *windata = (SDL_WindowData *)window->driverdata;
+    MALI_BlitterStacked *stacked;
+
+    windata->stack_set = -1;
+    windata->stack_shown = SDL_FALSE;
+    windata->stack_fresh = SDL_FALSE;
+
+    SDL_AtomicLock(&blitter->stack_lock);
+    if (blitter->stack_size == MALI_MAX_STACKED) {
+        SDL_AtomicUnlock(&blitter->stack_lock);
+        return SDL_FALSE;
+    }
+    stacked = &blitter->stack[blitter->stack_size++];
+    SDL_zerop(stacked);
+    stacked->window = window;
+    stacked->opacity = 1.0f;
+    SDL_AtomicUnlock(&blitter->stack_lock);
+
+    return SDL_TRUE;
+}
+
+/* Takes a window off the stack on its release, on the blitter thread. */
+void
+MALI_Blitter_UnstackWindow(MALI_Blitter *blitter, SDL_Window *window)
+{
+    int i;
+
+    SDL_AtomicLock(&blitter->stack_lock);
+    i = MALI_Stack_Find(blitter, window);
+    if (i >= 0) {
+        SDL_memmove(&blitter->stack[i], &blitter->stack[i + 1], (blitter->stack_size - i - 1) * sizeof(blitter->stack[0]));
+        blitter->stack_size--;
+    }
+    SDL_AtomicUnlock(&blitter->stack_lock);
+
+    if (i < 0)
+        return;
+
+    /* Without a context, the textures went with it */
+    if (blitter->was_initialized)
+        MALI_Stack_UnbindSet(blitter, (SDL_WindowData *)window->driverdata);
+    SDL_AtomicSet(&blitter->stack_changed, 1);
+}
+
+/* Takes the lowest window off the stack to replace the first one, once the context is gone. */
+SDL_Window *
+MALI_Blitter_PopStack(MALI_Blitter *blitter)
+{
+    SDL_Window *window = NULL;
+
+    SDL_AtomicLock(&blitter->stack_lock);
+    if (blitter->stack_size > 0) {
+        window = blitter->stack[0].window;
+        SDL_memmove(&blitter->stack[0], &blitter->stack[1], (blitter->stack_size - 1) * sizeof(blitter->stack[0]));
+        blitter->stack_size--;
+    }
+    SDL_AtomicUnlock(&blitter->stack_lock);
+
+    return window;
+}
+
+/* Updates where and how a stacked window shows, rect in display coordinates. */
+void
+MALI_Blitter_PlaceWindow(MALI_Blitter *blitter, SDL_Window *window, const SDL_Rect *rect, SDL_bool visible, float opacity)
+{
+    MALI_BlitterStacked *stacked;
+    int i;
+
+    SDL_AtomicLock(&blitter->stack_lock);
+    i = MALI_Stack_Find(blitter, window);
+    if (i >= 0) {
+        stacked = &blitter->stack[i];
+        stacked->rect = *rect;
+        stacked->visible = visible;
+        stacked->opacity = SDL_clamp(opacity, 0.0f, 1.0f);
+    }
+    SDL_AtomicUnlock(&blitter->stack_lock);
+
+    /* The cursor moves along with the window it's over */
+    if (i >= 0) {
+        SDL_AtomicSet(&blitter->stack_changed, 1);
+        SDL_AtomicSet(&blitter->overlay_changed, 1);
+        MALI_BlitterWake(blitter);
+    }
+}
+
+/* Moves a stacked window to the top, the first window always stays below the others. */
+void
+MALI_Blitter_RaiseWindow(MALI_Blitter *blitter, SDL_Window *window)
+{
+    MALI_BlitterStacked stacked;
+    int i;
+
+    SDL_AtomicLock(&blitter->stack_lock);
+    i = MALI_Stack_Find(blitter, window);
+    if (i >= 0 && i < blitter->stack_size - 1) {
+        stacked = blitter->stack[i];
+        SDL_memmove(&blitter->stack[i], &blitter->stack[i + 1], (blitter->stack_size - i - 1) * sizeof(blitter->stack[0]));
+        blitter->stack[blitter->stack_size - 1] = stacked;
+    } else {
+        i = -1;
+    }
+    SDL_AtomicUnlock(&blitter->stack_lock);
+
+    if (i >= 0) {
+        SDL_AtomicSet(&blitter->stack_changed, 1);
+        MALI_BlitterWake(blitter);
+    }
+}
+
+/* The window shown on top of the others, NULL when there's none. */
+SDL_Window *
+MALI_Blitter_GetTopWindow(MALI_Blitter *blitter)
+{
+    SDL_Window *window;
+
+    SDL_LockMutex(blitter->mutex);
+    SDL_AtomicLock(&blitter->stack_lock);
+    window = (blitter->stack_size > 0) ? blitter->stack[blitter->stack_size - 1].window : blitter->window;
+    SDL_AtomicUnlock(&blitter->stack_lock);
+    SDL_UnlockMutex(blitter->mutex);
+
+    return window;
+}
+
+/* Where a stacked window shows, returns SDL_FALSE when it isn't stacked. */
+SDL_bool
+MALI_Blitter_GetStackedRect(MALI_Blitter *blitter, SDL_Window *window, SDL_Rect *rect)
+{
+    int i;
+
+    SDL_AtomicLock(&blitter->stack_lock);
+    i = MALI_Stack_Find(blitter, window);
+    if (i >= 0)
+        *rect = blitter->stack[i].rect;
+    SDL_AtomicUnlock(&blitter->stack_lock);
+
+    return i >= 0;
+}
+
+void
+MALI_Blitter_InitStack(MALI_Blitter *blitter)
+{
+    blitter->stack_prog = MALI_Blitter_BuildProgram(blitter, stack_vert, stack_frag);
+    blitter->glUseProgram(blitter->stack_prog);
+    blitter->glUniform1i(blitter->glGetUniformLocation(blitter->stack_prog, "uFBOTex"), 0);
+    blitter->glUniformMatrix4fv(blitter->glGetUniformLocation(blitter->stack_prog, "uProj"), 1, 0, (GLfloat*)blitter->mat_projection);
+    blitter->loc_stack_opacity = blitter->glGetUniformLocation(blitter->stack_prog, "uOpacity");
+
+    blitter->glGenBuffers(1, &blitter->stack_vbo);
+    blitter->glGenVertexArraysOES(1, &blitter->stack_vao);
+    blitter->glBindVertexArrayOES(blitter->stack_vao);
+    blitter->glBindBuffer(GL_ARRAY_BUFFER, blitter->stack_vbo);
+    blitter->glEnableVertexAttribArray(MALI_ATTRIB_VERTCOORD);
+    blitter->glEnableVertexAttribArray(MALI_ATTRIB_TEXCOORD);
+    blitter->glVertexAttribPointer(MALI_ATTRIB_VERTCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(0 * sizeof(float)));
+    blitter->glVertexAttribPointer(MALI_ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    blitter->glBufferData(GL_ARRAY_BUFFER, MALI_MAX_STACKED * sizeof(blitter->vert_buffer_data), NULL, GL_DYNAMIC_DRAW);
+    blitter->glBindVertexArrayOES(0);
+
+    /* Stacked windows import their buffers again with their next pass */
+    blitter->num_stack_quads = 0;
+    SDL_AtomicSet(&blitter->stack_changed, 1);
+}
+
+void
+MALI_Blitter_DeinitStack(MALI_Blitter *blitter)
+{
+    MALI_BlitterStacked stack[MALI_MAX_STACKED];
+    int count, i;
+
+    count = MALI_Stack_Get(blitter, stack);
+    for (i = 0; i < count; i++) {
+        MALI_Stack_UnbindSet(blitter, (SDL_WindowData *)stack[i].window->driverdata);
+    }
+
+    if (blitter->stack_vao) {
+        blitter->glDeleteVertexArraysOES(1, &blitter->stack_vao);
+        blitter->glDeleteBuffers(1, &blitter->stack_vbo);
+        blitter->stack_vao = blitter->stack_vbo = 0;
+    }
+    if (blitter->stack_prog)
+        blitter->glDeleteProgram(blitter->stack_prog);
+    blitter->stack_prog = 0;
+    blitter->num_stack_quads = 0;
+}
+
+/* Whether a stacked window has something new to show. */
+SDL_bool
+MALI_Blitter_StackPending(MALI_Blitter *blitter)
+{
+    MALI_BlitterStacked stack[MALI_MAX_STACKED];
+    SDL_WindowData *windata;
+    int count, i;
+
+    if (SDL_AtomicGet(&blitter->stack_changed))
+        return SDL_TRUE;
+
+    count = MALI_Stack_Get(blitter, stack);
+    for (i = 0; i < count; i++) {
+        windata = (SDL_WindowData *)stack[i].window->driverdata;
+        if (SDL_AtomicGet(&windata->queued_buffer) & MALI_BUFFER_FRESH)
+            return SDL_TRUE;
+    }
+    return SDL_FALSE;
+}
+
+/*
+ * Takes the newest frames of the stacked windows and rebuilds their quads,
+ * returns whether anything changed on screen. Without wait, frames still
+ * rendering are left for the next pass.
+ */
+SDL_bool
+MALI_Blitter_UpdateStack(_THIS, MALI_Blitter *blitter, SDL_bool wait)
+{
+    MALI_BlitterStacked stack[MALI_MAX_STACKED];
+    GLfloat quads[MALI_MAX_STACKED][4][4];
+    SDL_WindowData *windata;
+    SDL_bool changed, was_visible;
+    int count, page, i;
+
+    changed = (SDL_AtomicSet(&blitter->stack_changed, 0) != 0);
+    count = MALI_Stack_Get(blitter, stack);
+
+    for (i = 0; i < count; i++) {
+        windata = (SDL_WindowData *)stack[i].window->driverdata;
+        page = SDL_AtomicSet(&windata->queued_buffer, MALI_BUFFER_EMPTY);
+        if ((page & MALI_BUFFER_FRESH) == 0 || !MALI_Stack_WaitFrame(blitter, windata, page, wait))
+            continue;
+
+        MALI_Stack_TakeFrame(_this, blitter, windata, page & MALI_BUFFER_INDEX_MASK);
+        changed = SDL_TRUE;
+    }
+
+    if (!changed)
+        return SDL_FALSE;
+
+    was_visible = (blitter->num_stack_quads > 0);
+    blitter->num_stack_quads = 0;
+
+    for (i = 0; i < count; i++) {
+        windata = (SDL_WindowData *)stack[i].window->driverdata;
+        if (!stack[i].visible || stack[i].opacity <= 0.0f || SDL_RectEmpty(&stack[i].rect) || !windata->stack_shown)
+            continue;
+
+        /* Shown before the context was reset, import it again */
+        if (windata->stack_set < 0) {
+            MALI_Stack_BindSet(_this, blitter, windata, MALI_BUFFER_SET(windata->front_buffer));
+#if SDL_VIDEO_DRIVER_MALI_SIM
+            MALI_Sim_UploadTexture(blitter, &windata->surface[windata->front_buffer]);
+#endif
+        }
+
+        MALI_Blitter_MakeQuad(blitter, &stack[i].rect, quads[blitter->num_stack_quads]);
+        blitter->stack_textures[blitter->num_stack_quads] = windata->surface[windata->front_buffer].texture;
+        blitter->stack_opacity[blitter->num_stack_quads++] = stack[i].opacity;
+    }
+
+    if (blitter->num_stack_quads > 0) {
+        blitter->glBindBuffer(GL_ARRAY_BUFFER, blitter->stack_vbo);
+        blitter->glBufferSubData(GL_ARRAY_BUFFER, 0, blitter->num_stack_quads * sizeof(quads[0]), quads);
+    }
+
+    return was_visible || blitter->num_stack_quads > 0;
+}
+
+/* Draws the stacked windows over the first one, bottom first. */
+void
+MALI_Blitter_DrawStack(MALI_Blitter *blitter)
+{
+    int i;
+
+    if (blitter->num_stack_quads == 0)
+        return;
+
+    blitter->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    blitter->glUseProgram(blitter->stack_prog);
+    blitter->glBindVertexArrayOES(blitter->stack_vao);
+    for (i = 0; i < blitter->num_stack_quads; i++) {
+        /* Opaque windows skip the blending */
+        if (blitter->stack_opacity[i] < 1.0f)
+            blitter->glEnable(GL_BLEND);
+        else
+            blitter->glDisable(GL_BLEND);
+
+        blitter->glUniform1f(blitter->loc_stack_opacity, blitter->stack_opacity[i]);
+        blitter->glBindTexture(GL_TEXTURE_2D, blitter->stack_textures[i]);
+        blitter->glDrawArrays(GL_TRIANGLE_STRIP, i * 4, 4);
+    }
+    blitter->glDisable(GL_BLEND);
+
+    blitter->glUseProgram(blitter->scaler_prog);
+}
+
+/* Accounts for the frames of stacked windows presented in the last pass. */
+void
+MALI_Blitter_FinishStack(MALI_Blitter *blitter, Uint64 blit, Uint64 present)
+{
+    MALI_BlitterStacked stack[MALI_MAX_STACKED];
+    SDL_WindowData *windata;
+    MALI_EGL_Surface *surface;
+    int count, i;
+
+    count = MALI_Stack_Get(blitter, stack);
+    for (i = 0; i < count; i++) {
+        windata = (SDL_WindowData *)stack[i].window->driverdata;
+        if (!windata->stack_fresh)
+            continue;
+
+        windata->stack_fresh = SDL_FALSE;
+        surface = &windata->surface[windata->front_buffer];
+        surface->timing.blit = blit;
+        surface->timing.present = present;
+        SDL_AtomicIncRef(&windata->stats.presented);
+        MALI_StatsRecord(&windata->stats, &surface->timing);
+    }
+}
+
+#endif /* SDL_VIDEO_OPENGL_EGL */
+
+/* vi: set ts=4 sw=4 expandtab: */
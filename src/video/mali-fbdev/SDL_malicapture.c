@@ -0,0 +1,392 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_log.h"
+#include "SDL_system.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <linux/dma-buf.h>
+
+#include "SDL_malivideo.h"
+#include "SDL_malicapture.h"
+
+/*
+ * Capturing taps the frames right after the blitter presented them. All the
+ * blitter does is pin the front buffer and hand a duplicate of its dma-buf to
+ * the writer thread, which copies it out through a mapping of its own. When
+ * the blitter moves on while the copy is still running, the buffer is released
+ * by the writer once it's done instead. The blitter never waits for the
+ * writer: frames presented while it's busy copying or writing aren't captured.
+ *
+ * Y4M streams are 4:2:0 with full range BT.601 colors, at the refresh rate of
+ * the display however many frames were dropped, and keep the size of their
+ * first frame: frames of another size are dropped. Raw streams are the frames
+ * back to back, tightly packed, in the pixel format of the window buffers
+ * (BGRA or RGB565, in memory order).
+ */
+
+static SDL_bool
+MALI_Capture_Write(int fd, const void *data, size_t size)
+{
+    const Uint8 *p = (const Uint8 *)data;
+    ssize_t written;
+
+    while (size > 0) {
+        written = write(fd, p, size);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return SDL_FALSE;
+        }
+        p += written;
+        size -= written;
+    }
+    return SDL_TRUE;
+}
+
+static void
+MALI_Capture_Sync(int fd, __u64 flags)
+{
+    struct dma_buf_sync sync = { .flags = flags };
+
+    while (ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync) < 0 && (errno == EINTR || errno == EAGAIN)) {
+    }
+}
+
+/* Copies the pinned frame to the staging buffer, tightly packed. */
+static SDL_bool
+MALI_Capture_Copy(MALI_Capture *capture)
+{
+    const int row = capture->width * capture->bpp;
+    const size_t size = (size_t)row * capture->height;
+    const Uint8 *src;
+    Uint8 *dst;
+    void *map;
+    int y;
+
+    if (size > capture->staging_size) {
+        dst = (Uint8 *)SDL_realloc(capture->staging, size);
+        if (!dst)
+            return SDL_FALSE;
+        capture->staging = dst;
+        capture->staging_size = size;
+    }
+
+    map = mmap(NULL, capture->frame_size, PROT_READ, MAP_SHARED, capture->frame_fd, 0);
+    if (map == MAP_FAILED)
+        return SDL_FALSE;
+
+    /* The buffers are cached, the GPU's writes must be visible to the CPU */
+    MALI_Capture_Sync(capture->frame_fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+    src = (const Uint8 *)map;
+    dst = capture->staging;
+    for (y = 0; y < capture->height; y++) {
+        SDL_memcpy(dst, src, row);
+        src += capture->pitch;
+        dst += row;
+    }
+    MALI_Capture_Sync(capture->frame_fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+
+    munmap(map, capture->frame_size);
+    return SDL_TRUE;
+}
+
+static SDL_INLINE void
+MALI_Capture_Unpack(const Uint8 *p, int bpp, int *r, int *g, int *b)
+{
+    Uint16 v;
+
+    if (bpp == 4) {
+        *b = p[0];
+        *g = p[1];
+        *r = p[2];
+    } else {
+        v = *(const Uint16 *)p;
+        *r = ((v >> 8) & 0xF8) | (v >> 13);
+        *g = ((v >> 3) & 0xFC) | ((v >> 9) & 0x03);
+        *b = ((v << 3) & 0xF8) | ((v >> 2) & 0x07);
+    }
+}
+
+/* Converts the staging buffer to planar 4:2:0, chroma averaged over each 2x2 block. */
+static void
+MALI_Capture_ConvertYUV(const Uint8 *src, Uint8 *dst, int w, int h, int bpp)
+{
+    const int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    Uint8 *py = dst, *pu = dst + w * h, *pv = pu + cw * ch;
+    int x, y, i, j, xx, yy, r, g, b, sr, sg, sb;
+
+    for (y = 0; y < h; y += 2) {
+        for (x = 0; x < w; x += 2) {
+            sr = sg = sb = 0;
+            for (j = 0; j < 2; j++) {
+                yy = SDL_min(y + j, h - 1);
+                for (i = 0; i < 2; i++) {
+                    xx = SDL_min(x + i, w - 1);
+                    MALI_Capture_Unpack(src + ((size_t)yy * w + xx) * bpp, bpp, &r, &g, &b);
+                    py[yy * w + xx] = (77 * r + 150 * g + 29 * b + 128) >> 8;
+                    sr += r;
+                    sg += g;
+                    sb += b;
+                }
+            }
+
+            /* Biased so the sums stay positive, they carry two extra bits from the 4 samples */
+            pu[(y / 2) * cw + x / 2] = SDL_min((-43 * sr - 85 * sg + 128 * sb + (128 << 10) + 512) >> 10, 255);
+            pv[(y / 2) * cw + x / 2] = SDL_min((128 * sr - 107 * sg - 21 * sb + (128 << 10) + 512) >> 10, 255);
+        }
+    }
+}
+
+static SDL_bool
+MALI_Capture_Output(MALI_Capture *capture, int w, int h, int bpp)
+{
+    const size_t size = (size_t)w * h + 2 * (size_t)((w + 1) / 2) * ((h + 1) / 2);
+    char header[128];
+
+    if (!capture->y4m)
+        return MALI_Capture_Write(capture->fd, capture->staging, (size_t)w * h * bpp);
+
+    if (capture->stream_w == 0) {
+        capture->yuv = (Uint8 *)SDL_malloc(size);
+        if (!capture->yuv)
+            return SDL_FALSE;
+
+        SDL_snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1000 Ip A1:1 C420jpeg\n",
+                     w, h, capture->fps_mhz);
+        if (!MALI_Capture_Write(capture->fd, header, SDL_strlen(header)))
+            return SDL_FALSE;
+        capture->stream_w = w;
+        capture->stream_h = h;
+    } else if (w != capture->stream_w || h != capture->stream_h) {
+        SDL_AtomicIncRef(&capture->dropped);
+        return SDL_TRUE;
+    }
+
+    MALI_Capture_ConvertYUV(capture->staging, capture->yuv, w, h, bpp);
+    return MALI_Capture_Write(capture->fd, "FRAME\n", 6) && MALI_Capture_Write(capture->fd, capture->yuv, size);
+}
+
+static int SDLCALL
+MALI_CaptureThread(void *data)
+{
+    MALI_Capture *capture = (MALI_Capture *)data;
+    SDL_bool copied, failed = SDL_FALSE;
+    int pinned, w, h, bpp;
+    sigset_t set;
+
+    /* A pipe closed on the other end fails the write instead of killing the process */
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    for (;;) {
+        SDL_SemWait(capture->sem);
+
+        if (SDL_AtomicGet(&capture->pinned) != 0) {
+            /* The blitter fills these in again as soon as the frame is unpinned */
+            copied = !failed && MALI_Capture_Copy(capture);
+            w = capture->width;
+            h = capture->height;
+            bpp = capture->bpp;
+            close(capture->frame_fd);
+            capture->frame_fd = -1;
+
+            pinned = SDL_AtomicSet(&capture->pinned, 0);
+            if (pinned & MALI_CAPTURE_DEFERRED)
+                MALI_ReleaseBuffer(capture->windata, (pinned & MALI_BUFFER_INDEX_MASK) - 1);
+
+            if (!copied) {
+                SDL_AtomicIncRef(&capture->dropped);
+            } else if (MALI_Capture_Output(capture, w, h, bpp)) {
+                SDL_AtomicIncRef(&capture->captured);
+            } else {
+                /* Keep unpinning frames until the capture is stopped */
+                SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "MALI_CaptureThread: Writing frame failed: %s", strerror(errno));
+                failed = SDL_TRUE;
+            }
+        }
+
+        if (SDL_AtomicGet(&capture->quit))
+            break;
+    }
+
+    return 0;
+}
+
+static void
+MALI_Capture_Free(MALI_Capture *capture)
+{
+    if (capture->fd >= 0)
+        close(capture->fd);
+    if (capture->sem)
+        SDL_DestroySemaphore(capture->sem);
+    SDL_free(capture->staging);
+    SDL_free(capture->yuv);
+    SDL_free(capture);
+}
+
+int
+MALI_CaptureStart(SDL_WindowData *windata, const char *path)
+{
+    SDL_DisplayData *displaydata = SDL_GetDisplayDriverData(0);
+    const size_t len = SDL_strlen(path);
+    MALI_Capture *capture;
+
+    capture = (MALI_Capture *)SDL_calloc(1, sizeof(MALI_Capture));
+    if (!capture)
+        return SDL_OutOfMemory();
+
+    capture->windata = windata;
+    capture->frame_fd = -1;
+    capture->y4m = (len >= 4 && SDL_strcasecmp(path + len - 4, ".y4m") == 0);
+    capture->fps_mhz = displaydata->refresh_mhz ? displaydata->refresh_mhz : 60000;
+
+    /* Waits for a reader when it's a named pipe */
+    capture->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (capture->fd < 0) {
+        SDL_SetError("mali-fbdev: Can't open %s: %s", path, strerror(errno));
+        MALI_Capture_Free(capture);
+        return -1;
+    }
+
+    capture->sem = SDL_CreateSemaphore(0);
+    if (!capture->sem) {
+        MALI_Capture_Free(capture);
+        return -1;
+    }
+
+    capture->thread = SDL_CreateThread(MALI_CaptureThread, "MALI_CaptureThread", capture);
+    if (!capture->thread) {
+        MALI_Capture_Free(capture);
+        return -1;
+    }
+
+    MALI_CaptureStop(windata);
+    SDL_AtomicLock(&windata->capture_lock);
+    windata->capture = capture;
+    SDL_AtomicUnlock(&windata->capture_lock);
+    return 0;
+}
+
+void
+MALI_CaptureStop(SDL_WindowData *windata)
+{
+    MALI_Capture *capture;
+
+    SDL_AtomicLock(&windata->capture_lock);
+    capture = windata->capture;
+    windata->capture = NULL;
+    SDL_AtomicUnlock(&windata->capture_lock);
+
+    if (!capture)
+        return;
+
+    /* The writer finishes a frame it was handed before quitting */
+    SDL_AtomicSet(&capture->quit, 1);
+    SDL_SemPost(capture->sem);
+    SDL_WaitThread(capture->thread, NULL);
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "MALI_CaptureStop: %d frames captured, %d dropped.",
+        SDL_AtomicGet(&capture->captured), SDL_AtomicGet(&capture->dropped));
+    MALI_Capture_Free(capture);
+}
+
+/* Hands the buffer the blitter just presented to the writer, unless it's busy. */
+void
+MALI_CaptureFrame(SDL_WindowData *windata, int buffer)
+{
+    MALI_EGL_Surface *surf = &windata->surface[buffer];
+    MALI_Capture *capture;
+
+    SDL_AtomicLock(&windata->capture_lock);
+    capture = windata->capture;
+    if (capture) {
+        if (SDL_AtomicGet(&capture->pinned) != 0 || surf->dmabuf_fd < 0) {
+            SDL_AtomicIncRef(&capture->dropped);
+        } else if ((capture->frame_fd = fcntl(surf->dmabuf_fd, F_DUPFD_CLOEXEC, 0)) < 0) {
+            SDL_AtomicIncRef(&capture->dropped);
+        } else {
+            capture->frame_size = surf->pixmap.planes[0].size;
+            capture->width = surf->pixmap.width;
+            capture->height = surf->pixmap.height;
+            capture->pitch = surf->pixmap.planes[0].stride;
+            capture->bpp = windata->bytes_per_pixel;
+            SDL_AtomicSet(&capture->pinned, buffer + 1);
+            SDL_SemPost(capture->sem);
+        }
+    }
+    SDL_AtomicUnlock(&windata->capture_lock);
+}
+
+/* Instead of releasing a buffer still being copied, leaves it to the writer. */
+SDL_bool
+MALI_CaptureHold(SDL_WindowData *windata, int buffer)
+{
+    SDL_bool held = SDL_FALSE;
+
+    SDL_AtomicLock(&windata->capture_lock);
+    if (windata->capture)
+        held = SDL_AtomicCAS(&windata->capture->pinned, buffer + 1, (buffer + 1) | MALI_CAPTURE_DEFERRED);
+    SDL_AtomicUnlock(&windata->capture_lock);
+    return held;
+}
+
+int
+SDL_MaliStartCapture(SDL_Window *window, const char *path)
+{
+    SDL_WindowData *windata = MALI_GetWindowData(window);
+
+    if (!windata) {
+        return -1;
+    }
+    if (!((SDL_DisplayData *)SDL_GetDisplayDriverData(0))->blitter) {
+        return SDL_SetError("mali-fbdev: Capturing needs the blitter");
+    }
+    if (!path) {
+        return SDL_InvalidParamError("path");
+    }
+
+    return MALI_CaptureStart(windata, path);
+}
+
+int
+SDL_MaliStopCapture(SDL_Window *window)
+{
+    SDL_WindowData *windata = MALI_GetWindowData(window);
+
+    if (!windata) {
+        return -1;
+    }
+
+    MALI_CaptureStop(windata);
+    return 0;
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,70 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malicapture_h
+#define _SDL_malicapture_h
+
+#include "SDL_atomic.h"
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+
+struct SDL_WindowData;
+struct MALI_EGL_Surface;
+
+/* Buffer the writer is copying, tagged once the blitter let go of it */
+#define MALI_CAPTURE_DEFERRED 0x100
+
+/* Frames presented on a window written to a file or pipe, see SDL_MaliStartCapture. */
+typedef struct MALI_Capture
+{
+    struct SDL_WindowData *windata;
+    int fd;
+    SDL_bool y4m;
+    SDL_Thread *thread;
+    SDL_sem *sem;
+    SDL_atomic_t quit;
+
+    /* The frame handed to the writer, index + 1 or 0 when it's idle */
+    SDL_atomic_t pinned;
+    int frame_fd;               /* dup of the buffer's dma-buf */
+    size_t frame_size;
+    int width, height, pitch, bpp;
+
+    /* Owned by the writer thread */
+    Uint8 *staging;
+    size_t staging_size;
+    Uint8 *yuv;
+    int stream_w, stream_h;     /* size in the Y4M header */
+    int fps_mhz;
+
+    SDL_atomic_t captured;
+    SDL_atomic_t dropped;
+} MALI_Capture;
+
+extern int MALI_CaptureStart(struct SDL_WindowData *windata, const char *path);
+extern void MALI_CaptureStop(struct SDL_WindowData *windata);
+extern void MALI_CaptureFrame(struct SDL_WindowData *windata, int buffer);
+extern SDL_bool MALI_CaptureHold(struct SDL_WindowData *windata, int buffer);
+
+#endif /* _SDL_malicapture_h */
+
+/* vi: set ts=4 sw=4 expandtab: */
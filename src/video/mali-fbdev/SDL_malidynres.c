@@ -0,0 +1,146 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_timer.h"
+
+#include "../SDL_sysvideo.h"
+#include "SDL_malivideo.h"
+#include "SDL_malidynres.h"
+
+/*
+ * Dynamic resolution: the window keeps its size, but the buffers the
+ * application renders into shrink when the GPU can't keep up with the
+ * display, and grow back once it has time to spare. The blitter scales them
+ * up to the screen like any other window size, and resizes happen in the
+ * background like regular ones.
+ *
+ * GPU time is measured from the later of submission and the previous frame
+ * finishing, up to the frame finishing. That's the signal time of its sync
+ * file, or without one, when the blitter saw a fence it was waiting on
+ * signal. Frames the blitter only got to after they were done, while it was
+ * busy presenting, give no sample, as their wait would include its own. With
+ * SDL_MALI_LATCH_MARGIN, fences are only looked at on the deadline, so frames
+ * missing it are what steps the size down instead.
+ */
+
+/* Frames to wait after a step, so the measurements reflect the new size */
+#define MALI_DYNRES_SETTLE 30
+
+void
+MALI_DynResRecord(MALI_DynamicResolution *dynres, const MALI_FrameTiming *timing)
+{
+    Uint64 start = SDL_max(timing->submit, dynres->last_completed);
+    int sample, average;
+
+    if (timing->completed == 0)
+        return;
+
+    dynres->last_completed = timing->completed;
+    if (timing->completed <= start)
+        return;
+
+    sample = (int)((timing->completed - start) * 1000000 / SDL_GetPerformanceFrequency());
+    average = SDL_AtomicGet(&dynres->gpu_time);
+    SDL_AtomicSet(&dynres->gpu_time, average + (sample - average) / 8);
+}
+
+/* Picks the render size for the frames to come, called from the render thread on every swap. */
+void
+MALI_DynResUpdate(SDL_Window *window, SDL_WindowData *windata)
+{
+    MALI_DynamicResolution *dynres = &windata->dynres;
+    SDL_DisplayData *displaydata = SDL_GetDisplayForWindow(window)->driverdata;
+    int missed, gpu_time, budget;
+    Uint64 interval;
+
+    if (!dynres->enabled || windata->framebuffer)
+        return;
+
+    missed = SDL_AtomicSet(&dynres->missed, 0);
+    if (dynres->settle > 0) {
+        dynres->settle--;
+        return;
+    }
+
+    MALI_VblankGet(&displaydata->vblank, NULL, &interval, NULL);
+    budget = (int)(interval * 1000000 / SDL_GetPerformanceFrequency());
+    gpu_time = SDL_AtomicGet(&dynres->gpu_time);
+
+    /* Step down quickly, but take longer to step back up to avoid oscillating */
+    if ((missed > 0 || gpu_time > budget * 9 / 10) && dynres->level > 0) {
+        dynres->level--;
+        dynres->settle = MALI_DYNRES_SETTLE;
+    } else if (missed == 0 && gpu_time < budget * 13 / 20 && dynres->level < MALI_DYNRES_LEVELS) {
+        dynres->level++;
+        dynres->settle = MALI_DYNRES_SETTLE * 4;
+    }
+}
+
+void
+MALI_GetRenderSize(SDL_Window *window, SDL_WindowData *windata, int *w, int *h)
+{
+    const MALI_DynamicResolution *dynres = &windata->dynres;
+    int min_w, min_h;
+
+    *w = window->w;
+    *h = window->h;
+    if (!dynres->enabled || windata->framebuffer || dynres->level >= MALI_DYNRES_LEVELS)
+        return;
+
+    min_w = SDL_min(dynres->min_w, window->w);
+    min_h = SDL_min(dynres->min_h, window->h);
+
+    /* Few, aligned sizes let the buffer pool hand the same allocations out again */
+    *w = SDL_min(MALI_ALIGN(min_w + (window->w - min_w) * dynres->level / MALI_DYNRES_LEVELS, 8), window->w);
+    *h = SDL_min(MALI_ALIGN(min_h + (window->h - min_h) * dynres->level / MALI_DYNRES_LEVELS, 8), window->h);
+}
+
+int
+SDL_MaliSetDynamicResolution(SDL_Window *window, int min_w, int min_h)
+{
+    SDL_WindowData *windata = MALI_GetWindowData(window);
+    MALI_DynamicResolution *dynres;
+
+    if (!windata) {
+        return -1;
+    }
+    if (!((SDL_DisplayData *)SDL_GetDisplayDriverData(0))->blitter) {
+        return SDL_SetError("mali-fbdev: Dynamic resolution needs the blitter");
+    }
+    if (min_w < 0 || min_h < 0) {
+        return SDL_InvalidParamError((min_w < 0) ? "min_w" : "min_h");
+    }
+
+    dynres = &windata->dynres;
+    dynres->enabled = (min_w > 0 && min_h > 0);
+    dynres->min_w = min_w;
+    dynres->min_h = min_h;
+    dynres->level = MALI_DYNRES_LEVELS;
+    dynres->settle = MALI_DYNRES_SETTLE;
+    return 0;
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,55 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malidynres_h
+#define _SDL_malidynres_h
+
+#include "SDL_atomic.h"
+#include "SDL_video.h"
+#include "SDL_malistats.h"
+
+struct SDL_WindowData;
+
+/* Steps between the smallest allowed render size and the window size */
+#define MALI_DYNRES_LEVELS 8
+
+/* Render size scaling state of a window, see SDL_MaliSetDynamicResolution. */
+typedef struct MALI_DynamicResolution
+{
+    SDL_bool enabled;
+    int min_w, min_h;
+    int level;              /* MALI_DYNRES_LEVELS renders at the window size */
+    int settle;             /* frames left before the next step */
+
+    /* Written by the blitter thread */
+    SDL_atomic_t gpu_time;  /* smoothed GPU time per frame, in microseconds */
+    SDL_atomic_t missed;    /* frames that weren't ready by their deadline */
+    Uint64 last_completed;
+} MALI_DynamicResolution;
+
+extern void MALI_DynResRecord(MALI_DynamicResolution *dynres, const MALI_FrameTiming *timing);
+extern void MALI_DynResUpdate(SDL_Window *window, struct SDL_WindowData *windata);
+extern void MALI_GetRenderSize(SDL_Window *window, struct SDL_WindowData *windata, int *w, int *h);
+
+#endif /* _SDL_malidynres_h */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,222 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_timer.h"
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <linux/dma-buf.h>
+
+#include "SDL_malivideo.h"
+#include "SDL_maliblitter.h"
+#include "SDL_maliframebuffer.h"
+
+/*
+ * The window framebuffer is handed out straight from the ION buffers backing
+ * the window pixmaps, so software rendered frames reach the blitter without
+ * a copy or a texture upload. Each update queues the current buffer just like
+ * a GL swap would and moves the window surface on to the next one.
+ *
+ * SDL_MALI_FRAMEBUFFER_PRESERVE: Set to "0" when the application redraws the
+ * whole window surface every frame. By default, the regions updated since a
+ * buffer was last drawn to are copied into it, so the surface keeps its
+ * contents across updates like on any other driver.
+ */
+
+void
+MALI_SyncBuffer(MALI_EGL_Surface *surf, __u64 flags)
+{
+    struct dma_buf_sync sync = { .flags = flags };
+
+    /* The buffers are cached, CPU access is bracketed so both sides see each other's writes. */
+    while (ioctl(surf->map_fd, DMA_BUF_IOCTL_SYNC, &sync) < 0 && (errno == EINTR || errno == EAGAIN)) {
+    }
+}
+
+static void
+MALI_Framebuffer_CopyRect(MALI_EGL_Surface *dst, const MALI_EGL_Surface *src, const SDL_Rect *rect, int bpp)
+{
+    const int pitch = dst->pixmap.planes[0].stride;
+    const size_t offset = (size_t)rect->y * pitch + rect->x * bpp;
+    const Uint8 *s = (const Uint8 *)src->map + offset;
+    Uint8 *d = (Uint8 *)dst->map + offset;
+    int y;
+
+    /* Only the CPU ever writes these, its view of the source is up to date. */
+    for (y = 0; y < rect->h; y++) {
+        SDL_memcpy(d, s, rect->w * bpp);
+        s += pitch;
+        d += pitch;
+    }
+}
+
+/* Maps the ION buffer behind a window buffer for the CPU, until MALI_UnmapWindowFramebuffer. */
+int
+MALI_MapBuffer(SDL_DisplayData *displaydata, MALI_EGL_Surface *surf)
+{
+    struct ion_fd_data map_data = {
+        .handle = surf->dmabuf_handle
+    };
+
+    if (MALI_DeviceIoctl(displaydata->ion_fd, ION_IOC_MAP, &map_data) != 0)
+        return SDL_SetError("mali-fbdev: Unable to map ION buffer");
+
+    surf->map = mmap(NULL, surf->pixmap.planes[0].size, PROT_READ | PROT_WRITE, MAP_SHARED, map_data.fd, 0);
+    if (surf->map == MAP_FAILED) {
+        surf->map = NULL;
+        close(map_data.fd);
+        return SDL_SetError("mali-fbdev: Unable to mmap ION buffer");
+    }
+
+    surf->map_fd = map_data.fd;
+    return 0;
+}
+
+void
+MALI_UnmapWindowFramebuffer(SDL_WindowData *windata)
+{
+    MALI_EGL_Surface *surf;
+    int i;
+
+    if (windata->framebuffer)
+        MALI_SyncBuffer(&windata->surface[windata->back_buffer], DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE);
+    windata->framebuffer = SDL_FALSE;
+
+    for (i = 0; i < (int)SDL_arraysize(windata->surface); i++) {
+        surf = &windata->surface[i];
+        if (!surf->map)
+            continue;
+
+        munmap(surf->map, surf->pixmap.planes[0].size);
+        close(surf->map_fd);
+        surf->map = NULL;
+        surf->map_fd = -1;
+    }
+}
+
+int
+MALI_CreateWindowFramebuffer(_THIS, SDL_Window *window, Uint32 *format, void **pixels, int *pitch)
+{
+    SDL_WindowData *windata = (SDL_WindowData *)window->driverdata;
+    SDL_DisplayData *displaydata = SDL_GetDisplayDriverData(0);
+    MALI_EGL_Surface *surf;
+    int i, first;
+
+    /* The surface is recreated on resize, switch over to buffers of the new size now. */
+    MALI_UnmapWindowFramebuffer(windata);
+    MALI_FinishResize(_this, window);
+
+    first = MALI_SET_FIRST(windata->buffer_set);
+    if (windata->surface[first].pixmap.width != window->w || windata->surface[first].pixmap.height != window->h)
+        return SDL_SetError("mali-fbdev: Window buffers weren't resized");
+
+    for (i = first; i < first + windata->num_buffers; i++) {
+        surf = &windata->surface[i];
+        if (surf->dmabuf_fd < 0) {
+            MALI_UnmapWindowFramebuffer(windata);
+            return SDL_SetError("mali-fbdev: Window has no backing ION buffers");
+        }
+
+        if (MALI_MapBuffer(displaydata, surf) < 0) {
+            MALI_UnmapWindowFramebuffer(windata);
+            return -1;
+        }
+
+        /* Start every buffer out blank, there's nothing stale in them. */
+        MALI_SyncBuffer(surf, DMA_BUF_SYNC_START | DMA_BUF_SYNC_WRITE);
+        SDL_memset(surf->map, 0, surf->pixmap.planes[0].size);
+        if (i != windata->back_buffer)
+            MALI_SyncBuffer(surf, DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE);
+        SDL_zero(surf->stale);
+    }
+
+    windata->framebuffer = SDL_TRUE;
+    windata->framebuffer_preserve = MALI_GetHintInt("SDL_MALI_FRAMEBUFFER_PRESERVE", 1) != 0;
+
+    surf = &windata->surface[windata->back_buffer];
+    *format = (windata->drm_format == DRM_FORMAT_RGB565) ? SDL_PIXELFORMAT_RGB565 : SDL_PIXELFORMAT_XRGB8888;
+    *pixels = surf->map;
+    *pitch = surf->pixmap.planes[0].stride;
+    return 0;
+}
+
+int
+MALI_UpdateWindowFramebuffer(_THIS, SDL_Window *window, const SDL_Rect *rects, int numrects)
+{
+    SDL_WindowData *windata = (SDL_WindowData *)window->driverdata;
+    SDL_Rect bounds = { 0, 0, window->w, window->h };
+    MALI_EGL_Surface *surf;
+    MALI_Damage damage;
+    int i, first, prev;
+
+    if (!windata->framebuffer || !window->surface)
+        return SDL_SetError("mali-fbdev: Window framebuffer is not mapped");
+
+    /* The blitter redraws a single region, keep their bounding box. */
+    damage.full = SDL_FALSE;
+    SDL_zero(damage.rect);
+    for (i = 0; i < numrects; i++)
+        SDL_UnionRect(&damage.rect, &rects[i], &damage.rect);
+
+    /* Nothing changed, the previous frame stays on screen. */
+    if (!SDL_IntersectRect(&damage.rect, &bounds, &damage.rect))
+        return 0;
+
+    /* CPU drawn frames have no fence, they're ready as soon as the caches are flushed. */
+    prev = windata->back_buffer;
+    surf = &windata->surface[prev];
+    surf->timing.submit = SDL_GetPerformanceCounter();
+    MALI_SyncBuffer(surf, DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE);
+    surf->timing.fence = SDL_GetPerformanceCounter();
+
+    /* Every other buffer is now missing this update. */
+    first = MALI_SET_FIRST(windata->buffer_set);
+    for (i = first; i < first + windata->num_buffers; i++) {
+        if (i != prev)
+            SDL_UnionRect(&windata->surface[i].stale, &damage.rect, &windata->surface[i].stale);
+    }
+
+    MALI_QueueBuffer(_this, window, &damage);
+
+    surf = &windata->surface[windata->back_buffer];
+    MALI_SyncBuffer(surf, DMA_BUF_SYNC_START | DMA_BUF_SYNC_WRITE);
+    if (windata->framebuffer_preserve && windata->back_buffer != prev && !SDL_RectEmpty(&surf->stale))
+        MALI_Framebuffer_CopyRect(surf, &windata->surface[prev], &surf->stale, windata->bytes_per_pixel);
+    SDL_zero(surf->stale);
+
+    /* The window surface doesn't own its pixels, point it to the new back buffer. */
+    window->surface->pixels = surf->map;
+    return 0;
+}
+
+void
+MALI_DestroyWindowFramebuffer(_THIS, SDL_Window *window)
+{
+    if (window->driverdata)
+        MALI_UnmapWindowFramebuffer((SDL_WindowData *)window->driverdata);
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,42 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_maliframebuffer_h
+#define _SDL_maliframebuffer_h
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "../SDL_sysvideo.h"
+#include "SDL_malivideo.h"
+
+extern int MALI_CreateWindowFramebuffer(_THIS, SDL_Window *window, Uint32 *format, void **pixels, int *pitch);
+extern int MALI_UpdateWindowFramebuffer(_THIS, SDL_Window *window, const SDL_Rect *rects, int numrects);
+extern void MALI_DestroyWindowFramebuffer(_THIS, SDL_Window *window);
+extern void MALI_UnmapWindowFramebuffer(SDL_WindowData *windata);
+extern int MALI_MapBuffer(SDL_DisplayData *displaydata, MALI_EGL_Surface *surf);
+extern void MALI_SyncBuffer(MALI_EGL_Surface *surf, __u64 flags);
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+#endif /* _SDL_maliframebuffer_h */
+
+/* vi: set ts=4 sw=4 expandtab: */
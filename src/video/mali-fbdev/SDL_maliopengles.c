@@ -22,6 +22,8 @@
 
 #if SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL
 
+#include "SDL_timer.h"
+
 #include "SDL_malivideo.h"
 #include "SDL_maliopengles.h"
 #include "SDL_maliblitter.h"
@@ -46,27 +48,52 @@ MALI_GLES_LoadLibrary(_THIS, const char *path)
 int MALI_GLES_SwapWindow(_THIS, SDL_Window * window)
 {
    int r;
-   unsigned int prev;
    EGLSurface surf;
    SDL_WindowData *windowdata;
+   MALI_FrameTiming *timing;
+   MALI_EGL_Surface *back;
    SDL_DisplayData *displaydata = SDL_GetDisplayDriverData(0);
    MALI_Blitter *blitter = displaydata->blitter;
 
-   if (blitter == NULL)
-      return SDL_EGL_SwapBuffers(_this, ((SDL_WindowData *)window->driverdata)->egl_surface);
+   windowdata = (SDL_WindowData*)window->driverdata;
 
-   windowdata = (SDL_WindowData*)_this->windows->driverdata;
-   windowdata->glFlush();
+   // Without the blitter, rotated frames are copied to the screen by the CPU.
+   if (blitter == NULL) {
+      if (windowdata->soft)
+         return MALI_Soft_GLES_SwapWindow(_this, window);
+      return SDL_EGL_SwapBuffers(_this, windowdata->egl_surface);
+   }
 
-   SDL_LockMutex(blitter->mutex);
+   // Nothing changed since the last frame, there's nothing to present.
+   if (windowdata->has_swap_damage) {
+      windowdata->has_swap_damage = SDL_FALSE;
+      if (!windowdata->swap_damage.full && SDL_RectEmpty(&windowdata->swap_damage.rect))
+         return 0;
+   }
 
-   // First create the necessary fence
-   windowdata->surface[windowdata->back_buffer].egl_fence = _this->egl_data->eglCreateSyncKHR(_this->egl_data->egl_display, EGL_SYNC_FENCE_KHR, NULL);
+   back = &windowdata->surface[windowdata->back_buffer];
+   timing = &back->timing;
+   timing->submit = SDL_GetPerformanceCounter();
+   timing->completed = 0;
+
+#if SDL_VIDEO_DRIVER_MALI_SIM
+   MALI_Sim_ResolvePixmap(_this, back);
+#endif
+
+   // First create the necessary fence, a native one only gets its fd after the flush
+   if (windowdata->native_fence) {
+      back->egl_fence = _this->egl_data->eglCreateSyncKHR(_this->egl_data->egl_display, EGL_SYNC_NATIVE_FENCE_ANDROID, NULL);
+      windowdata->glFlush();
+      if (back->egl_fence != EGL_NO_SYNC)
+         back->fence_fd = _this->egl_data->eglDupNativeFenceFDANDROID(_this->egl_data->egl_display, back->egl_fence);
+   } else {
+      windowdata->glFlush();
+      back->egl_fence = _this->egl_data->eglCreateSyncKHR(_this->egl_data->egl_display, EGL_SYNC_FENCE_KHR, NULL);
+   }
+   timing->fence = SDL_GetPerformanceCounter();
 
-   // Flip back and front buffers
-   prev = windowdata->queued_buffer;
-   windowdata->queued_buffer = windowdata->back_buffer;
-   windowdata->back_buffer = prev;
+   MALI_QueueBuffer(_this, window, &windowdata->swap_damage);
+   windowdata->swap_damage.full = SDL_TRUE;
 
    // Do we have anything left over from the previous frame?
    if (windowdata->surface[windowdata->back_buffer].egl_fence != EGL_NO_SYNC) {
@@ -77,18 +104,64 @@ int MALI_GLES_SwapWindow(_THIS, SDL_Window * window)
 
       windowdata->surface[windowdata->back_buffer].egl_fence = EGL_NO_SYNC;
    }
+   if (windowdata->surface[windowdata->back_buffer].fence_fd >= 0) {
+      close(windowdata->surface[windowdata->back_buffer].fence_fd);
+      windowdata->surface[windowdata->back_buffer].fence_fd = -1;
+   }
 
    // Done, update back buffer surfaces
    surf = windowdata->surface[windowdata->back_buffer].egl_surface;
    windowdata->egl_surface = surf;
    r = _this->egl_data->eglMakeCurrent(_this->egl_data->egl_display, surf, surf, _this->current_glctx);
 
-   SDL_CondSignal(blitter->cond);
-   SDL_UnlockMutex(blitter->mutex);
-
    return (r == EGL_TRUE) ? 0 : SDL_EGL_SetError("Failed to set current surface.", "eglMakeCurrent");
 }
 
+/* The buffers being rendered to, smaller than the window with dynamic resolution */
+void
+MALI_GLES_GetDrawableSize(_THIS, SDL_Window * window, int *w, int *h)
+{
+   SDL_WindowData *windowdata = (SDL_WindowData *)window->driverdata;
+   SDL_DisplayData *displaydata = SDL_GetDisplayDriverData(0);
+   mali_pixmap *pixmap;
+
+   pixmap = windowdata ? &windowdata->surface[MALI_SET_FIRST(windowdata->buffer_set)].pixmap : NULL;
+   if (displaydata->blitter == NULL || pixmap == NULL || pixmap->width == 0) {
+      SDL_GetWindowSizeInPixels(window, w, h);
+      return;
+   }
+
+   if (w)
+      *w = pixmap->width;
+   if (h)
+      *h = pixmap->height;
+}
+
+int
+SDL_MaliSetSwapDamage(SDL_Window *window, const SDL_Rect *rects, int numrects)
+{
+   SDL_WindowData *windowdata = MALI_GetWindowData(window);
+   SDL_Rect bounds = { 0, 0, 0, 0 };
+   int i;
+
+   if (!windowdata)
+      return -1;
+   if (numrects < 0 || (numrects > 0 && !rects))
+      return SDL_InvalidParamError("rects");
+
+   // The blitter redraws a single region, keep their bounding box.
+   windowdata->has_swap_damage = SDL_TRUE;
+   windowdata->swap_damage.full = SDL_FALSE;
+   SDL_zero(windowdata->swap_damage.rect);
+   for (i = 0; i < numrects; i++)
+      SDL_UnionRect(&windowdata->swap_damage.rect, &rects[i], &windowdata->swap_damage.rect);
+
+   /* The frame is rendered at the drawable size, smaller than the window with dynamic resolution */
+   MALI_GLES_GetDrawableSize(SDL_GetVideoDevice(), window, &bounds.w, &bounds.h);
+   SDL_IntersectRect(&windowdata->swap_damage.rect, &bounds, &windowdata->swap_damage.rect);
+   return 0;
+}
+
 SDL_EGL_MakeCurrent_impl(MALI)
 SDL_EGL_CreateContext_impl(MALI)
 
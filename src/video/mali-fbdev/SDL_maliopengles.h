@@ -37,6 +37,7 @@
 extern int MALI_GLES_LoadLibrary(_THIS, const char *path);
 extern SDL_GLContext MALI_GLES_CreateContext(_THIS, SDL_Window * window);
 extern int MALI_GLES_SwapWindow(_THIS, SDL_Window * window);
+extern void MALI_GLES_GetDrawableSize(_THIS, SDL_Window * window, int *w, int *h);
 extern int MALI_GLES_MakeCurrent(_THIS, SDL_Window * window, SDL_GLContext context);
 extern void MALI_GLES_DefaultProfileConfig(_THIS, int *mask, int *major, int *minor);
 
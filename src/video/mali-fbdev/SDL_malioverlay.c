@@ -0,0 +1,241 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_hints.h"
+#include "SDL_surface.h"
+#include "SDL_system.h"
+
+#include "../../events/SDL_mouse_c.h"
+#include "../../events/default_cursor.h"
+
+#include "SDL_malivideo.h"
+#include "SDL_maliblitter.h"
+#include "SDL_malioverlay.h"
+
+/*
+ * The application side of the blitter's overlay layers: the cursor follows
+ * the SDL mouse state, other layers come from SDL_MaliSetOverlay. Both hand
+ * the blitter their own copy of the pixels.
+ */
+
+static MALI_Blitter *
+MALI_Overlay_GetBlitter(void)
+{
+    SDL_DisplayData *displaydata = SDL_GetDisplayDriverData(0);
+
+    return displaydata ? displaydata->blitter : NULL;
+}
+
+/* Copies a surface to tightly packed RGBA, as the blitter uploads it. */
+static Uint32 *
+MALI_Overlay_CopyPixels(SDL_Surface *surface)
+{
+    const size_t size = (size_t)surface->w * surface->h * 4;
+    Uint32 *pixels;
+
+    pixels = (Uint32 *)SDL_malloc(size);
+    if (!pixels) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+
+    if (SDL_ConvertPixels(surface->w, surface->h, surface->format->format, surface->pixels, surface->pitch,
+                          SDL_PIXELFORMAT_ABGR8888, pixels, surface->w * 4) < 0) {
+        SDL_free(pixels);
+        return NULL;
+    }
+    return pixels;
+}
+
+static SDL_Cursor *
+MALI_CreateDefaultCursor(void)
+{
+    return SDL_CreateCursor(default_cdata, default_cmask, DEFAULT_CWIDTH, DEFAULT_CHEIGHT, DEFAULT_CHOTX, DEFAULT_CHOTY);
+}
+
+/* Create a cursor from a surface */
+static SDL_Cursor *
+MALI_CreateCursor(SDL_Surface *surface, int hot_x, int hot_y)
+{
+    MALI_CursorData *curdata;
+    SDL_Cursor *cursor;
+
+    cursor = (SDL_Cursor *)SDL_calloc(1, sizeof(*cursor));
+    if (cursor == NULL) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    curdata = (MALI_CursorData *)SDL_calloc(1, sizeof(*curdata));
+    if (curdata == NULL) {
+        SDL_OutOfMemory();
+        SDL_free(cursor);
+        return NULL;
+    }
+
+    curdata->pixels = MALI_Overlay_CopyPixels(surface);
+    if (curdata->pixels == NULL) {
+        SDL_free(curdata);
+        SDL_free(cursor);
+        return NULL;
+    }
+    curdata->w = surface->w;
+    curdata->h = surface->h;
+    curdata->hot_x = hot_x;
+    curdata->hot_y = hot_y;
+
+    cursor->driverdata = curdata;
+    return cursor;
+}
+
+/* Show the specified cursor, or hide if cursor is NULL */
+static int
+MALI_ShowCursor(SDL_Cursor *cursor)
+{
+    MALI_Blitter *blitter = MALI_Overlay_GetBlitter();
+    SDL_Mouse *mouse = SDL_GetMouse();
+    MALI_CursorData *curdata;
+    SDL_Rect dst = { 0, 0, 0, 0 };
+    Uint32 *pixels = NULL;
+
+    if (blitter == NULL) {
+        return SDL_Unsupported();
+    }
+
+    if (cursor != NULL && cursor->driverdata != NULL) {
+        curdata = (MALI_CursorData *)cursor->driverdata;
+        pixels = (Uint32 *)SDL_malloc((size_t)curdata->w * curdata->h * 4);
+        if (pixels == NULL) {
+            return SDL_OutOfMemory();
+        }
+        SDL_memcpy(pixels, curdata->pixels, (size_t)curdata->w * curdata->h * 4);
+        dst = (SDL_Rect){ -curdata->hot_x, -curdata->hot_y, curdata->w, curdata->h };
+    }
+
+    MALI_Blitter_SetOverlay(blitter, MALI_OVERLAY_CURSOR, pixels, dst.w, dst.h, &dst);
+    MALI_Blitter_MoveCursor(blitter, mouse->focus, mouse->x, mouse->y);
+    return 0;
+}
+
+/* Free a window manager cursor */
+static void
+MALI_FreeCursor(SDL_Cursor *cursor)
+{
+    MALI_CursorData *curdata;
+
+    if (cursor != NULL) {
+        curdata = (MALI_CursorData *)cursor->driverdata;
+        if (curdata != NULL) {
+            SDL_free(curdata->pixels);
+            SDL_free(curdata);
+        }
+        SDL_free(cursor);
+    }
+}
+
+/* This is called when a mouse motion event occurs */
+static void
+MALI_MoveCursor(SDL_Cursor *cursor)
+{
+    MALI_Blitter *blitter = MALI_Overlay_GetBlitter();
+    SDL_Mouse *mouse = SDL_GetMouse();
+
+    if (blitter != NULL) {
+        MALI_Blitter_MoveCursor(blitter, mouse->focus, mouse->x, mouse->y);
+    }
+}
+
+/* Warp the mouse to (x,y) */
+static void
+MALI_WarpMouse(SDL_Window *window, int x, int y)
+{
+    SDL_Mouse *mouse = SDL_GetMouse();
+
+    /* Moves the cursor along through MALI_MoveCursor */
+    SDL_SendMouseMotion(window, mouse->mouseID, 0, x, y);
+}
+
+void
+MALI_InitMouse(_THIS)
+{
+    SDL_Mouse *mouse = SDL_GetMouse();
+
+    mouse->CreateCursor = MALI_CreateCursor;
+    mouse->ShowCursor = MALI_ShowCursor;
+    mouse->MoveCursor = MALI_MoveCursor;
+    mouse->FreeCursor = MALI_FreeCursor;
+    mouse->WarpMouse = MALI_WarpMouse;
+
+    /*
+     * SDL_MALI_CURSOR: Set to "1" to show the default arrow cursor until the
+     * application hides it or sets its own. Off by default, most devices
+     * running this driver have no pointing device to begin with.
+     */
+    if (MALI_GetHintInt("SDL_MALI_CURSOR", 0)) {
+        SDL_SetDefaultCursor(MALI_CreateDefaultCursor());
+    }
+}
+
+int
+SDL_MaliSetOverlay(SDL_Window *window, int layer, SDL_Surface *surface, const SDL_Rect *dst)
+{
+    SDL_WindowData *windata = MALI_GetWindowData(window);
+    MALI_Blitter *blitter = MALI_Overlay_GetBlitter();
+    SDL_Rect rect = { 0, 0, 0, 0 };
+    Uint32 *pixels = NULL;
+
+    if (!windata) {
+        return -1;
+    }
+    if (!blitter) {
+        return SDL_SetError("mali-fbdev: Overlays need the blitter");
+    }
+    if (layer < 0 || layer >= MALI_MAX_OVERLAYS) {
+        return SDL_InvalidParamError("layer");
+    }
+
+    if (surface) {
+        if (surface->w <= 0 || surface->h <= 0) {
+            return SDL_InvalidParamError("surface");
+        }
+        if (dst) {
+            rect = *dst;
+        }
+        if (rect.w <= 0 || rect.h <= 0) {
+            rect.w = surface->w;
+            rect.h = surface->h;
+        }
+
+        pixels = MALI_Overlay_CopyPixels(surface);
+        if (!pixels) {
+            return -1;
+        }
+    }
+
+    MALI_Blitter_SetOverlay(blitter, layer, pixels, surface ? surface->w : 0, surface ? surface->h : 0, &rect);
+    return 0;
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+/* vi: set ts=4 sw=4 expandtab: */
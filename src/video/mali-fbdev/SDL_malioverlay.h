@@ -0,0 +1,40 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malioverlay_h
+#define _SDL_malioverlay_h
+
+#include "../SDL_sysvideo.h"
+
+/* Image of a cursor, shown through the blitter's cursor layer */
+typedef struct MALI_CursorData
+{
+    Uint32 *pixels;         /* RGBA, tightly packed */
+    int w, h;
+    int hot_x, hot_y;
+} MALI_CursorData;
+
+extern void MALI_InitMouse(_THIS);
+
+#endif /* _SDL_malioverlay_h */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,311 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_hints.h"
+#include "SDL_timer.h"
+
+#include "SDL_malivideo.h"
+#include "SDL_malipool.h"
+
+/*
+ * Contiguous ION memory is slow to allocate and fragments quickly, so window
+ * buffers are never handed back to the kernel right away. Released buffers
+ * wait in the pool, keyed by their size and stride, and the next window or
+ * resize with that layout reuses them; with the same dimensions, even their
+ * pixmap mapping is kept. Nothing is rounded up to share buffers between
+ * sizes, that memory is too scarce to waste.
+ *
+ * SDL_MALI_POOL_SIZE: Megabytes of idle buffers the pool keeps around, the
+ * oldest ones are freed beyond that. "0" disables the pool. Defaults to 32.
+ *
+ * SDL_MALI_POOL_TIMEOUT: Seconds a buffer may stay idle before it's freed.
+ * Defaults to 10.
+ */
+
+#define MALI_POOL_TRIM_INTERVAL 1000
+
+/* ION hands out whole pages anyway */
+#define MALI_POOL_PAGE_SIZE     4096
+
+static SDL_bool
+MALI_Pool_SameLayout(const mali_pixmap *a, const mali_pixmap *b)
+{
+    return a->width == b->width && a->height == b->height &&
+           a->planes[0].stride == b->planes[0].stride &&
+           a->drm_fourcc.format == b->drm_fourcc.format;
+}
+
+static void
+MALI_Pool_Free(SDL_DisplayData *displaydata, MALI_PoolBuffer *buffer)
+{
+    struct ion_handle_data handle_data = {
+        .handle = buffer->dmabuf_handle
+    };
+
+    if ((int)buffer->pixmap_handle >= 0)
+        displaydata->egl_destroy_pixmap_ID_mapping(buffer->pixmap_handle);
+    close(buffer->dmabuf_fd);
+    MALI_DeviceIoctl(displaydata->ion_fd, ION_IOC_FREE, &handle_data);
+    SDL_free(buffer);
+}
+
+static MALI_PoolBuffer *
+MALI_Pool_Remove(MALI_BufferPool *pool, int index)
+{
+    MALI_PoolBuffer *buffer = pool->buffers[index];
+
+    pool->size -= buffer->size;
+    pool->buffers[index] = pool->buffers[--pool->count];
+    return buffer;
+}
+
+/* Frees idle buffers, the oldest first, until the pool is down to `max_size`. */
+static void
+MALI_Pool_Shrink(SDL_DisplayData *displaydata, size_t max_size)
+{
+    MALI_BufferPool *pool = &displaydata->pool;
+    int i, oldest;
+
+    while (pool->count > 0 && pool->size > max_size) {
+        oldest = 0;
+        for (i = 1; i < pool->count; i++) {
+            if ((Sint32)(pool->buffers[i]->released - pool->buffers[oldest]->released) < 0)
+                oldest = i;
+        }
+        MALI_Pool_Free(displaydata, MALI_Pool_Remove(pool, oldest));
+    }
+}
+
+/* Takes a buffer of the given size and stride out of the pool, preferring the same layout. */
+static MALI_PoolBuffer *
+MALI_Pool_Take(MALI_BufferPool *pool, size_t size, const mali_pixmap *pixmap)
+{
+    int i, match = -1;
+
+    for (i = 0; i < pool->count; i++) {
+        if (pool->buffers[i]->size != size || pool->buffers[i]->pixmap.planes[0].stride != pixmap->planes[0].stride)
+            continue;
+        match = i;
+        if (MALI_Pool_SameLayout(&pool->buffers[i]->pixmap, pixmap))
+            break;
+    }
+
+    return (match >= 0) ? MALI_Pool_Remove(pool, match) : NULL;
+}
+
+static MALI_PoolBuffer *
+MALI_Pool_Allocate(SDL_DisplayData *displaydata, size_t size)
+{
+    struct ion_allocation_data allocation_data;
+    struct ion_handle_data handle_data;
+    struct ion_fd_data ion_data;
+    MALI_PoolBuffer *buffer;
+
+    /* Allocate framebuffer data */
+    allocation_data = (struct ion_allocation_data){
+        .len = size,
+        .heap_id_mask = (1 << ION_HEAP_TYPE_DMA),
+        .flags = 1 << ION_FLAG_CACHED
+    };
+
+    if (MALI_DeviceIoctl(displaydata->ion_fd, ION_IOC_ALLOC, &allocation_data) != 0) {
+        SDL_SetError("mali-fbdev: Unable to create backing ION buffers");
+        return NULL;
+    }
+
+    /* Export DMA_BUF handle for the framebuffer */
+    ion_data = (struct ion_fd_data){
+        .handle = allocation_data.handle
+    };
+
+    handle_data = (struct ion_handle_data){
+        .handle = allocation_data.handle
+    };
+
+    if (MALI_DeviceIoctl(displaydata->ion_fd, ION_IOC_SHARE, &ion_data) != 0) {
+        MALI_DeviceIoctl(displaydata->ion_fd, ION_IOC_FREE, &handle_data);
+        SDL_SetError("mali-fbdev: Failure exporting ION buffer handle");
+        return NULL;
+    }
+
+    if ((buffer = (MALI_PoolBuffer *)SDL_calloc(1, sizeof(MALI_PoolBuffer))) == NULL) {
+        close(ion_data.fd);
+        MALI_DeviceIoctl(displaydata->ion_fd, ION_IOC_FREE, &handle_data);
+        SDL_OutOfMemory();
+        return NULL;
+    }
+
+    buffer->dmabuf_handle = allocation_data.handle;
+    buffer->dmabuf_fd = ion_data.fd;
+    buffer->size = size;
+    buffer->pixmap_handle = (NativePixmapType)-1;
+    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Created ION buffer %d (fd: %d)\n", buffer->dmabuf_handle, buffer->dmabuf_fd);
+    return buffer;
+}
+
+void
+MALI_PoolInit(MALI_BufferPool *pool)
+{
+    SDL_zerop(pool);
+    pool->lock = SDL_CreateMutex();
+    pool->max_size = (size_t)SDL_max(MALI_GetHintInt("SDL_MALI_POOL_SIZE", 32), 0) << 20;
+    pool->timeout = (Uint32)SDL_max(MALI_GetHintInt("SDL_MALI_POOL_TIMEOUT", 10), 0) * 1000;
+}
+
+void
+MALI_PoolQuit(SDL_DisplayData *displaydata)
+{
+    MALI_BufferPool *pool = &displaydata->pool;
+
+    MALI_Pool_Shrink(displaydata, 0);
+    SDL_free(pool->buffers);
+    SDL_DestroyMutex(pool->lock);
+    SDL_zerop(pool);
+}
+
+int
+MALI_PoolAcquire(SDL_DisplayData *displaydata, MALI_EGL_Surface *surf)
+{
+    MALI_BufferPool *pool = &displaydata->pool;
+    size_t size = MALI_ALIGN(surf->pixmap.planes[0].size, MALI_POOL_PAGE_SIZE);
+    MALI_PoolBuffer *buffer;
+
+    SDL_LockMutex(pool->lock);
+    buffer = MALI_Pool_Take(pool, size, &surf->pixmap);
+    if (!buffer) {
+        buffer = MALI_Pool_Allocate(displaydata, size);
+        if (!buffer && pool->count > 0) {
+            /* Give the idle buffers back to the kernel, they may be what's fragmenting the heap. */
+            MALI_Pool_Shrink(displaydata, 0);
+            buffer = MALI_Pool_Allocate(displaydata, size);
+        }
+    } else {
+        SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Reused ION buffer %d (fd: %d)\n", buffer->dmabuf_handle, buffer->dmabuf_fd);
+    }
+    SDL_UnlockMutex(pool->lock);
+
+    if (!buffer)
+        return -1;
+
+    /* Recall fd and handle for teardown later */
+    surf->buffer = buffer;
+    surf->dmabuf_handle = buffer->dmabuf_handle;
+    surf->dmabuf_fd = buffer->dmabuf_fd;
+    surf->pixmap.handles[0] = buffer->dmabuf_fd;
+
+    /* Create Pixmap Surface using DMA_BUF framebuffer fd, unless the last one still fits */
+    if ((int)buffer->pixmap_handle < 0 || !MALI_Pool_SameLayout(&buffer->pixmap, &surf->pixmap)) {
+        if ((int)buffer->pixmap_handle >= 0)
+            displaydata->egl_destroy_pixmap_ID_mapping(buffer->pixmap_handle);
+        buffer->pixmap = surf->pixmap;
+        buffer->pixmap_handle = displaydata->egl_create_pixmap_ID_mapping(&buffer->pixmap);
+    }
+    surf->pixmap_handle = buffer->pixmap_handle;
+
+    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Created pixmap handle %p\n", (void *)surf->pixmap_handle);
+    if ((int)surf->pixmap_handle < 0) {
+        return SDL_SetError("mali-fbdev: Unable to create EGL window surface (egl_create_pixmap_ID_mapping)");
+    }
+
+    return 0;
+}
+
+void
+MALI_PoolRelease(SDL_DisplayData *displaydata, MALI_EGL_Surface *surf)
+{
+    MALI_BufferPool *pool = &displaydata->pool;
+    MALI_PoolBuffer *buffer = surf->buffer, **buffers;
+    int capacity;
+
+    surf->buffer = NULL;
+    if (!buffer)
+        return;
+
+    SDL_LockMutex(pool->lock);
+
+    /* Make room, the buffer itself is freed when it wouldn't fit at all. */
+    MALI_Pool_Shrink(displaydata, (pool->max_size > buffer->size) ? pool->max_size - buffer->size : 0);
+    if (buffer->size > pool->max_size)
+        goto free;
+
+    if (pool->count == pool->capacity) {
+        capacity = pool->capacity ? pool->capacity * 2 : 8;
+        buffers = (MALI_PoolBuffer **)SDL_realloc(pool->buffers, capacity * sizeof(MALI_PoolBuffer *));
+        if (!buffers)
+            goto free;
+        pool->buffers = buffers;
+        pool->capacity = capacity;
+    }
+
+    buffer->released = SDL_GetTicks();
+    pool->buffers[pool->count++] = buffer;
+    pool->size += buffer->size;
+    SDL_UnlockMutex(pool->lock);
+    return;
+
+free:
+    MALI_Pool_Free(displaydata, buffer);
+    SDL_UnlockMutex(pool->lock);
+}
+
+/*
+ * Frees the buffers that were idle for longer than the timeout. Called on
+ * swaps and resizes, and by the blitter while it has nothing to show, so
+ * buffers go back even when the application stops presenting. Returns the
+ * milliseconds until it's worth calling again, -1 with the pool empty.
+ */
+int
+MALI_PoolTrim(SDL_DisplayData *displaydata)
+{
+    MALI_BufferPool *pool = &displaydata->pool;
+    Uint32 now = SDL_GetTicks();
+    int i, left, next = -1;
+
+    /* Buffers are released into the pool from other threads, look at it locked */
+    SDL_LockMutex(pool->lock);
+    if (pool->count > 0 && SDL_TICKS_PASSED(now, pool->next_trim)) {
+        pool->next_trim = now + MALI_POOL_TRIM_INTERVAL;
+        for (i = pool->count - 1; i >= 0; i--) {
+            if ((Uint32)(now - pool->buffers[i]->released) >= pool->timeout)
+                MALI_Pool_Free(displaydata, MALI_Pool_Remove(pool, i));
+        }
+    }
+
+    /* Until the next buffer times out, but no sooner than the next trim */
+    if (pool->count > 0) {
+        next = (int)pool->timeout;
+        for (i = 0; i < pool->count; i++) {
+            left = (int)(pool->timeout - (now - pool->buffers[i]->released));
+            next = SDL_min(next, left);
+        }
+        next = SDL_max(next, (int)(pool->next_trim - now));
+    }
+    SDL_UnlockMutex(pool->lock);
+
+    return next;
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+/* vi: set ts=4 sw=4 expandtab: */
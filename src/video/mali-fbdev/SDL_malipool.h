@@ -0,0 +1,66 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malipool_h
+#define _SDL_malipool_h
+
+#include "SDL_mutex.h"
+#include "mali.h"
+
+struct SDL_DisplayData;
+struct MALI_EGL_Surface;
+
+/*
+ * An ION allocation and the pixmap mapping it was last used with. The mapping
+ * refers to the pixmap by address, so it lives here rather than in a window.
+ */
+typedef struct MALI_PoolBuffer
+{
+    int dmabuf_fd;
+    int dmabuf_handle;
+    size_t size;
+    mali_pixmap pixmap;
+    NativePixmapType pixmap_handle;
+    Uint32 released;
+} MALI_PoolBuffer;
+
+/* Window buffers released for reuse, shared by every window of the display. */
+typedef struct MALI_BufferPool
+{
+    SDL_mutex *lock;
+    MALI_PoolBuffer **buffers;
+    int count, capacity;
+    size_t size;            /* total size of the idle buffers */
+    size_t max_size;
+    Uint32 timeout;         /* idle buffers older than this are freed, in ms */
+    Uint32 next_trim;
+} MALI_BufferPool;
+
+extern void MALI_PoolInit(MALI_BufferPool *pool);
+extern void MALI_PoolQuit(struct SDL_DisplayData *displaydata);
+extern int MALI_PoolAcquire(struct SDL_DisplayData *displaydata, struct MALI_EGL_Surface *surf);
+extern void MALI_PoolRelease(struct SDL_DisplayData *displaydata, struct MALI_EGL_Surface *surf);
+extern int MALI_PoolTrim(struct SDL_DisplayData *displaydata);
+
+#endif /* _SDL_malipool_h */
+
+/* vi: set ts=4 sw=4 expandtab: */
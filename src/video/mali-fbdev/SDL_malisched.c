@@ -0,0 +1,181 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_log.h"
+#include "SDL_system.h"
+#include "SDL_thread.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "SDL_malisched.h"
+
+/*
+ * big.LITTLE SoCs group their cores in clusters running at different speeds,
+ * cpufreq tells them apart by the highest frequency each core can reach. On
+ * SoCs where all cores are alike, like the RK3326, there's no cluster to pick.
+ */
+static unsigned long
+MALI_Sched_GetMaxFreq(int cpu)
+{
+    char path[128];
+    unsigned long freq = 0;
+    FILE *f;
+
+    SDL_snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+    f = fopen(path, "r");
+    if (!f)
+        return 0;
+    if (fscanf(f, "%lu", &freq) != 1)
+        freq = 0;
+    fclose(f);
+    return freq;
+}
+
+/* Fills set with the fastest or the slowest cluster, returns SDL_FALSE if there's only one. */
+static SDL_bool
+MALI_Sched_GetCluster(SDL_bool big, cpu_set_t *set)
+{
+    const int count = SDL_min((int)sysconf(_SC_NPROCESSORS_CONF), CPU_SETSIZE);
+    unsigned long freq, lowest = 0, highest = 0;
+    int cpu;
+
+    for (cpu = 0; cpu < count; cpu++) {
+        freq = MALI_Sched_GetMaxFreq(cpu);
+        if (freq == 0)
+            continue;
+        if (lowest == 0 || freq < lowest)
+            lowest = freq;
+        if (freq > highest)
+            highest = freq;
+    }
+    if (lowest == highest)
+        return SDL_FALSE;
+
+    CPU_ZERO(set);
+    for (cpu = 0; cpu < count; cpu++) {
+        if (MALI_Sched_GetMaxFreq(cpu) == (big ? highest : lowest))
+            CPU_SET(cpu, set);
+    }
+    return SDL_TRUE;
+}
+
+/* Parses a list of cores such as "4-5" or "0,2,4-7". */
+static SDL_bool
+MALI_Sched_ParseList(const char *list, cpu_set_t *set)
+{
+    long first, last;
+    char *end;
+
+    CPU_ZERO(set);
+    while (*list) {
+        first = SDL_strtol(list, &end, 10);
+        if (end == list || first < 0)
+            return SDL_FALSE;
+
+        last = first;
+        if (*end == '-') {
+            list = end + 1;
+            last = SDL_strtol(list, &end, 10);
+            if (end == list || last < first)
+                return SDL_FALSE;
+        }
+
+        for (; first <= last && first < CPU_SETSIZE; first++) {
+            CPU_SET(first, set);
+        }
+
+        if (*end == ',')
+            end++;
+        else if (*end)
+            return SDL_FALSE;
+        list = end;
+    }
+    return CPU_COUNT(set) > 0;
+}
+
+static void
+MALI_Sched_SetPriority(const char *name, pid_t tid, const char *priority)
+{
+    struct sched_param param;
+
+    if (SDL_strcasecmp(priority, "normal") == 0) {
+        return;
+    } else if (SDL_strcasecmp(priority, "high") == 0) {
+        if (SDL_LinuxSetThreadPriorityAndPolicy(tid, SDL_THREAD_PRIORITY_HIGH, SCHED_OTHER) < 0)
+            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "%s: Can't raise priority: %s", name, SDL_GetError());
+    } else if (SDL_strcasecmp(priority, "fifo") == 0) {
+        /* Directly when privileged, through rtkit otherwise */
+        param.sched_priority = sched_get_priority_max(SCHED_FIFO) * 3 / 4;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0 &&
+            SDL_LinuxSetThreadPriorityAndPolicy(tid, SDL_THREAD_PRIORITY_HIGH, SCHED_FIFO) < 0) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "%s: Can't switch to SCHED_FIFO: %s", name, SDL_GetError());
+        }
+    } else {
+        SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "%s: Unknown priority \"%s\"", name, priority);
+    }
+}
+
+static void
+MALI_Sched_SetAffinity(const char *name, const char *affinity)
+{
+    cpu_set_t set;
+
+    if (SDL_strcasecmp(affinity, "none") == 0) {
+        return;
+    } else if (SDL_strcasecmp(affinity, "big") == 0 || SDL_strcasecmp(affinity, "little") == 0) {
+        if (!MALI_Sched_GetCluster(SDL_strcasecmp(affinity, "big") == 0, &set))
+            return;
+    } else if (!MALI_Sched_ParseList(affinity, &set)) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "%s: Unknown affinity \"%s\"", name, affinity);
+        return;
+    }
+
+    if (sched_setaffinity(0, sizeof(set), &set) < 0) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "%s: Can't set affinity to \"%s\"", name, affinity);
+    } else {
+        SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "%s: Running on %d cores (%s)", name, CPU_COUNT(&set), affinity);
+    }
+}
+
+/*
+ * Applies a scheduling priority ("normal", "high" or "fifo") and a core set
+ * ("none", "big", "little" or a list of cores) to the calling thread. Either
+ * may be NULL to leave it alone.
+ */
+void
+MALI_SetThreadScheduling(const char *name, const char *priority, const char *affinity)
+{
+    if (priority && *priority)
+        MALI_Sched_SetPriority(name, (pid_t)syscall(SYS_gettid), priority);
+    if (affinity && *affinity)
+        MALI_Sched_SetAffinity(name, affinity);
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,748 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_DRIVER_MALI_SIM
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <linux/udmabuf.h>
+
+#include "SDL_hints.h"
+#include "SDL_log.h"
+
+#include "SDL_malivideo.h"
+#include "SDL_maliblitter.h"
+#include "SDL_malisim.h"
+
+#ifndef FBIO_WAITFORVSYNC
+#define FBIO_WAITFORVSYNC _IOW('F', 0x20, __u32)
+#endif
+#ifndef GL_BGRA_EXT
+#define GL_BGRA_EXT 0x80E1
+#endif
+#ifndef GL_UNPACK_ROW_LENGTH_EXT
+#define GL_UNPACK_ROW_LENGTH_EXT 0x0CF2
+#endif
+
+#define MALI_SIM_MAX_FDS        16
+#define MALI_SIM_MAX_BUFFERS    64
+#define MALI_SIM_MAX_PIXMAPS    64
+
+typedef enum
+{
+    MALI_SIM_NONE,
+    MALI_SIM_FB,
+    MALI_SIM_ION
+} MALI_SimDevice;
+
+/* A pixmap mapping, the blob hands out small integer ids for those as well */
+typedef struct MALI_SimPixmap
+{
+    const mali_pixmap *pixmap;
+    Uint8 *map;
+} MALI_SimPixmap;
+
+/*
+ * Lives as long as the process, like the device nodes it stands in for. The
+ * descriptors handed out for /dev/fb0 and /dev/ion are real ones, the table
+ * tells them apart from everything else passed to MALI_Sim_Ioctl.
+ */
+static struct
+{
+    SDL_SpinLock lock;
+    SDL_bool initialized;
+
+    struct {
+        int fd;
+        MALI_SimDevice device;
+    } fds[MALI_SIM_MAX_FDS];
+
+    /* ION handles are indices into this plus one, 0 is never a valid handle */
+    int buffers[MALI_SIM_MAX_BUFFERS];
+    int udmabuf_fd;
+
+    MALI_SimPixmap pixmaps[MALI_SIM_MAX_PIXMAPS];
+
+    int fb_fd;
+    struct fb_var_screeninfo vinfo;
+    Uint64 epoch;           /* vblanks happen at whole periods from here, in ns */
+    Uint64 period;
+    SDL_bool scanout;
+
+    /* Readback on the render and the blitter thread respectively */
+    Uint8 *staging;
+    size_t staging_size;
+    Uint8 *scanout_staging;
+    size_t scanout_size;
+
+    void (*glGetIntegerv)(GLenum, GLint *);
+    void (*glBindFramebuffer)(GLenum, GLuint);
+    void (*glReadPixels)(GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, GLvoid *);
+} sim;
+
+static Uint64
+MALI_Sim_Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (Uint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Sleeps until the count-th vblank from now, as a display with these timings would have them. */
+static void
+MALI_Sim_WaitVblank(int count)
+{
+    Uint64 now = MALI_Sim_Now(), next;
+    struct timespec ts;
+
+    next = sim.epoch + ((now - sim.epoch) / sim.period + count) * sim.period;
+    ts.tv_sec = next / 1000000000;
+    ts.tv_nsec = next % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+/* Flips the bottom-up RGBA rows of glReadPixels into a top-down buffer of the given format. */
+static void
+MALI_Sim_StoreRows(const Uint8 *src, int width, int height, Uint8 *dst, size_t pitch, Uint32 format)
+{
+    const Uint8 *s;
+    Uint16 *d16;
+    Uint8 *d;
+    int x, y;
+
+    for (y = 0; y < height; y++) {
+        s = src + (size_t)(height - 1 - y) * width * 4;
+        d = dst + y * pitch;
+        if (format == DRM_FORMAT_RGB565) {
+            d16 = (Uint16 *)d;
+            for (x = 0; x < width; x++, s += 4) {
+                d16[x] = ((s[0] >> 3) << 11) | ((s[1] >> 2) << 5) | (s[2] >> 3);
+            }
+        } else {
+            for (x = 0; x < width; x++, s += 4, d += 4) {
+                d[0] = s[2];
+                d[1] = s[1];
+                d[2] = s[0];
+                d[3] = s[3];
+            }
+        }
+    }
+}
+
+static SDL_bool
+MALI_Sim_Reserve(Uint8 **buffer, size_t *size, size_t needed)
+{
+    Uint8 *resized;
+
+    if (*size >= needed)
+        return SDL_TRUE;
+
+    resized = (Uint8 *)SDL_realloc(*buffer, needed);
+    if (!resized)
+        return SDL_FALSE;
+
+    *buffer = resized;
+    *size = needed;
+    return SDL_TRUE;
+}
+
+/*****************************************************************************/
+/* Framebuffer device                                                        */
+/*****************************************************************************/
+
+/*
+ * SDL_MALI_SIM_MODE: Mode of the simulated panel as "WIDTHxHEIGHT@HZ", such
+ * as "1920x1152@60" or "640x480@59.94". Defaults to "640x480@60".
+ *
+ * SDL_MALI_SIM_FB: File backing the simulated /dev/fb0, so what was scanned
+ * out can be looked at from outside. Defaults to an anonymous memory file.
+ */
+static void
+MALI_Sim_InitFb(void)
+{
+    const char *mode = SDL_GetHint("SDL_MALI_SIM_MODE");
+    const char *path = SDL_GetHint("SDL_MALI_SIM_FB");
+    const char *p;
+    int width = 640, height = 480;
+    double refresh = 60.0;
+
+    if (mode) {
+        width = SDL_atoi(mode);
+        p = SDL_strchr(mode, 'x');
+        height = p ? SDL_atoi(p + 1) : 0;
+        p = SDL_strchr(mode, '@');
+        refresh = p ? SDL_atof(p + 1) : 60.0;
+    }
+    if (width <= 0 || height <= 0 || width > 8192 || height > 8192) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Ignoring simulated mode \"%s\"", mode);
+        width = 640;
+        height = 480;
+    }
+    if (refresh < 1.0 || refresh > 1000.0)
+        refresh = 60.0;
+
+    /* No blanking, so the pixel clock alone carries the refresh rate */
+    SDL_zero(sim.vinfo);
+    sim.vinfo.xres = sim.vinfo.xres_virtual = width;
+    sim.vinfo.yres = sim.vinfo.yres_virtual = height;
+    sim.vinfo.bits_per_pixel = 32;
+    sim.vinfo.red = (struct fb_bitfield){ 16, 8, 0 };
+    sim.vinfo.green = (struct fb_bitfield){ 8, 8, 0 };
+    sim.vinfo.blue = (struct fb_bitfield){ 0, 8, 0 };
+    sim.vinfo.transp = (struct fb_bitfield){ 24, 8, 0 };
+    sim.vinfo.pixclock = (__u32)(1e12 / (refresh * width * height));
+    sim.period = (Uint64)(1e9 / refresh);
+
+    if (path) {
+        sim.fb_fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    } else {
+        sim.fb_fd = memfd_create("mali-sim-fb", MFD_CLOEXEC);
+    }
+    if (sim.fb_fd >= 0 && ftruncate(sim.fb_fd, (off_t)width * height * 4) < 0) {
+        close(sim.fb_fd);
+        sim.fb_fd = -1;
+    }
+    if (sim.fb_fd < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Could not create the simulated framebuffer: %s", strerror(errno));
+    }
+}
+
+/* The mode is as fixed as a panel's, only the virtual height and the offsets change. */
+static int
+MALI_Sim_SetVinfo(struct fb_var_screeninfo *vinfo)
+{
+    __u32 yres_virtual;
+
+    SDL_AtomicLock(&sim.lock);
+    yres_virtual = SDL_clamp(vinfo->yres_virtual, sim.vinfo.yres, sim.vinfo.yres * 3);
+    if (ftruncate(sim.fb_fd, (off_t)sim.vinfo.xres * 4 * yres_virtual) < 0) {
+        SDL_AtomicUnlock(&sim.lock);
+        return -1;
+    }
+    sim.vinfo.yres_virtual = yres_virtual;
+    sim.vinfo.yoffset = (vinfo->yoffset + sim.vinfo.yres <= yres_virtual) ? vinfo->yoffset : 0;
+    *vinfo = sim.vinfo;
+    SDL_AtomicUnlock(&sim.lock);
+
+    return 0;
+}
+
+static int
+MALI_Sim_FbIoctl(unsigned long request, void *arg)
+{
+    struct fb_var_screeninfo *vinfo = (struct fb_var_screeninfo *)arg;
+    struct fb_fix_screeninfo *finfo = (struct fb_fix_screeninfo *)arg;
+    int result = 0;
+
+    switch (request) {
+    case FBIOGET_VSCREENINFO:
+        SDL_AtomicLock(&sim.lock);
+        *vinfo = sim.vinfo;
+        SDL_AtomicUnlock(&sim.lock);
+        return 0;
+
+    case FBIOPUT_VSCREENINFO:
+        return MALI_Sim_SetVinfo(vinfo);
+
+    case FBIOGET_FSCREENINFO:
+        SDL_zerop(finfo);
+        SDL_strlcpy(finfo->id, "mali-sim", sizeof(finfo->id));
+        finfo->type = FB_TYPE_PACKED_PIXELS;
+        finfo->visual = FB_VISUAL_TRUECOLOR;
+        SDL_AtomicLock(&sim.lock);
+        finfo->line_length = sim.vinfo.xres * 4;
+        finfo->smem_len = finfo->line_length * sim.vinfo.yres_virtual;
+        SDL_AtomicUnlock(&sim.lock);
+        return 0;
+
+    case FBIOPAN_DISPLAY:
+        SDL_AtomicLock(&sim.lock);
+        if (vinfo->yoffset + sim.vinfo.yres > sim.vinfo.yres_virtual) {
+            errno = EINVAL;
+            result = -1;
+        } else {
+            sim.vinfo.yoffset = vinfo->yoffset;
+        }
+        SDL_AtomicUnlock(&sim.lock);
+        return result;
+
+    case FBIO_WAITFORVSYNC:
+        MALI_Sim_WaitVblank(1);
+        return 0;
+
+    default:
+        errno = ENOTTY;
+        return -1;
+    }
+}
+
+/*****************************************************************************/
+/* ION allocator                                                             */
+/*****************************************************************************/
+
+/* A udmabuf is a real dma-buf, DMA_BUF_IOCTL_SYNC then works as on the device. */
+static int
+MALI_Sim_Allocate(size_t size)
+{
+    struct udmabuf_create create;
+    int memfd, fd;
+
+    size = MALI_ALIGN(size, (size_t)sysconf(_SC_PAGESIZE));
+    memfd = memfd_create("mali-sim-ion", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memfd < 0)
+        return -1;
+
+    if (ftruncate(memfd, size) < 0) {
+        close(memfd);
+        return -1;
+    }
+
+    if (sim.udmabuf_fd >= 0 && fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK) == 0) {
+        create = (struct udmabuf_create){
+            .memfd = memfd,
+            .flags = UDMABUF_FLAGS_CLOEXEC,
+            .offset = 0,
+            .size = size
+        };
+        fd = ioctl(sim.udmabuf_fd, UDMABUF_CREATE, &create);
+        if (fd >= 0) {
+            close(memfd);
+            return fd;
+        }
+    }
+
+    return memfd;
+}
+
+static int
+MALI_Sim_IonIoctl(unsigned long request, void *arg)
+{
+    struct ion_allocation_data *allocation_data = (struct ion_allocation_data *)arg;
+    struct ion_handle_data *handle_data = (struct ion_handle_data *)arg;
+    struct ion_fd_data *fd_data = (struct ion_fd_data *)arg;
+    int fd, i;
+
+    switch (request) {
+    case ION_IOC_ALLOC:
+        fd = MALI_Sim_Allocate(allocation_data->len);
+        if (fd < 0)
+            return -1;
+
+        SDL_AtomicLock(&sim.lock);
+        for (i = 0; i < MALI_SIM_MAX_BUFFERS && sim.buffers[i] >= 0; i++) {
+        }
+        if (i < MALI_SIM_MAX_BUFFERS)
+            sim.buffers[i] = fd;
+        SDL_AtomicUnlock(&sim.lock);
+
+        if (i == MALI_SIM_MAX_BUFFERS) {
+            close(fd);
+            errno = ENOMEM;
+            return -1;
+        }
+        allocation_data->handle = i + 1;
+        return 0;
+
+    case ION_IOC_SHARE:
+    case ION_IOC_MAP:
+        i = fd_data->handle - 1;
+        fd = -1;
+        SDL_AtomicLock(&sim.lock);
+        if (i >= 0 && i < MALI_SIM_MAX_BUFFERS && sim.buffers[i] >= 0)
+            fd = fcntl(sim.buffers[i], F_DUPFD_CLOEXEC, 0);
+        else
+            errno = EINVAL;
+        SDL_AtomicUnlock(&sim.lock);
+
+        fd_data->fd = fd;
+        return (fd < 0) ? -1 : 0;
+
+    case ION_IOC_FREE:
+        i = handle_data->handle - 1;
+        fd = -1;
+        SDL_AtomicLock(&sim.lock);
+        if (i >= 0 && i < MALI_SIM_MAX_BUFFERS) {
+            fd = sim.buffers[i];
+            sim.buffers[i] = -1;
+        }
+        SDL_AtomicUnlock(&sim.lock);
+
+        if (fd < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        /* Exported descriptors keep the memory around, as with ION */
+        close(fd);
+        return 0;
+
+    default:
+        errno = ENOTTY;
+        return -1;
+    }
+}
+
+/*****************************************************************************/
+/* Device nodes                                                              */
+/*****************************************************************************/
+
+/*
+ * SDL_MALI_SIM_SCANOUT: "1" copies every frame the blitter presents into the
+ * simulated framebuffer, at the cost of a readback. Defaults to "0".
+ */
+void
+MALI_Sim_Init(void)
+{
+    int i;
+
+    /* Mesa picks its platform from the environment, there's no native display to go by */
+    SDL_setenv("EGL_PLATFORM", "surfaceless", 0);
+
+    if (sim.initialized)
+        return;
+
+    for (i = 0; i < MALI_SIM_MAX_FDS; i++) {
+        sim.fds[i].fd = -1;
+    }
+    for (i = 0; i < MALI_SIM_MAX_BUFFERS; i++) {
+        sim.buffers[i] = -1;
+    }
+
+    sim.udmabuf_fd = open("/dev/udmabuf", O_RDWR | O_CLOEXEC);
+    MALI_Sim_InitFb();
+    sim.epoch = MALI_Sim_Now();
+    sim.scanout = MALI_GetHintInt("SDL_MALI_SIM_SCANOUT", 0) != 0;
+    sim.initialized = SDL_TRUE;
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Simulating a %ux%u display, %s buffers",
+                sim.vinfo.xres, sim.vinfo.yres, (sim.udmabuf_fd >= 0) ? "udmabuf" : "memfd");
+}
+
+static MALI_SimDevice
+MALI_Sim_GetDevice(int fd)
+{
+    MALI_SimDevice device = MALI_SIM_NONE;
+    int i;
+
+    SDL_AtomicLock(&sim.lock);
+    for (i = 0; i < MALI_SIM_MAX_FDS; i++) {
+        if (sim.fds[i].fd == fd && fd >= 0) {
+            device = sim.fds[i].device;
+            break;
+        }
+    }
+    SDL_AtomicUnlock(&sim.lock);
+
+    return device;
+}
+
+int
+MALI_Sim_Open(const char *path, int flags)
+{
+    MALI_SimDevice device;
+    int fd, i;
+
+    if (SDL_strcmp(path, "/dev/fb0") == 0) {
+        device = MALI_SIM_FB;
+        fd = fcntl(sim.fb_fd, F_DUPFD_CLOEXEC, 0);
+    } else if (SDL_strcmp(path, "/dev/ion") == 0) {
+        device = MALI_SIM_ION;
+        fd = open("/dev/null", O_RDWR | O_CLOEXEC);
+    } else {
+        return open(path, flags, 0);
+    }
+
+    if (fd < 0)
+        return -1;
+
+    SDL_AtomicLock(&sim.lock);
+    for (i = 0; i < MALI_SIM_MAX_FDS && sim.fds[i].fd >= 0; i++) {
+    }
+    if (i < MALI_SIM_MAX_FDS) {
+        sim.fds[i].fd = fd;
+        sim.fds[i].device = device;
+    }
+    SDL_AtomicUnlock(&sim.lock);
+
+    if (i == MALI_SIM_MAX_FDS) {
+        close(fd);
+        errno = EMFILE;
+        return -1;
+    }
+
+    return fd;
+}
+
+int
+MALI_Sim_Ioctl(int fd, unsigned long request, void *arg)
+{
+    switch (MALI_Sim_GetDevice(fd)) {
+    case MALI_SIM_FB:
+        return MALI_Sim_FbIoctl(request, arg);
+    case MALI_SIM_ION:
+        return MALI_Sim_IonIoctl(request, arg);
+    default:
+        return ioctl(fd, request, arg);
+    }
+}
+
+int
+MALI_Sim_Close(int fd)
+{
+    int i;
+
+    SDL_AtomicLock(&sim.lock);
+    for (i = 0; i < MALI_SIM_MAX_FDS; i++) {
+        if (sim.fds[i].fd == fd && fd >= 0) {
+            sim.fds[i].fd = -1;
+            break;
+        }
+    }
+    SDL_AtomicUnlock(&sim.lock);
+
+    return close(fd);
+}
+
+/*****************************************************************************/
+/* Blob entry points                                                         */
+/*****************************************************************************/
+
+NativePixmapType
+MALI_Sim_CreatePixmapMapping(mali_pixmap *pixmap)
+{
+    Uint8 *map;
+    int i;
+
+    map = mmap(NULL, pixmap->planes[0].size, PROT_READ | PROT_WRITE, MAP_SHARED, pixmap->handles[0], pixmap->planes[0].offset);
+    if (map == MAP_FAILED)
+        return (NativePixmapType)-1;
+
+    SDL_AtomicLock(&sim.lock);
+    for (i = 0; i < MALI_SIM_MAX_PIXMAPS && sim.pixmaps[i].pixmap; i++) {
+    }
+    if (i < MALI_SIM_MAX_PIXMAPS) {
+        sim.pixmaps[i].pixmap = pixmap;
+        sim.pixmaps[i].map = map;
+    }
+    SDL_AtomicUnlock(&sim.lock);
+
+    if (i == MALI_SIM_MAX_PIXMAPS) {
+        munmap(map, pixmap->planes[0].size);
+        return (NativePixmapType)-1;
+    }
+
+    return (NativePixmapType)(intptr_t)i;
+}
+
+NativePixmapType
+MALI_Sim_DestroyPixmapMapping(int id)
+{
+    MALI_SimPixmap pixmap;
+
+    if (id < 0 || id >= MALI_SIM_MAX_PIXMAPS)
+        return (NativePixmapType)-1;
+
+    SDL_AtomicLock(&sim.lock);
+    pixmap = sim.pixmaps[id];
+    SDL_zero(sim.pixmaps[id]);
+    SDL_AtomicUnlock(&sim.lock);
+
+    if (pixmap.pixmap)
+        munmap(pixmap.map, pixmap.pixmap->planes[0].size);
+
+    return (NativePixmapType)(intptr_t)id;
+}
+
+/* Mappings only change while their buffer is unused, looking one up needs no lock. */
+static MALI_SimPixmap *
+MALI_Sim_GetPixmap(NativePixmapType handle)
+{
+    int id = (int)(intptr_t)handle;
+
+    if (id < 0 || id >= MALI_SIM_MAX_PIXMAPS || !sim.pixmaps[id].pixmap)
+        return NULL;
+
+    return &sim.pixmaps[id];
+}
+
+EGLSurface
+MALI_Sim_CreatePixmapSurface(_THIS, NativePixmapType handle, const EGLint *attribs)
+{
+    MALI_SimPixmap *pixmap = MALI_Sim_GetPixmap(handle);
+    EGLint pbuffer_attribs[16];
+    int i = 0;
+
+    if (!pixmap)
+        return EGL_NO_SURFACE;
+
+    pbuffer_attribs[i++] = EGL_WIDTH;
+    pbuffer_attribs[i++] = pixmap->pixmap->width;
+    pbuffer_attribs[i++] = EGL_HEIGHT;
+    pbuffer_attribs[i++] = pixmap->pixmap->height;
+    for (; attribs && *attribs != EGL_NONE && i < (int)SDL_arraysize(pbuffer_attribs) - 2; attribs += 2) {
+        pbuffer_attribs[i++] = attribs[0];
+        pbuffer_attribs[i++] = attribs[1];
+    }
+    pbuffer_attribs[i] = EGL_NONE;
+
+    return _this->egl_data->eglCreatePbufferSurface(_this->egl_data->egl_display, _this->egl_data->egl_config, pbuffer_attribs);
+}
+
+/* Copies a finished frame into its buffer, where the blob would have rendered it directly. */
+void
+MALI_Sim_ResolvePixmap(_THIS, MALI_EGL_Surface *surf)
+{
+    MALI_SimPixmap *pixmap = MALI_Sim_GetPixmap(surf->pixmap_handle);
+    GLint framebuffer = 0;
+    int width, height;
+
+    if (!pixmap)
+        return;
+
+    if (!sim.glReadPixels) {
+        sim.glGetIntegerv = SDL_GL_GetProcAddress("glGetIntegerv");
+        sim.glBindFramebuffer = SDL_GL_GetProcAddress("glBindFramebuffer");
+        sim.glReadPixels = SDL_GL_GetProcAddress("glReadPixels");
+        if (!sim.glGetIntegerv || !sim.glBindFramebuffer || !sim.glReadPixels) {
+            sim.glReadPixels = NULL;
+            return;
+        }
+    }
+
+    width = pixmap->pixmap->width;
+    height = pixmap->pixmap->height;
+    if (!MALI_Sim_Reserve(&sim.staging, &sim.staging_size, (size_t)width * height * 4))
+        return;
+
+    /* The frame is in the surface, whatever the application left bound */
+    sim.glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    if (framebuffer != 0)
+        sim.glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    sim.glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, sim.staging);
+    if (framebuffer != 0)
+        sim.glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    MALI_Sim_StoreRows(sim.staging, width, height, pixmap->map, pixmap->pixmap->planes[0].stride, pixmap->pixmap->drm_fourcc.format);
+}
+
+/*****************************************************************************/
+/* Blitter                                                                   */
+/*****************************************************************************/
+
+EGLSurface
+MALI_Sim_CreateWindowSurface(MALI_Blitter *blitter, EGLConfig config, NativeWindowType nw)
+{
+    const fbdev_window_s *window = (const fbdev_window_s *)(uintptr_t)nw;
+    EGLint attribs[] = {
+        EGL_WIDTH, window->width,
+        EGL_HEIGHT, window->height,
+        EGL_NONE
+    };
+
+    return blitter->eglCreatePbufferSurface(blitter->egl_display, config, attribs);
+}
+
+void
+MALI_Sim_InitTexture(MALI_Blitter *blitter, MALI_EGL_Surface *surf)
+{
+    GLenum format = (surf->pixmap.drm_fourcc.format == DRM_FORMAT_RGB565) ? GL_RGB : GL_BGRA_EXT;
+    GLenum type = (surf->pixmap.drm_fourcc.format == DRM_FORMAT_RGB565) ? GL_UNSIGNED_SHORT_5_6_5 : GL_UNSIGNED_BYTE;
+
+    blitter->glGenTextures(1, &surf->texture);
+    blitter->glActiveTexture(GL_TEXTURE0);
+    blitter->glBindTexture(GL_TEXTURE_2D, surf->texture);
+    blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    blitter->glTexImage2D(GL_TEXTURE_2D, 0, format, surf->pixmap.width, surf->pixmap.height, 0, format, type, NULL);
+}
+
+/* Brings the texture of a buffer up to date, a dma-buf import would have shown its memory directly. */
+void
+MALI_Sim_UploadTexture(MALI_Blitter *blitter, MALI_EGL_Surface *surf)
+{
+    MALI_SimPixmap *pixmap = MALI_Sim_GetPixmap(surf->pixmap_handle);
+    SDL_bool rgb565 = (surf->pixmap.drm_fourcc.format == DRM_FORMAT_RGB565);
+    int bpp = rgb565 ? 2 : 4;
+
+    if (!pixmap)
+        return;
+
+    blitter->glActiveTexture(GL_TEXTURE0);
+    blitter->glBindTexture(GL_TEXTURE_2D, surf->texture);
+    blitter->glPixelStorei(GL_UNPACK_ALIGNMENT, bpp);
+    blitter->glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, surf->pixmap.planes[0].stride / bpp);
+    blitter->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, surf->pixmap.width, surf->pixmap.height,
+                             rgb565 ? GL_RGB : GL_BGRA_EXT, rgb565 ? GL_UNSIGNED_SHORT_5_6_5 : GL_UNSIGNED_BYTE, pixmap->map);
+    blitter->glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+}
+
+static void
+MALI_Sim_Scanout(MALI_Blitter *blitter)
+{
+    EGLint width = 0, height = 0;
+    size_t size, line_length;
+    __u32 yoffset;
+    int y;
+
+    blitter->eglQuerySurface(blitter->egl_display, blitter->egl_surface, EGL_WIDTH, &width);
+    blitter->eglQuerySurface(blitter->egl_display, blitter->egl_surface, EGL_HEIGHT, &height);
+
+    SDL_AtomicLock(&sim.lock);
+    width = SDL_min(width, (EGLint)sim.vinfo.xres);
+    height = SDL_min(height, (EGLint)sim.vinfo.yres);
+    line_length = sim.vinfo.xres * 4;
+    yoffset = sim.vinfo.yoffset;
+    SDL_AtomicUnlock(&sim.lock);
+
+    size = (size_t)width * height * 4;
+    if (size == 0 || !MALI_Sim_Reserve(&sim.scanout_staging, &sim.scanout_size, size * 2))
+        return;
+
+    blitter->glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, sim.scanout_staging);
+    MALI_Sim_StoreRows(sim.scanout_staging, width, height, sim.scanout_staging + size, (size_t)width * 4, DRM_FORMAT_XRGB8888);
+    for (y = 0; y < height; y++) {
+        if (pwrite(sim.fb_fd, sim.scanout_staging + size + (size_t)y * width * 4, (size_t)width * 4, (off_t)(yoffset + y) * line_length) < 0)
+            break;
+    }
+}
+
+/* A pbuffer swap shows nothing, the blit is waited for and the display's vblank is kept instead. */
+EGLBoolean
+MALI_Sim_SwapBuffers(MALI_Blitter *blitter, int interval)
+{
+    blitter->glFinish();
+
+    if (sim.scanout)
+        MALI_Sim_Scanout(blitter);
+
+    if (interval != 0)
+        MALI_Sim_WaitVblank(SDL_abs(interval));
+
+    return EGL_TRUE;
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_DRIVER_MALI_SIM */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,73 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malisim_h
+#define _SDL_malisim_h
+
+/*
+ * Everything the driver does with the kernel devices and the Mali blob goes
+ * through these, so SDL_VIDEO_DRIVER_MALI_SIM can run it on a desktop Linux
+ * box: ION buffers become memfds (udmabufs where available), /dev/fb0 a
+ * memory or regular file with a timer for vblanks, and pixmap surfaces Mesa
+ * pbuffers, which works with its surfaceless platform and llvmpipe.
+ */
+#if SDL_VIDEO_DRIVER_MALI_SIM
+#define MALI_OpenDevice(path, flags)        MALI_Sim_Open(path, flags)
+#define MALI_DeviceIoctl(fd, request, arg)  MALI_Sim_Ioctl(fd, request, arg)
+#define MALI_CloseDevice(fd)                MALI_Sim_Close(fd)
+#define MALI_PIXMAP_SURFACE_BIT             EGL_PBUFFER_BIT
+#define MALI_WINDOW_SURFACE_BIT             EGL_PBUFFER_BIT
+#else
+#define MALI_OpenDevice(path, flags)        open(path, flags, 0)
+#define MALI_DeviceIoctl(fd, request, arg)  ioctl(fd, request, arg)
+#define MALI_CloseDevice(fd)                close(fd)
+#define MALI_PIXMAP_SURFACE_BIT             EGL_PIXMAP_BIT
+#define MALI_WINDOW_SURFACE_BIT             EGL_WINDOW_BIT
+#endif
+
+#if SDL_VIDEO_DRIVER_MALI_SIM
+
+struct MALI_Blitter;
+struct MALI_EGL_Surface;
+
+extern void MALI_Sim_Init(void);
+extern int MALI_Sim_Open(const char *path, int flags);
+extern int MALI_Sim_Ioctl(int fd, unsigned long request, void *arg);
+extern int MALI_Sim_Close(int fd);
+
+/* Stand-ins for the blob, pixmaps are rendered into pbuffers and read back on swap */
+extern NativePixmapType MALI_Sim_CreatePixmapMapping(mali_pixmap *pixmap);
+extern NativePixmapType MALI_Sim_DestroyPixmapMapping(int id);
+extern EGLSurface MALI_Sim_CreatePixmapSurface(_THIS, NativePixmapType handle, const EGLint *attribs);
+extern void MALI_Sim_ResolvePixmap(_THIS, struct MALI_EGL_Surface *surf);
+
+/* The blitter side, frames are uploaded instead of imported as dma-bufs */
+extern EGLSurface MALI_Sim_CreateWindowSurface(struct MALI_Blitter *blitter, EGLConfig config, NativeWindowType nw);
+extern void MALI_Sim_InitTexture(struct MALI_Blitter *blitter, struct MALI_EGL_Surface *surf);
+extern void MALI_Sim_UploadTexture(struct MALI_Blitter *blitter, struct MALI_EGL_Surface *surf);
+extern EGLBoolean MALI_Sim_SwapBuffers(struct MALI_Blitter *blitter, int interval);
+
+#endif /* SDL_VIDEO_DRIVER_MALI_SIM */
+
+#endif /* _SDL_malisim_h */
+
+/* vi: set ts=4 sw=4 expandtab: */
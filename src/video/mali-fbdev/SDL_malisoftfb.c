@@ -0,0 +1,551 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include <sys/mman.h>
+#include <linux/dma-buf.h>
+
+#include "SDL_cpuinfo.h"
+#include "SDL_hints.h"
+
+#include "SDL_malivideo.h"
+#include "SDL_malisoftfb.h"
+#include "SDL_maliframebuffer.h"
+
+#if defined(__ARM_NEON)
+#define HAVE_NEON_INTRINSICS 1
+#endif
+
+/*
+ * With SDL_BLITTER_DISABLED=1, window surfaces are presented by the CPU: each
+ * update is rotated and scaled with nearest neighbour sampling into a page of
+ * /dev/fb0, which is then flipped to with FBIOPAN_DISPLAY. The window image
+ * keeps its aspect ratio, centered on the screen.
+ *
+ * Rotation follows SDL_ROTATION like the blitter does. OpenGL ES windows
+ * render straight to the framebuffer when it's unrotated. Otherwise they
+ * render into a single window sized pixmap, which is copied out the same way
+ * on every swap once the GPU is done with it.
+ */
+
+/* Screen pixels are written in tiles, so rotated reads stay in the cache */
+#define MALI_SOFTFB_TILE 32
+
+static void
+MALI_SoftFb_Close(MALI_SoftFb *fb)
+{
+    if (fb->map) {
+        munmap(fb->map, fb->map_size);
+        MALI_DeviceIoctl(fb->fd, FBIOPUT_VSCREENINFO, &fb->saved_vinfo);
+        MALI_CloseDevice(fb->fd);
+    }
+    SDL_free(fb->xoff);
+    SDL_free(fb->yoff);
+    SDL_zerop(fb);
+}
+
+static int
+MALI_SoftFb_Open(MALI_SoftFb *fb)
+{
+    struct fb_fix_screeninfo finfo;
+
+    fb->fd = MALI_OpenDevice("/dev/fb0", O_RDWR | O_CLOEXEC);
+    if (fb->fd < 0) {
+        return SDL_SetError("mali-fbdev: Could not open framebuffer device");
+    }
+
+    if (MALI_DeviceIoctl(fb->fd, FBIOGET_VSCREENINFO, &fb->saved_vinfo) < 0) {
+        MALI_CloseDevice(fb->fd);
+        return SDL_SetError("mali-fbdev: Could not get framebuffer information");
+    }
+
+    /* Ask for a second page to flip to, fall back to drawing on screen. */
+    fb->vinfo = fb->saved_vinfo;
+    fb->vinfo.yres_virtual = fb->vinfo.yres * 2;
+    fb->vinfo.yoffset = 0;
+    if (MALI_DeviceIoctl(fb->fd, FBIOPUT_VSCREENINFO, &fb->vinfo) < 0 || MALI_DeviceIoctl(fb->fd, FBIOGET_VSCREENINFO, &fb->vinfo) < 0) {
+        fb->vinfo = fb->saved_vinfo;
+    }
+    fb->pages = (fb->vinfo.yres_virtual >= fb->vinfo.yres * 2) ? 2 : 1;
+
+    if (MALI_DeviceIoctl(fb->fd, FBIOGET_FSCREENINFO, &finfo) < 0) {
+        MALI_DeviceIoctl(fb->fd, FBIOPUT_VSCREENINFO, &fb->saved_vinfo);
+        MALI_CloseDevice(fb->fd);
+        return SDL_SetError("mali-fbdev: Could not get framebuffer information");
+    }
+
+    switch (fb->vinfo.bits_per_pixel) {
+    case 32:
+        fb->format = (fb->vinfo.red.offset == 0) ? SDL_PIXELFORMAT_XBGR8888 : SDL_PIXELFORMAT_XRGB8888;
+        break;
+    case 16:
+        fb->format = SDL_PIXELFORMAT_RGB565;
+        break;
+    default:
+        MALI_DeviceIoctl(fb->fd, FBIOPUT_VSCREENINFO, &fb->saved_vinfo);
+        MALI_CloseDevice(fb->fd);
+        return SDL_SetError("mali-fbdev: Unsupported framebuffer depth %u", fb->vinfo.bits_per_pixel);
+    }
+    fb->bpp = fb->vinfo.bits_per_pixel / 8;
+    fb->pitch = finfo.line_length;
+
+    fb->map_size = finfo.smem_len;
+    fb->map = mmap(NULL, fb->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fb->fd, 0);
+    if (fb->map == MAP_FAILED) {
+        fb->map = NULL;
+        MALI_DeviceIoctl(fb->fd, FBIOPUT_VSCREENINFO, &fb->saved_vinfo);
+        MALI_CloseDevice(fb->fd);
+        return SDL_SetError("mali-fbdev: Unable to mmap framebuffer");
+    }
+
+    /* Start out drawing to the page that isn't shown */
+    fb->page = (fb->pages > 1 && fb->vinfo.yoffset == 0) ? 1 : 0;
+    return 0;
+}
+
+/* Fits the rotated window on screen and builds the sampling tables for it. */
+static int
+MALI_SoftFb_Layout(MALI_SoftFb *fb, int w, int h, int pitch, int rotation)
+{
+    const int screen_w = fb->vinfo.xres, screen_h = fb->vinfo.yres;
+    const int rw = (rotation & 1) ? h : w, rh = (rotation & 1) ? w : h;
+    SDL_Rect *vp = &fb->viewport;
+    int i, rx, ry;
+
+    if ((Sint64)rw * screen_h > (Sint64)rh * screen_w) {
+        vp->w = screen_w;
+        vp->h = SDL_max((int)((Sint64)rh * screen_w / rw), 1);
+    } else {
+        vp->w = SDL_max((int)((Sint64)rw * screen_h / rh), 1);
+        vp->h = screen_h;
+    }
+    vp->x = (screen_w - vp->w) / 2;
+    vp->y = (screen_h - vp->h) / 2;
+
+    SDL_free(fb->xoff);
+    SDL_free(fb->yoff);
+    fb->xoff = SDL_malloc(vp->w * sizeof(Uint32));
+    fb->yoff = SDL_malloc(vp->h * sizeof(Uint32));
+    if (!fb->xoff || !fb->yoff) {
+        return SDL_OutOfMemory();
+    }
+
+    /* The rotated image is sampled at (rx, ry), split into what depends on the screen column and row */
+    for (i = 0; i < vp->w; i++) {
+        rx = (int)((Sint64)i * rw / vp->w);
+        switch (rotation) {
+        case 1:  fb->xoff[i] = rx * pitch; break;
+        case 2:  fb->xoff[i] = (w - 1 - rx) * fb->bpp; break;
+        case 3:  fb->xoff[i] = (h - 1 - rx) * pitch; break;
+        default: fb->xoff[i] = rx * fb->bpp; break;
+        }
+    }
+    for (i = 0; i < vp->h; i++) {
+        ry = (int)((Sint64)i * rh / vp->h);
+        switch (rotation) {
+        case 1:  fb->yoff[i] = (w - 1 - ry) * fb->bpp; break;
+        case 2:  fb->yoff[i] = (h - 1 - ry) * pitch; break;
+        case 3:  fb->yoff[i] = ry * fb->bpp; break;
+        default: fb->yoff[i] = ry * pitch; break;
+        }
+    }
+
+    /* Integer scales get by without the tables */
+    fb->scale = 0;
+    for (i = 1; i <= 4; i++) {
+        if (vp->w == rw * i && vp->h == rh * i)
+            fb->scale = i;
+    }
+
+    fb->src_w = w;
+    fb->src_h = h;
+    fb->src_pitch = pitch;
+    fb->rotation = rotation;
+    fb->cleared = 0;
+    return 0;
+}
+
+/* Any rotation and scale, a table lookup per pixel. */
+static void
+MALI_SoftFb_Blit(const MALI_SoftFb *fb, Uint8 *dst, const Uint8 *src, int x0, int y0, int x1, int y1)
+{
+    const Uint8 *row;
+    int tx, ty, tx1, ty1, x, y;
+
+    for (ty = y0; ty < y1; ty += MALI_SOFTFB_TILE) {
+        ty1 = SDL_min(ty + MALI_SOFTFB_TILE, y1);
+        for (tx = x0; tx < x1; tx += MALI_SOFTFB_TILE) {
+            tx1 = SDL_min(tx + MALI_SOFTFB_TILE, x1);
+            for (y = ty; y < ty1; y++) {
+                /* Repeats of the row above are copied in one go afterwards */
+                if (y > 0 && fb->yoff[y] == fb->yoff[y - 1])
+                    continue;
+
+                row = src + fb->yoff[y];
+                if (fb->bpp == 4) {
+                    Uint32 *d = (Uint32 *)(dst + y * fb->pitch);
+                    for (x = tx; x < tx1; x++)
+                        d[x] = *(const Uint32 *)(row + fb->xoff[x]);
+                } else {
+                    Uint16 *d = (Uint16 *)(dst + y * fb->pitch);
+                    for (x = tx; x < tx1; x++)
+                        d[x] = *(const Uint16 *)(row + fb->xoff[x]);
+                }
+            }
+        }
+    }
+}
+
+#if defined(HAVE_NEON_INTRINSICS)
+/* Unscaled 90 and 270 degree rotation of 32-bit pixels, as 4x4 block transposes. */
+static void
+MALI_SoftFb_Rotate_NEON(const MALI_SoftFb *fb, Uint8 *dst, const Uint8 *src, int x1, int y1)
+{
+    /* Rotating by 90 degrees reads source rows backwards, which flips the transposed block */
+    const int flip = (fb->rotation == 1);
+    uint32x4_t r[4], c[4];
+    uint32x4x2_t t01, t23;
+    int tx, ty, tx1, ty1, x, y, k;
+
+    for (ty = 0; ty < y1; ty += MALI_SOFTFB_TILE) {
+        ty1 = SDL_min(ty + MALI_SOFTFB_TILE, y1);
+        for (tx = 0; tx < x1; tx += MALI_SOFTFB_TILE) {
+            tx1 = SDL_min(tx + MALI_SOFTFB_TILE, x1);
+            for (y = ty; y < ty1; y += 4) {
+                for (x = tx; x < tx1; x += 4) {
+                    for (k = 0; k < 4; k++)
+                        r[k] = vld1q_u32((const Uint32 *)(src + fb->xoff[x + k] + fb->yoff[y + (flip ? 3 : 0)]));
+
+                    t01 = vtrnq_u32(r[0], r[1]);
+                    t23 = vtrnq_u32(r[2], r[3]);
+                    c[0] = vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0]));
+                    c[1] = vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1]));
+                    c[2] = vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0]));
+                    c[3] = vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1]));
+
+                    for (k = 0; k < 4; k++)
+                        vst1q_u32((Uint32 *)(dst + (y + k) * fb->pitch) + x, c[flip ? 3 - k : k]);
+                }
+            }
+        }
+    }
+}
+
+/* Same for 16-bit pixels. */
+static void
+MALI_SoftFb_Rotate16_NEON(const MALI_SoftFb *fb, Uint8 *dst, const Uint8 *src, int x1, int y1)
+{
+    const int flip = (fb->rotation == 1);
+    uint16x4_t r[4], c[4];
+    uint16x4x2_t t01, t23;
+    uint32x2x2_t u02, u13;
+    int tx, ty, tx1, ty1, x, y, k;
+
+    for (ty = 0; ty < y1; ty += MALI_SOFTFB_TILE) {
+        ty1 = SDL_min(ty + MALI_SOFTFB_TILE, y1);
+        for (tx = 0; tx < x1; tx += MALI_SOFTFB_TILE) {
+            tx1 = SDL_min(tx + MALI_SOFTFB_TILE, x1);
+            for (y = ty; y < ty1; y += 4) {
+                for (x = tx; x < tx1; x += 4) {
+                    for (k = 0; k < 4; k++)
+                        r[k] = vld1_u16((const Uint16 *)(src + fb->xoff[x + k] + fb->yoff[y + (flip ? 3 : 0)]));
+
+                    t01 = vtrn_u16(r[0], r[1]);
+                    t23 = vtrn_u16(r[2], r[3]);
+                    u02 = vtrn_u32(vreinterpret_u32_u16(t01.val[0]), vreinterpret_u32_u16(t23.val[0]));
+                    u13 = vtrn_u32(vreinterpret_u32_u16(t01.val[1]), vreinterpret_u32_u16(t23.val[1]));
+                    c[0] = vreinterpret_u16_u32(u02.val[0]);
+                    c[1] = vreinterpret_u16_u32(u13.val[0]);
+                    c[2] = vreinterpret_u16_u32(u02.val[1]);
+                    c[3] = vreinterpret_u16_u32(u13.val[1]);
+
+                    for (k = 0; k < 4; k++)
+                        vst1_u16((Uint16 *)(dst + (y + k) * fb->pitch) + x, c[flip ? 3 - k : k]);
+                }
+            }
+        }
+    }
+}
+
+static SDL_INLINE void
+MALI_SoftFb_Repeat32_NEON(Uint8 *dst, uint32x4_t v, int count)
+{
+    const uint32x4x2_t v2 = { { v, v } };
+    const uint32x4x3_t v3 = { { v, v, v } };
+    const uint32x4x4_t v4 = { { v, v, v, v } };
+
+    switch (count) {
+    case 2:  vst2q_u32((Uint32 *)dst, v2); break;
+    case 3:  vst3q_u32((Uint32 *)dst, v3); break;
+    case 4:  vst4q_u32((Uint32 *)dst, v4); break;
+    default: vst1q_u32((Uint32 *)dst, v); break;
+    }
+}
+
+static SDL_INLINE void
+MALI_SoftFb_Repeat16_NEON(Uint8 *dst, uint16x8_t v, int count)
+{
+    const uint16x8x2_t v2 = { { v, v } };
+    const uint16x8x3_t v3 = { { v, v, v } };
+    const uint16x8x4_t v4 = { { v, v, v, v } };
+
+    switch (count) {
+    case 2:  vst2q_u16((Uint16 *)dst, v2); break;
+    case 3:  vst3q_u16((Uint16 *)dst, v3); break;
+    case 4:  vst4q_u16((Uint16 *)dst, v4); break;
+    default: vst1q_u16((Uint16 *)dst, v); break;
+    }
+}
+
+/*
+ * Integer upscaling, unrotated or by 180 degrees, which also covers unscaled
+ * 180 degree rotation. Every source pixel is stored repeated across the
+ * scale with interleaving stores, only the first of each repeated row is
+ * written. Returns the screen columns done.
+ */
+static int
+MALI_SoftFb_Scale_NEON(const MALI_SoftFb *fb, Uint8 *dst, const Uint8 *src)
+{
+    const int flip = (fb->rotation == 2), scale = fb->scale;
+    const int lanes = 16 / fb->bpp, width = fb->src_w & ~(lanes - 1);
+    const Uint8 *row, *s;
+    uint32x4_t v32;
+    uint16x8_t v16;
+    Uint8 *d;
+    int x, y;
+
+    for (y = 0; y < fb->viewport.h; y += scale) {
+        row = src + fb->yoff[y];
+        d = dst + y * fb->pitch;
+        for (x = 0; x < width; x += lanes, d += lanes * scale * fb->bpp) {
+            /* Flipped rows are read from their end, a vector at a time */
+            s = row + (flip ? fb->src_w - lanes - x : x) * fb->bpp;
+            if (fb->bpp == 4) {
+                v32 = vld1q_u32((const Uint32 *)s);
+                if (flip) {
+                    v32 = vrev64q_u32(v32);
+                    v32 = vcombine_u32(vget_high_u32(v32), vget_low_u32(v32));
+                }
+                MALI_SoftFb_Repeat32_NEON(d, v32, scale);
+            } else {
+                v16 = vld1q_u16((const Uint16 *)s);
+                if (flip) {
+                    v16 = vrev64q_u16(v16);
+                    v16 = vcombine_u16(vget_high_u16(v16), vget_low_u16(v16));
+                }
+                MALI_SoftFb_Repeat16_NEON(d, v16, scale);
+            }
+        }
+    }
+
+    return width * scale;
+}
+#endif
+
+static void
+MALI_SoftFb_Present(MALI_SoftFb *fb, const Uint8 *src)
+{
+    const SDL_Rect *vp = &fb->viewport;
+    Uint8 *page = fb->map + (size_t)fb->page * fb->vinfo.yres * fb->pitch;
+    Uint8 *dst = page + vp->y * fb->pitch + vp->x * fb->bpp;
+    int x_done = 0, y_done = 0, y;
+
+    /* The borders around the window only need clearing once per page */
+    if (fb->cleared < fb->pages) {
+        SDL_memset(page, 0, (size_t)fb->vinfo.yres * fb->pitch);
+        fb->cleared++;
+    }
+
+    if (fb->scale == 1 && fb->rotation == 0) {
+        for (y = 0; y < vp->h; y++)
+            SDL_memcpy(dst + y * fb->pitch, src + y * fb->src_pitch, vp->w * fb->bpp);
+        x_done = vp->w;
+        y_done = vp->h;
+    }
+#if defined(HAVE_NEON_INTRINSICS)
+    else if (fb->scale == 1 && (fb->rotation & 1) && SDL_HasNEON()) {
+        x_done = vp->w & ~3;
+        y_done = vp->h & ~3;
+        if (fb->bpp == 4)
+            MALI_SoftFb_Rotate_NEON(fb, dst, src, x_done, y_done);
+        else
+            MALI_SoftFb_Rotate16_NEON(fb, dst, src, x_done, y_done);
+    } else if (fb->scale && (fb->rotation & 1) == 0 && SDL_HasNEON()) {
+        x_done = MALI_SoftFb_Scale_NEON(fb, dst, src);
+        y_done = vp->h;
+    }
+#endif
+
+    /* Whatever the fast paths left over */
+    MALI_SoftFb_Blit(fb, dst, src, x_done, 0, vp->w, vp->h);
+    MALI_SoftFb_Blit(fb, dst, src, 0, y_done, x_done, vp->h);
+
+    /* Upscaled rows repeat the one above */
+    for (y = 1; y < vp->h; y++) {
+        if (fb->yoff[y] == fb->yoff[y - 1])
+            SDL_memcpy(dst + y * fb->pitch, dst + (y - 1) * fb->pitch, vp->w * fb->bpp);
+    }
+
+    if (fb->pages > 1) {
+        fb->vinfo.yoffset = fb->page * fb->vinfo.yres;
+        if (MALI_DeviceIoctl(fb->fd, FBIOPAN_DISPLAY, &fb->vinfo) < 0) {
+            /* Flipping isn't supported after all, keep drawing on screen */
+            fb->vinfo.yoffset = 0;
+            fb->pages = 1;
+            fb->page = 0;
+            fb->cleared = 0;
+            return;
+        }
+        fb->page ^= 1;
+    }
+}
+
+int
+MALI_Soft_CreateWindowFramebuffer(_THIS, SDL_Window *window, Uint32 *format, void **pixels, int *pitch)
+{
+    SDL_WindowData *windata = (SDL_WindowData *)window->driverdata;
+    SDL_DisplayData *displaydata = SDL_GetDisplayForWindow(window)->driverdata;
+    MALI_SoftFb *fb = &displaydata->softfb;
+
+    MALI_Soft_DestroyWindowFramebuffer(_this, window);
+
+    if (!fb->map && MALI_SoftFb_Open(fb) < 0) {
+        return -1;
+    }
+
+    windata->soft_pitch = MALI_ALIGN(window->w * fb->bpp, 16);
+    windata->soft_pixels = SDL_calloc(window->h, windata->soft_pitch);
+    if (!windata->soft_pixels) {
+        return SDL_OutOfMemory();
+    }
+
+    if (MALI_SoftFb_Layout(fb, window->w, window->h, windata->soft_pitch, displaydata->rotation) < 0) {
+        MALI_Soft_DestroyWindowFramebuffer(_this, window);
+        return -1;
+    }
+
+    *format = fb->format;
+    *pixels = windata->soft_pixels;
+    *pitch = windata->soft_pitch;
+    return 0;
+}
+
+int
+MALI_Soft_UpdateWindowFramebuffer(_THIS, SDL_Window *window, const SDL_Rect *rects, int numrects)
+{
+    SDL_WindowData *windata = (SDL_WindowData *)window->driverdata;
+    SDL_DisplayData *displaydata = SDL_GetDisplayForWindow(window)->driverdata;
+
+    if (!windata->soft_pixels || !displaydata->softfb.map) {
+        return SDL_SetError("mali-fbdev: Window framebuffer is not mapped");
+    }
+
+    /* Flipping means every page has to be redrawn in full anyway */
+    MALI_SoftFb_Present(&displaydata->softfb, windata->soft_pixels);
+    return 0;
+}
+
+void
+MALI_Soft_DestroyWindowFramebuffer(_THIS, SDL_Window *window)
+{
+    SDL_WindowData *windata = (SDL_WindowData *)window->driverdata;
+    SDL_DisplayData *displaydata = SDL_GetDisplayForWindow(window)->driverdata;
+
+    if (!windata || !windata->soft_pixels)
+        return;
+
+    SDL_free(windata->soft_pixels);
+    windata->soft_pixels = NULL;
+
+    /* Hand the screen back as it was, for OpenGL ES or the console */
+    MALI_SoftFb_Close(&displaydata->softfb);
+}
+
+int
+MALI_Soft_GLES_Init(_THIS, SDL_Window *window)
+{
+    SDL_DisplayData *displaydata = SDL_GetDisplayForWindow(window)->driverdata;
+    MALI_SoftFb *fb = &displaydata->softfb;
+
+    if (!fb->map && MALI_SoftFb_Open(fb) < 0) {
+        return -1;
+    }
+
+    /* Pixmaps are ARGB8888 or RGB565, copied out as they are */
+    if (fb->format != SDL_PIXELFORMAT_XRGB8888 && fb->format != SDL_PIXELFORMAT_RGB565) {
+        MALI_SoftFb_Close(fb);
+        return SDL_SetError("mali-fbdev: Can't present OpenGL ES to a %s framebuffer", SDL_GetPixelFormatName(fb->format));
+    }
+    return 0;
+}
+
+int
+MALI_Soft_GLES_SwapWindow(_THIS, SDL_Window *window)
+{
+    SDL_WindowData *windata = (SDL_WindowData *)window->driverdata;
+    SDL_DisplayData *displaydata = SDL_GetDisplayForWindow(window)->driverdata;
+    MALI_SoftFb *fb = &displaydata->softfb;
+    MALI_EGL_Surface *surf = &windata->surface[windata->back_buffer];
+    const int pitch = surf->pixmap.planes[0].stride;
+
+    if (!fb->map || surf->dmabuf_fd < 0) {
+        return SDL_SetError("mali-fbdev: Window has no backing ION buffers");
+    }
+
+    /* There's a single buffer, the frame has to be done before it's read */
+    windata->glFinish();
+#if SDL_VIDEO_DRIVER_MALI_SIM
+    MALI_Sim_ResolvePixmap(_this, surf);
+#endif
+
+    if (!surf->map && MALI_MapBuffer(displaydata, surf) < 0) {
+        return -1;
+    }
+    if (windata->bytes_per_pixel != fb->bpp) {
+        return SDL_SetError("mali-fbdev: Window buffers don't match the framebuffer depth");
+    }
+
+    if (fb->src_w != surf->pixmap.width || fb->src_h != surf->pixmap.height ||
+        fb->src_pitch != pitch || fb->rotation != displaydata->rotation) {
+        if (MALI_SoftFb_Layout(fb, surf->pixmap.width, surf->pixmap.height, pitch, displaydata->rotation) < 0) {
+            return -1;
+        }
+    }
+
+    MALI_SyncBuffer(surf, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+    MALI_SoftFb_Present(fb, surf->map);
+    MALI_SyncBuffer(surf, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+    return 0;
+}
+
+void
+MALI_Soft_GLES_Quit(_THIS, SDL_Window *window)
+{
+    SDL_DisplayData *displaydata = SDL_GetDisplayForWindow(window)->driverdata;
+
+    MALI_SoftFb_Close(&displaydata->softfb);
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+/* vi: set ts=4 sw=4 expandtab: */
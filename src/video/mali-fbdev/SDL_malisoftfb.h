@@ -0,0 +1,62 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malisoftfb_h
+#define _SDL_malisoftfb_h
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include <linux/fb.h>
+
+#include "../SDL_sysvideo.h"
+
+/* /dev/fb0 mapped for CPU presentation, used when the blitter is disabled. */
+typedef struct MALI_SoftFb
+{
+    int fd;
+    Uint8 *map;
+    size_t map_size;
+    struct fb_var_screeninfo vinfo, saved_vinfo;
+    int pitch, bpp;
+    Uint32 format;
+    int pages, page;
+    int cleared;            /* pages whose borders are clear for the current viewport */
+
+    /* Where the window lands on screen, and the source offset of every screen column and row in it */
+    SDL_Rect viewport;
+    int src_w, src_h, src_pitch, rotation;
+    int scale;              /* integer scale of the viewport, 0 when it isn't one */
+    Uint32 *xoff, *yoff;
+} MALI_SoftFb;
+
+extern int MALI_Soft_CreateWindowFramebuffer(_THIS, SDL_Window *window, Uint32 *format, void **pixels, int *pitch);
+extern int MALI_Soft_UpdateWindowFramebuffer(_THIS, SDL_Window *window, const SDL_Rect *rects, int numrects);
+extern void MALI_Soft_DestroyWindowFramebuffer(_THIS, SDL_Window *window);
+extern int MALI_Soft_GLES_Init(_THIS, SDL_Window *window);
+extern int MALI_Soft_GLES_SwapWindow(_THIS, SDL_Window *window);
+extern void MALI_Soft_GLES_Quit(_THIS, SDL_Window *window);
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+#endif /* _SDL_malisoftfb_h */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,194 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_hints.h"
+#include "SDL_timer.h"
+
+#include "SDL_malivideo.h"
+#include "SDL_malistats.h"
+
+#define MALI_STATS_DEFAULT_FRAMES 120
+
+static int
+compare_Uint32(const void *a, const void *b)
+{
+    Uint32 x = *(const Uint32 *)a, y = *(const Uint32 *)b;
+    return (x > y) - (x < y);
+}
+
+/* Sorts samples in place and reduces them to min/avg/p99 in microseconds. */
+static void
+reduce_timings(Uint32 *samples, int count, SDL_MaliTiming *out)
+{
+    Uint64 sum = 0;
+    int i;
+
+    SDL_zerop(out);
+    if (count == 0)
+        return;
+
+    SDL_qsort(samples, count, sizeof(Uint32), compare_Uint32);
+    for (i = 0; i < count; i++)
+        sum += samples[i];
+
+    out->min = samples[0];
+    out->avg = (Uint32)(sum / count);
+    out->p99 = samples[(count * 99 + 99) / 100 - 1];
+}
+
+static Uint32
+to_usec(Uint64 from, Uint64 to, Uint64 freq)
+{
+    return (to > from) ? (Uint32)(((to - from) * 1000000) / freq) : 0;
+}
+
+void
+MALI_StatsInit(MALI_FrameStats *stats)
+{
+    /*
+     * SDL_MALI_STATS_FRAMES: How many of the most recent frames the timing
+     * statistics are taken from.
+     * SDL_MALI_STATS_LOG: If set, log the frame statistics every given
+     * amount of seconds.
+     */
+    stats->size = MALI_GetHintInt("SDL_MALI_STATS_FRAMES", MALI_STATS_DEFAULT_FRAMES);
+    if (stats->size <= 0)
+        stats->size = MALI_STATS_DEFAULT_FRAMES;
+
+    stats->ring = (MALI_FrameTiming *)SDL_calloc(stats->size, sizeof(MALI_FrameTiming));
+    if (stats->ring == NULL)
+        stats->size = 0;
+
+    stats->head = stats->count = 0;
+    stats->log_interval = MALI_GetHintInt("SDL_MALI_STATS_LOG", 0) * SDL_GetPerformanceFrequency();
+    stats->last_log = SDL_GetPerformanceCounter();
+}
+
+void
+MALI_StatsQuit(MALI_FrameStats *stats)
+{
+    SDL_free(stats->ring);
+    stats->ring = NULL;
+    stats->size = stats->head = stats->count = 0;
+}
+
+void
+MALI_StatsCompute(MALI_FrameStats *stats, SDL_MaliFrameStats *out)
+{
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    MALI_FrameTiming *frames;
+    Uint32 *samples;
+    int i, count, start;
+
+    SDL_zerop(out);
+    out->submitted = SDL_AtomicGet(&stats->submitted);
+    out->presented = SDL_AtomicGet(&stats->presented);
+    out->dropped = SDL_AtomicGet(&stats->dropped);
+
+    if (stats->size == 0)
+        return;
+
+    /* Snapshot the ring, oldest frame first, so the blitter isn't held up. */
+    frames = SDL_malloc(stats->size * (sizeof(MALI_FrameTiming) + sizeof(Uint32)));
+    if (frames == NULL)
+        return;
+    samples = (Uint32 *)(frames + stats->size);
+
+    SDL_AtomicLock(&stats->lock);
+    count = stats->count;
+    start = (stats->head - count + stats->size) % stats->size;
+    for (i = 0; i < count; i++)
+        frames[i] = stats->ring[(start + i) % stats->size];
+    SDL_AtomicUnlock(&stats->lock);
+
+    out->samples = count;
+
+    for (i = 0; i < count; i++)
+        samples[i] = to_usec(frames[i].fence, frames[i].signaled, freq);
+    reduce_timings(samples, count, &out->fence);
+
+    for (i = 0; i < count; i++)
+        samples[i] = to_usec(frames[i].blit, frames[i].present, freq);
+    reduce_timings(samples, count, &out->present);
+
+    for (i = 0; i < count; i++)
+        samples[i] = to_usec(frames[i].submit, frames[i].present, freq);
+    reduce_timings(samples, count, &out->latency);
+
+    for (i = 1; i < count; i++)
+        samples[i - 1] = to_usec(frames[i - 1].present, frames[i].present, freq);
+    reduce_timings(samples, (count > 0) ? count - 1 : 0, &out->interval);
+
+    SDL_free(frames);
+}
+
+void
+MALI_StatsRecord(MALI_FrameStats *stats, const MALI_FrameTiming *timing)
+{
+    SDL_MaliFrameStats out;
+
+    if (stats->size == 0)
+        return;
+
+    SDL_AtomicLock(&stats->lock);
+    stats->ring[stats->head] = *timing;
+    stats->head = (stats->head + 1) % stats->size;
+    if (stats->count < stats->size)
+        stats->count++;
+    SDL_AtomicUnlock(&stats->lock);
+
+    if (stats->log_interval == 0 || (timing->present - stats->last_log) < stats->log_interval)
+        return;
+
+    stats->last_log = timing->present;
+    MALI_StatsCompute(stats, &out);
+    SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO,
+        "mali-fbdev: %u submitted, %u presented, %u dropped; "
+        "fence %u/%u/%u us, present %u/%u/%u us, latency %u/%u/%u us, interval %u/%u/%u us (min/avg/p99)",
+        out.submitted, out.presented, out.dropped,
+        out.fence.min, out.fence.avg, out.fence.p99,
+        out.present.min, out.present.avg, out.present.p99,
+        out.latency.min, out.latency.avg, out.latency.p99,
+        out.interval.min, out.interval.avg, out.interval.p99);
+}
+
+int
+SDL_MaliGetFrameStats(SDL_Window *window, SDL_MaliFrameStats *stats)
+{
+    SDL_WindowData *windata = MALI_GetWindowData(window);
+
+    if (!windata) {
+        return -1;
+    }
+    if (!stats) {
+        return SDL_InvalidParamError("stats");
+    }
+
+    MALI_StatsCompute(&windata->stats, stats);
+    return 0;
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,62 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malistats_h
+#define _SDL_malistats_h
+
+#include "SDL_atomic.h"
+#include "SDL_system.h"
+
+/* Timestamps of a single frame going through the swap pipeline. */
+typedef struct MALI_FrameTiming
+{
+    Uint64 submit;      /* MALI_GLES_SwapWindow was called */
+    Uint64 fence;       /* The frame's fence was created */
+    Uint64 signaled;    /* The blitter saw the fence signal */
+    Uint64 completed;   /* The GPU finished the frame, 0 when unknown */
+    Uint64 blit;        /* The blitter started drawing the frame */
+    Uint64 present;     /* eglSwapBuffers returned */
+} MALI_FrameTiming;
+
+/* Frame counters and a ring of the most recent frame timings. */
+typedef struct MALI_FrameStats
+{
+    /* Updated lock-free by both the render and the blitter thread */
+    SDL_atomic_t submitted;
+    SDL_atomic_t presented;
+    SDL_atomic_t dropped;
+
+    /* Written by the blitter thread, read by SDL_MaliGetFrameStats */
+    SDL_SpinLock lock;
+    MALI_FrameTiming *ring;
+    int size, head, count;
+    Uint64 log_interval, last_log;
+} MALI_FrameStats;
+
+extern void MALI_StatsInit(MALI_FrameStats *stats);
+extern void MALI_StatsQuit(MALI_FrameStats *stats);
+extern void MALI_StatsRecord(MALI_FrameStats *stats, const MALI_FrameTiming *timing);
+extern void MALI_StatsCompute(MALI_FrameStats *stats, SDL_MaliFrameStats *out);
+
+#endif /* _SDL_malistats_h */
+
+/* vi: set ts=4 sw=4 expandtab: */
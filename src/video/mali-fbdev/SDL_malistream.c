@@ -0,0 +1,382 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL
+
+#include "SDL_hints.h"
+#include "SDL_video.h"
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <linux/dma-buf.h>
+
+#include "../SDL_egl_c.h"
+#include "SDL_malivideo.h"
+#include "SDL_malistream.h"
+
+#if SDL_VIDEO_DRIVER_MALI_SIM
+#ifndef GL_BGRA_EXT
+#define GL_BGRA_EXT 0x80E1
+#endif
+#ifndef GL_UNPACK_ROW_LENGTH_EXT
+#define GL_UNPACK_ROW_LENGTH_EXT 0x0CF2
+#endif
+#endif
+
+/*
+ * Streaming textures of the GLES2 renderer normally keep their pixels in a
+ * malloc'ed blob, which every unlock copies into the texture, swizzling it on
+ * the way. Here they're locked straight in ION buffers imported as EGLImages
+ * instead, so what the application writes is what the GPU samples.
+ *
+ * The buffers form a ring: each lock moves on to the buffer shown the longest
+ * ago, waiting for the fence set when draws last stopped reading it, and the
+ * unlock makes it the one the texture shows. Locking a part of the texture
+ * first copies the rest over from the buffer shown until then.
+ *
+ * SDL_MALI_STREAM_BUFFERS: Number of buffers per streaming texture, 2 or 3.
+ * "0" keeps streaming textures in system memory. Defaults to 3.
+ */
+
+#define MALI_STREAM_MAX_BUFFERS 3
+
+struct MALI_Stream
+{
+    int num_buffers;
+    int current;                /* buffer the texture shows */
+    int locked;                 /* buffer handed out to the application, -1 when unlocked */
+    int bpp;
+    MALI_EGL_Surface surface[MALI_STREAM_MAX_BUFFERS];
+
+    /* Looked up on creation, from the renderer's context */
+    EGLDisplay egl_display;
+    EGLSyncKHR (EGLAPIENTRY *eglCreateSyncKHR)(EGLDisplay dpy, EGLenum type, const EGLint *attrib_list);
+    EGLBoolean (EGLAPIENTRY *eglDestroySyncKHR)(EGLDisplay dpy, EGLSyncKHR sync);
+    EGLint (EGLAPIENTRY *eglClientWaitSyncKHR)(EGLDisplay dpy, EGLSyncKHR sync, EGLint flags, EGLTimeKHR timeout);
+    EGLImageKHR (EGLAPIENTRY *eglCreateImageKHR)(EGLDisplay dpy, EGLContext ctx, EGLenum target, EGLClientBuffer buffer, const EGLint *attrib_list);
+    EGLBoolean (EGLAPIENTRY *eglDestroyImageKHR)(EGLDisplay dpy, EGLImageKHR image);
+    void (APIENTRY *glGenTextures)(GLsizei n, GLuint *textures);
+    void (APIENTRY *glDeleteTextures)(GLsizei n, const GLuint *textures);
+    void (APIENTRY *glActiveTexture)(GLenum texture);
+    void (APIENTRY *glBindTexture)(GLenum target, GLuint texture);
+    void (APIENTRY *glTexParameteri)(GLenum target, GLenum pname, GLint param);
+    void (APIENTRY *glEGLImageTargetTexture2DOES)(GLenum target, void *image);
+#if SDL_VIDEO_DRIVER_MALI_SIM
+    void (APIENTRY *glPixelStorei)(GLenum pname, GLint param);
+    void (APIENTRY *glTexImage2D)(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels);
+    void (APIENTRY *glTexSubImage2D)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels);
+#endif
+};
+
+static void
+MALI_Stream_Sync(MALI_EGL_Surface *surf, __u64 flags)
+{
+    struct dma_buf_sync sync = { .flags = flags };
+
+    /* The buffers are cached, CPU writes must be flushed before the GPU sees them. */
+    while (ioctl(surf->map_fd, DMA_BUF_IOCTL_SYNC, &sync) < 0 && (errno == EINTR || errno == EAGAIN)) {
+    }
+}
+
+static SDL_bool
+MALI_Stream_LoadFunctions(_THIS, MALI_Stream *stream)
+{
+    stream->egl_display = _this->egl_data->egl_display;
+    stream->eglCreateSyncKHR = _this->egl_data->eglCreateSyncKHR;
+    stream->eglDestroySyncKHR = _this->egl_data->eglDestroySyncKHR;
+    stream->eglClientWaitSyncKHR = _this->egl_data->eglClientWaitSyncKHR;
+    stream->eglCreateImageKHR = SDL_EGL_GetProcAddress(_this, "eglCreateImageKHR");
+    stream->eglDestroyImageKHR = SDL_EGL_GetProcAddress(_this, "eglDestroyImageKHR");
+    stream->glGenTextures = SDL_GL_GetProcAddress("glGenTextures");
+    stream->glDeleteTextures = SDL_GL_GetProcAddress("glDeleteTextures");
+    stream->glActiveTexture = SDL_GL_GetProcAddress("glActiveTexture");
+    stream->glBindTexture = SDL_GL_GetProcAddress("glBindTexture");
+    stream->glTexParameteri = SDL_GL_GetProcAddress("glTexParameteri");
+    stream->glEGLImageTargetTexture2DOES = SDL_GL_GetProcAddress("glEGLImageTargetTexture2DOES");
+#if SDL_VIDEO_DRIVER_MALI_SIM
+    stream->glPixelStorei = SDL_GL_GetProcAddress("glPixelStorei");
+    stream->glTexImage2D = SDL_GL_GetProcAddress("glTexImage2D");
+    stream->glTexSubImage2D = SDL_GL_GetProcAddress("glTexSubImage2D");
+    if (!stream->glPixelStorei || !stream->glTexImage2D || !stream->glTexSubImage2D)
+        return SDL_FALSE;
+#else
+    if (!stream->eglCreateImageKHR || !stream->eglDestroyImageKHR || !stream->glEGLImageTargetTexture2DOES)
+        return SDL_FALSE;
+#endif
+
+    return stream->eglCreateSyncKHR && stream->eglDestroySyncKHR && stream->eglClientWaitSyncKHR &&
+           stream->glGenTextures && stream->glDeleteTextures && stream->glActiveTexture &&
+           stream->glBindTexture && stream->glTexParameteri;
+}
+
+/* Maps a buffer for the CPU and wraps it in a texture, like the blitter does with window buffers. */
+static int
+MALI_Stream_InitBuffer(_THIS, MALI_Stream *stream, SDL_DisplayData *displaydata, MALI_EGL_Surface *surf)
+{
+    struct ion_fd_data map_data = {
+        .handle = surf->dmabuf_handle
+    };
+
+    if (MALI_DeviceIoctl(displaydata->ion_fd, ION_IOC_MAP, &map_data) != 0)
+        return SDL_SetError("mali-fbdev: Unable to map ION buffer");
+
+    surf->map = mmap(NULL, surf->pixmap.planes[0].size, PROT_READ | PROT_WRITE, MAP_SHARED, map_data.fd, 0);
+    if (surf->map == MAP_FAILED) {
+        surf->map = NULL;
+        close(map_data.fd);
+        return SDL_SetError("mali-fbdev: Unable to mmap ION buffer");
+    }
+    surf->map_fd = map_data.fd;
+
+    /* Pooled buffers come back with whatever was drawn in them last */
+    MALI_Stream_Sync(surf, DMA_BUF_SYNC_START | DMA_BUF_SYNC_WRITE);
+    SDL_memset(surf->map, 0, surf->pixmap.planes[0].size);
+    MALI_Stream_Sync(surf, DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE);
+
+    stream->glGenTextures(1, &surf->texture);
+    stream->glActiveTexture(GL_TEXTURE0);
+    stream->glBindTexture(GL_TEXTURE_2D, surf->texture);
+    stream->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    stream->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+#if SDL_VIDEO_DRIVER_MALI_SIM
+    /* No dma-buf import on the desktop, unlocking uploads the buffer instead */
+    stream->glTexImage2D(GL_TEXTURE_2D, 0, GL_BGRA_EXT, surf->pixmap.width, surf->pixmap.height, 0, GL_BGRA_EXT, GL_UNSIGNED_BYTE, surf->map);
+#else
+    {
+        EGLint attribute_list[] = {
+            EGL_WIDTH, surf->pixmap.width,
+            EGL_HEIGHT, surf->pixmap.height,
+            EGL_LINUX_DRM_FOURCC_EXT, surf->pixmap.drm_fourcc.format,
+            EGL_DMA_BUF_PLANE0_OFFSET_EXT, 0,
+            EGL_DMA_BUF_PLANE0_PITCH_EXT, surf->pixmap.planes[0].stride,
+            EGL_DMA_BUF_PLANE0_FD_EXT, surf->dmabuf_fd,
+            EGL_NONE
+        };
+
+        surf->egl_image = stream->eglCreateImageKHR(stream->egl_display, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT,
+                                                    (EGLClientBuffer)NULL, attribute_list);
+        if (surf->egl_image == EGL_NO_IMAGE_KHR)
+            return SDL_EGL_SetError("mali-fbdev: Unable to import streaming texture buffer", "eglCreateImageKHR");
+
+        stream->glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, surf->egl_image);
+    }
+#endif
+
+    return 0;
+}
+
+static void
+MALI_Stream_WaitBuffer(MALI_Stream *stream, MALI_EGL_Surface *surf)
+{
+    if (surf->egl_fence == EGL_NO_SYNC)
+        return;
+
+    stream->eglClientWaitSyncKHR(stream->egl_display, surf->egl_fence, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, EGL_FOREVER_KHR);
+    stream->eglDestroySyncKHR(stream->egl_display, surf->egl_fence);
+    surf->egl_fence = EGL_NO_SYNC;
+}
+
+MALI_Stream *
+MALI_CreateStream(Uint32 format, int width, int height)
+{
+    SDL_VideoDevice *_this = SDL_GetVideoDevice();
+    SDL_DisplayData *displaydata;
+    MALI_Stream *stream;
+    MALI_EGL_Surface *surf;
+    unsigned long stride;
+    Uint32 drm_format;
+    int i, num_buffers;
+
+    if (!_this || SDL_strcmp(_this->name, "mali") != 0 || !_this->egl_data)
+        return NULL;
+
+    /* Only what both SDL and the dma-buf import agree on the layout of */
+    switch (format) {
+    case SDL_PIXELFORMAT_ARGB8888:
+        drm_format = DRM_FORMAT_ARGB8888;
+        break;
+    case SDL_PIXELFORMAT_RGB888:
+        drm_format = DRM_FORMAT_XRGB8888;
+        break;
+    default:
+        return NULL;
+    }
+
+    num_buffers = MALI_GetHintInt("SDL_MALI_STREAM_BUFFERS", MALI_STREAM_MAX_BUFFERS);
+    if (num_buffers <= 0)
+        return NULL;
+    num_buffers = SDL_clamp(num_buffers, 2, MALI_STREAM_MAX_BUFFERS);
+
+#if !SDL_VIDEO_DRIVER_MALI_SIM
+    if (!SDL_EGL_HasExtension(_this, SDL_EGL_DISPLAY_EXTENSION, "EGL_EXT_image_dma_buf_import"))
+        return NULL;
+#endif
+
+    if ((stream = (MALI_Stream *)SDL_calloc(1, sizeof(MALI_Stream))) == NULL)
+        return NULL;
+
+    stream->num_buffers = num_buffers;
+    stream->locked = -1;
+    stream->bpp = SDL_BYTESPERPIXEL(format);
+    for (i = 0; i < MALI_STREAM_MAX_BUFFERS; i++) {
+        stream->surface[i].dmabuf_fd = -1;
+        stream->surface[i].map_fd = -1;
+        stream->surface[i].fence_fd = -1;
+        stream->surface[i].egl_fence = EGL_NO_SYNC;
+        stream->surface[i].egl_image = EGL_NO_IMAGE_KHR;
+    }
+
+    if (!MALI_Stream_LoadFunctions(_this, stream)) {
+        SDL_free(stream);
+        return NULL;
+    }
+
+    displaydata = SDL_GetDisplayDriverData(0);
+    stride = MALI_ALIGN(width * stream->bpp, 64);
+    for (i = 0; i < num_buffers; i++) {
+        surf = &stream->surface[i];
+        surf->pixmap = (mali_pixmap){
+            .width = width,
+            .height = height,
+            .planes[0] = (mali_plane){
+                .stride = stride,
+                .size = stride * height,
+                .offset = 0 },
+            .handles = { -1, -1, -1 },
+            .drm_fourcc = {
+                .format = drm_format
+            }
+        };
+
+        if (MALI_PoolAcquire(displaydata, surf) < 0 || MALI_Stream_InitBuffer(_this, stream, displaydata, surf) < 0) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_RENDER, "mali-fbdev: Streaming texture stays in system memory: %s", SDL_GetError());
+            MALI_DestroyStream(stream);
+            return NULL;
+        }
+    }
+
+    SDL_LogDebug(SDL_LOG_CATEGORY_RENDER, "mali-fbdev: Streaming %dx%d texture through %d ION buffers", width, height, num_buffers);
+    return stream;
+}
+
+void
+MALI_DestroyStream(MALI_Stream *stream)
+{
+    SDL_DisplayData *displaydata = SDL_GetDisplayDriverData(0);
+    MALI_EGL_Surface *surf;
+    int i;
+
+    for (i = 0; i < stream->num_buffers; i++) {
+        surf = &stream->surface[i];
+
+        /* The EGLImage must go before the memory it shows */
+        if (surf->texture)
+            stream->glDeleteTextures(1, &surf->texture);
+        if (surf->egl_image != EGL_NO_IMAGE_KHR)
+            stream->eglDestroyImageKHR(stream->egl_display, surf->egl_image);
+        if (surf->egl_fence != EGL_NO_SYNC)
+            stream->eglDestroySyncKHR(stream->egl_display, surf->egl_fence);
+        if (surf->map) {
+            munmap(surf->map, surf->pixmap.planes[0].size);
+            close(surf->map_fd);
+        }
+        MALI_PoolRelease(displaydata, surf);
+    }
+
+    SDL_free(stream);
+}
+
+void *
+MALI_LockStream(MALI_Stream *stream, const SDL_Rect *rect, int *pitch)
+{
+    MALI_EGL_Surface *prev = &stream->surface[stream->current];
+    MALI_EGL_Surface *surf;
+
+    if (stream->locked < 0) {
+        stream->locked = (stream->current + 1) % stream->num_buffers;
+        surf = &stream->surface[stream->locked];
+
+        /* Draws of the shown buffer were flushed before the lock, they are what the fence covers. */
+        if (prev->egl_fence == EGL_NO_SYNC)
+            prev->egl_fence = stream->eglCreateSyncKHR(stream->egl_display, EGL_SYNC_FENCE_KHR, NULL);
+        MALI_Stream_WaitBuffer(stream, surf);
+
+        MALI_Stream_Sync(surf, DMA_BUF_SYNC_START | DMA_BUF_SYNC_WRITE);
+        if (rect->w != surf->pixmap.width || rect->h != surf->pixmap.height) {
+            /* Only the CPU ever writes these, its view of the shown buffer is up to date. */
+            SDL_memcpy(surf->map, prev->map, surf->pixmap.planes[0].size);
+        }
+    }
+
+    surf = &stream->surface[stream->locked];
+    *pitch = surf->pixmap.planes[0].stride;
+    return (Uint8 *)surf->map + (size_t)rect->y * surf->pixmap.planes[0].stride + rect->x * stream->bpp;
+}
+
+unsigned int
+MALI_UnlockStream(MALI_Stream *stream)
+{
+    MALI_EGL_Surface *surf;
+
+    if (stream->locked < 0)
+        return MALI_GetStreamTexture(stream);
+
+    surf = &stream->surface[stream->locked];
+    MALI_Stream_Sync(surf, DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE);
+
+#if SDL_VIDEO_DRIVER_MALI_SIM
+    stream->glActiveTexture(GL_TEXTURE0);
+    stream->glBindTexture(GL_TEXTURE_2D, surf->texture);
+    stream->glPixelStorei(GL_UNPACK_ALIGNMENT, stream->bpp);
+    stream->glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, surf->pixmap.planes[0].stride / stream->bpp);
+    stream->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, surf->pixmap.width, surf->pixmap.height, GL_BGRA_EXT, GL_UNSIGNED_BYTE, surf->map);
+    stream->glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+#endif
+
+    stream->current = stream->locked;
+    stream->locked = -1;
+    return surf->texture;
+}
+
+unsigned int
+MALI_GetStreamTexture(MALI_Stream *stream)
+{
+    return stream->surface[stream->current].texture;
+}
+
+void
+MALI_SetStreamFilter(MALI_Stream *stream, int filter)
+{
+    int i;
+
+    stream->glActiveTexture(GL_TEXTURE0);
+    for (i = 0; i < stream->num_buffers; i++) {
+        stream->glBindTexture(GL_TEXTURE_2D, stream->surface[i].texture);
+        stream->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        stream->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    }
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL */
+
+/* vi: set ts=4 sw=4 expandtab: */
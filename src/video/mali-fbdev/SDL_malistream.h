@@ -0,0 +1,44 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malistream_h
+#define _SDL_malistream_h
+
+#include "SDL_rect.h"
+
+/*
+ * A streaming texture of the GLES2 renderer backed by a ring of ION buffers
+ * the GPU samples in place, see SDL_malistream.c. The GL texture names are
+ * owned by the stream.
+ */
+typedef struct MALI_Stream MALI_Stream;
+
+extern MALI_Stream *MALI_CreateStream(Uint32 format, int width, int height);
+extern void MALI_DestroyStream(MALI_Stream *stream);
+extern void *MALI_LockStream(MALI_Stream *stream, const SDL_Rect *rect, int *pitch);
+extern unsigned int MALI_UnlockStream(MALI_Stream *stream);
+extern unsigned int MALI_GetStreamTexture(MALI_Stream *stream);
+extern void MALI_SetStreamFilter(MALI_Stream *stream, int filter);
+
+#endif /* _SDL_malistream_h */
+
+/* vi: set ts=4 sw=4 expandtab: */
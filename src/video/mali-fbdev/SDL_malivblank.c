@@ -0,0 +1,214 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include <errno.h>
+#include <time.h>
+
+#include "SDL_hints.h"
+#include "SDL_log.h"
+#include "SDL_timer.h"
+
+#include "SDL_malivideo.h"
+#include "SDL_malivblank.h"
+
+#ifndef FBIO_WAITFORVSYNC
+#define FBIO_WAITFORVSYNC _IOW('F', 0x20, __u32)
+#endif
+
+/* Refresh rate in millihertz from the mode timings, 0 if the driver doesn't fill them in. */
+int
+MALI_GetRefreshRate(const struct fb_var_screeninfo *vinfo)
+{
+    Uint64 htotal = (Uint64)vinfo->left_margin + vinfo->xres + vinfo->right_margin + vinfo->hsync_len;
+    Uint64 vtotal = (Uint64)vinfo->upper_margin + vinfo->yres + vinfo->lower_margin + vinfo->vsync_len;
+    Uint64 refresh;
+
+    if (vinfo->vmode & FB_VMODE_INTERLACED)
+        vtotal /= 2;
+    if (vinfo->vmode & FB_VMODE_DOUBLE)
+        vtotal *= 2;
+
+    if (vinfo->pixclock == 0 || htotal == 0 || vtotal == 0)
+        return 0;
+
+    /* pixclock is the length of a pixel in picoseconds */
+    refresh = 1000000000000000ULL / ((Uint64)vinfo->pixclock * htotal * vtotal);
+
+    /* Some drivers leave bogus timings around, don't trust those */
+    if (refresh < 1000 || refresh > 1000000)
+        return 0;
+
+    return (int)refresh;
+}
+
+static int
+MALI_VblankThread(void *data)
+{
+    MALI_VblankClock *clock = (MALI_VblankClock *)data;
+    __u32 crtc = 0;
+    Uint64 now;
+
+    while (!SDL_AtomicGet(&clock->quit)) {
+        if (MALI_DeviceIoctl(clock->fb_fd, FBIO_WAITFORVSYNC, &crtc) < 0) {
+            /* A blanked display times out, that doesn't mean the ioctl is missing */
+            if (errno == EINTR || errno == ETIMEDOUT)
+                continue;
+
+            SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: FBIO_WAITFORVSYNC failed, timing vblank from swaps");
+            SDL_AtomicSet(&clock->hardware, 0);
+            break;
+        }
+
+        now = SDL_GetPerformanceCounter();
+        SDL_AtomicLock(&clock->lock);
+        clock->last = now;
+        clock->count++;
+        SDL_AtomicUnlock(&clock->lock);
+        SDL_AtomicSet(&clock->hardware, 1);
+    }
+
+    return 0;
+}
+
+/*
+ * SDL_MALI_WAITFORVSYNC: "1" (default) follows vblank with FBIO_WAITFORVSYNC
+ * on a thread of its own, "0" only uses the times eglSwapBuffers returned with
+ * vsync enabled, which is also the fallback when the ioctl isn't supported.
+ *
+ * The clock takes ownership of the framebuffer descriptor.
+ */
+void
+MALI_VblankInit(MALI_VblankClock *clock, int fb_fd, int refresh_mhz)
+{
+    SDL_zerop(clock);
+    clock->interval = SDL_GetPerformanceFrequency() * 1000 / (refresh_mhz ? refresh_mhz : 60000);
+    clock->fb_fd = fb_fd;
+
+    if (MALI_GetHintInt("SDL_MALI_WAITFORVSYNC", 1)) {
+        clock->thread = SDL_CreateThread(MALI_VblankThread, "MALI_VblankThread", clock);
+    }
+
+    if (!clock->thread) {
+        MALI_CloseDevice(clock->fb_fd);
+        clock->fb_fd = -1;
+    }
+}
+
+void
+MALI_VblankQuit(MALI_VblankClock *clock)
+{
+    if (clock->thread) {
+        /* The thread notices within a vblank, or the ioctl's timeout */
+        SDL_AtomicSet(&clock->quit, 1);
+        SDL_WaitThread(clock->thread, NULL);
+        clock->thread = NULL;
+    }
+
+    if (clock->fb_fd >= 0) {
+        MALI_CloseDevice(clock->fb_fd);
+        clock->fb_fd = -1;
+    }
+}
+
+/* A swap with vsync just returned, only used while there's no better source. */
+void
+MALI_VblankRecord(MALI_VblankClock *clock, Uint64 timestamp)
+{
+    if (SDL_AtomicGet(&clock->hardware))
+        return;
+
+    SDL_AtomicLock(&clock->lock);
+    clock->last = timestamp;
+    clock->count++;
+    SDL_AtomicUnlock(&clock->lock);
+}
+
+void
+MALI_VblankGet(MALI_VblankClock *clock, Uint64 *last, Uint64 *interval, Uint32 *count)
+{
+    SDL_AtomicLock(&clock->lock);
+    if (last)
+        *last = clock->last;
+    if (interval)
+        *interval = clock->interval;
+    if (count)
+        *count = clock->count;
+    SDL_AtomicUnlock(&clock->lock);
+}
+
+/*
+ * Paces swaps to one per vblank, as a FIFO swap chain would, while the
+ * mailbox never waits on the blitter. Sleeps until the first vblank after the
+ * one *paced holds, then stores it there. A late swap doesn't sleep, it's
+ * paced from the last vblank so the frames after it don't catch up in a burst.
+ */
+void
+MALI_VblankThrottle(MALI_VblankClock *clock, Uint64 *paced)
+{
+    Uint64 last, interval, now, next, wait_ns;
+    struct timespec ts;
+
+    MALI_VblankGet(clock, &last, &interval, NULL);
+    now = SDL_GetPerformanceCounter();
+
+    /* Before the first vblank, only the interval is known */
+    if (last == 0)
+        last = *paced ? *paced : now;
+
+    /* The vblank measured may come a little after the predicted one *paced holds, it's the same */
+    next = last;
+    if (next <= *paced + interval / 2)
+        next += ((*paced + interval / 2 - next) / interval + 1) * interval;
+
+    if (next <= now) {
+        *paced = last + ((now - last) / interval) * interval;
+        return;
+    }
+
+    wait_ns = (next - now) * 1000000000 / SDL_GetPerformanceFrequency();
+    ts.tv_sec = wait_ns / 1000000000;
+    ts.tv_nsec = wait_ns % 1000000000;
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {
+    }
+
+    *paced = next;
+}
+
+int
+SDL_MaliGetVblank(SDL_Window *window, Uint64 *timestamp, Uint64 *interval)
+{
+    SDL_VideoDisplay *display;
+
+    if (!MALI_GetWindowData(window)) {
+        return -1;
+    }
+
+    display = SDL_GetDisplayForWindow(window);
+    MALI_VblankGet(&((SDL_DisplayData *)display->driverdata)->vblank, timestamp, interval, NULL);
+    return 0;
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+/* vi: set ts=4 sw=4 expandtab: */
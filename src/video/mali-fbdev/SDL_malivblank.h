@@ -0,0 +1,54 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2014 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malivblank_h
+#define _SDL_malivblank_h
+
+#include "SDL_atomic.h"
+#include "SDL_thread.h"
+
+#include <linux/fb.h>
+
+/* When the display's vblanks happen, timestamps in performance counter ticks. */
+typedef struct MALI_VblankClock
+{
+    int fb_fd;              /* -1 without FBIO_WAITFORVSYNC */
+    SDL_Thread *thread;
+    SDL_atomic_t quit;
+    SDL_atomic_t hardware;  /* set once FBIO_WAITFORVSYNC worked */
+
+    SDL_SpinLock lock;
+    Uint64 interval;
+    Uint64 last;
+    Uint32 count;
+} MALI_VblankClock;
+
+extern int MALI_GetRefreshRate(const struct fb_var_screeninfo *vinfo);
+extern void MALI_VblankInit(MALI_VblankClock *clock, int fb_fd, int refresh_mhz);
+extern void MALI_VblankQuit(MALI_VblankClock *clock);
+extern void MALI_VblankRecord(MALI_VblankClock *clock, Uint64 timestamp);
+extern void MALI_VblankGet(MALI_VblankClock *clock, Uint64 *last, Uint64 *interval, Uint32 *count);
+extern void MALI_VblankThrottle(MALI_VblankClock *clock, Uint64 *paced);
+
+#endif /* _SDL_malivblank_h */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -36,15 +36,22 @@
 #endif
 
 #include "SDL_maliopengles.h"
+#include "SDL_malioverlay.h"
+#include "SDL_maliframebuffer.h"
 #include "SDL_malivideo.h"
 #include "SDL_maliblitter.h"
 
 
-//static int
-//MALI_Available(void)
-//{
-//    return 1;
-//}
+/* The fbdev and ION devices of a Mali board, or the stand-ins for them */
+static int
+MALI_Available(void)
+{
+#if SDL_VIDEO_DRIVER_MALI_SIM
+    return 1;
+#else
+    return access("/dev/fb0", R_OK | W_OK) == 0 && access("/dev/ion", R_OK | W_OK) == 0;
+#endif
+}
 
 static void
 MALI_Destroy(SDL_VideoDevice * device)
@@ -60,6 +67,11 @@ MALI_Create()
 {
     SDL_VideoDevice *device;
 
+    /* Leave other machines to the drivers that come after this one */
+    if (!MALI_Available()) {
+        return NULL;
+    }
+
     /* Initialize SDL_VideoDevice structure */
     device = (SDL_VideoDevice *)SDL_calloc(1, sizeof(SDL_VideoDevice));
     if (device == NULL) {
@@ -87,8 +99,13 @@ MALI_Create()
     device->SetWindowFullscreen = MALI_SetWindowFullscreen;
     device->ShowWindow = MALI_ShowWindow;
     device->HideWindow = MALI_HideWindow;
+    device->RaiseWindow = MALI_RaiseWindow;
+    device->SetWindowOpacity = MALI_SetWindowOpacity;
     device->DestroyWindow = MALI_DestroyWindow;
     device->GetWindowWMInfo = MALI_GetWindowWMInfo;
+    device->CreateWindowFramebuffer = MALI_CreateWindowFramebuffer;
+    device->UpdateWindowFramebuffer = MALI_UpdateWindowFramebuffer;
+    device->DestroyWindowFramebuffer = MALI_DestroyWindowFramebuffer;
 
     device->GL_LoadLibrary = MALI_GLES_LoadLibrary;
     device->GL_GetProcAddress = MALI_GLES_GetProcAddress;
@@ -98,6 +115,7 @@ MALI_Create()
     device->GL_SetSwapInterval = MALI_GLES_SetSwapInterval;
     device->GL_GetSwapInterval = MALI_GLES_GetSwapInterval;
     device->GL_SwapWindow = MALI_GLES_SwapWindow;
+    device->GL_GetDrawableSize = MALI_GLES_GetDrawableSize;
     device->GL_DeleteContext = MALI_GLES_DeleteContext;
     device->GL_DefaultProfileConfig = MALI_GLES_DefaultProfileConfig;
 
@@ -109,7 +127,6 @@ MALI_Create()
 VideoBootStrap MALI_bootstrap = {
     "mali",
     "Mali EGL Video Driver",
-    //    MALI_Available,
     MALI_Create
 };
 
@@ -132,18 +149,28 @@ MALI_VideoInit(_THIS)
         return SDL_OutOfMemory();
     }
 
-    fd = open("/dev/fb0", O_RDWR, 0);
+#if SDL_VIDEO_DRIVER_MALI_SIM
+    MALI_Sim_Init();
+#endif
+
+    /* Failures before the display is added clean up here, MALI_VideoQuit only sees added displays */
+    fd = MALI_OpenDevice("/dev/fb0", O_RDWR);
     if (fd < 0) {
+        SDL_free(data);
         return SDL_SetError("mali-fbdev: Could not open framebuffer device");
     }
 
-    data->ion_fd = open("/dev/ion", O_RDWR, 0);
+    data->ion_fd = MALI_OpenDevice("/dev/ion", O_RDWR);
     if (data->ion_fd < 0) {
+        MALI_CloseDevice(fd);
+        SDL_free(data);
         return SDL_SetError("mali-fbdev: Could not open ion device");
     }
 
-    if (ioctl(fd, FBIOGET_VSCREENINFO, &vinfo) < 0) {
-        MALI_VideoQuit(_this);
+    if (MALI_DeviceIoctl(fd, FBIOGET_VSCREENINFO, &vinfo) < 0) {
+        MALI_CloseDevice(fd);
+        MALI_CloseDevice(data->ion_fd);
+        SDL_free(data);
         return SDL_SetError("mali-fbdev: Could not get framebuffer information");
     }
     /* Enable triple buffering */
@@ -153,7 +180,6 @@ MALI_VideoInit(_THIS)
         printf("mali-fbdev: Error setting VSCREENINFO\n");
     }
     */
-    close(fd);
     //    system("setterm -cursor off");
 
     data->native_display.width = vinfo.xres;
@@ -167,13 +193,27 @@ MALI_VideoInit(_THIS)
     if (rotation != NULL)
         data->rotation = SDL_atoi(rotation);
 
+    MALI_PoolInit(&data->pool);
+
+    /* Hands the framebuffer over to the vblank clock */
+    data->refresh_mhz = MALI_GetRefreshRate(&vinfo);
+    MALI_VblankInit(&data->vblank, fd, data->refresh_mhz);
+
     if (!blitter_status || blitter_status[0] != '1') {
         data->blitter = SDL_calloc(1, sizeof(MALI_Blitter));
         data->blitter->_this = _this;
         MALI_BlitterInit(_this, data->blitter);
     } else {
         data->blitter = NULL;
-        data->rotation = 0; // no rotation when the blitter is off!
+
+        /* Rotating costs a CPU copy of every frame without the blitter, only on explicit request. */
+        if (rotation == NULL)
+            data->rotation = 0;
+
+        /* There are no blitter buffers to present window surfaces from, the CPU does it. */
+        _this->CreateWindowFramebuffer = MALI_Soft_CreateWindowFramebuffer;
+        _this->UpdateWindowFramebuffer = MALI_Soft_UpdateWindowFramebuffer;
+        _this->DestroyWindowFramebuffer = MALI_Soft_DestroyWindowFramebuffer;
     }
 
     SDL_zero(current_mode);
@@ -185,8 +225,8 @@ MALI_VideoInit(_THIS)
         current_mode.w = vinfo.yres;
         current_mode.h = vinfo.xres;
     }
-    /* FIXME: Is there a way to tell the actual refresh rate? */
-    current_mode.refresh_rate = 60;
+    /* Panels often run a bit off 60Hz, or at 50Hz, assume 60Hz only if the timings are missing */
+    current_mode.refresh_rate = data->refresh_mhz ? (data->refresh_mhz + 500) / 1000 : 60;
     /* 32 bpp for default */
     //current_mode.format = SDL_PIXELFORMAT_ABGR8888;
     current_mode.format = SDL_PIXELFORMAT_RGBX8888;
@@ -199,6 +239,11 @@ MALI_VideoInit(_THIS)
     display.driverdata = data;
 
     SDL_AddVideoDisplay(&display, SDL_FALSE);
+
+    /* The cursor is drawn by the blitter */
+    if (data->blitter)
+        MALI_InitMouse(_this);
+
 #ifdef SDL_INPUT_LINUXEV
     if (SDL_EVDEV_Init() < 0) {
         return -1;
@@ -211,6 +256,8 @@ MALI_VideoInit(_THIS)
 void
 MALI_VideoQuit(_THIS)
 {
+    SDL_DisplayData *data = (_this->num_displays > 0) ? SDL_GetDisplayDriverData(0) : NULL;
+
     /* Clear the framebuffer and ser cursor on again */
     //    int fd = open("/dev/tty", O_RDWR);
     //    ioctl(fd, VT_ACTIVATE, 5);
@@ -222,6 +269,15 @@ MALI_VideoQuit(_THIS)
     SDL_EVDEV_Quit();
 #endif
 
+    /* The vblank clock and the pool serve every window, only the driver going away stops them */
+    if (data) {
+        /* The blitter trims the pool while idle, it goes first */
+        MALI_BlitterQuit(data->blitter);
+        SDL_free(data->blitter);
+        data->blitter = NULL;
+        MALI_VblankQuit(&data->vblank);
+        MALI_PoolQuit(data);
+    }
 }
 
 void
@@ -237,30 +293,18 @@ MALI_SetDisplayMode(_THIS, SDL_VideoDisplay * display, SDL_DisplayMode * mode)
     return 0;
 }
 
-static EGLSurface *
-MALI_EGL_InitPixmapSurfaces(_THIS, SDL_Window *window)
+/* Allocates the ION buffers and pixmap surfaces of a buffer set, on any thread. */
+static int
+MALI_EGL_AllocBufferSet(_THIS, SDL_WindowData *windowdata, int set, int width, int height)
 {
-    struct ion_fd_data ion_data;
-    struct ion_allocation_data allocation_data;
     SDL_DisplayData *displaydata;
-    SDL_WindowData *windowdata; 
-    int i, io, width, height, attr = 0;
+    MALI_EGL_Surface *surf;
+    unsigned long stride;
+    int i, attr = 0;
     GLint surf_attribs[3] = {};
 
-    windowdata = window->driverdata;
     displaydata = SDL_GetDisplayDriverData(0);
 
-    width = window->w;
-    height = window->h;
-
-    _this->gl_config.multisamplebuffers = 0;
-    _this->gl_config.multisamplesamples = 0;
-    _this->egl_data->egl_surfacetype = EGL_PIXMAP_BIT;
-    if (SDL_EGL_ChooseConfig(_this) != 0) {
-        SDL_SetError("mali-fbdev: Unable to find a suitable EGL config");
-        return EGL_NO_SURFACE;
-    }
-
     /* Did we request a sRGB surface? */
     if (_this->gl_config.framebuffer_srgb_capable) {
         surf_attribs[attr++] = EGL_GL_COLORSPACE_KHR;
@@ -270,21 +314,18 @@ MALI_EGL_InitPixmapSurfaces(_THIS, SDL_Window *window)
     //end the EGL Surface attribute list
     surf_attribs[attr] = EGL_NONE;
 
-    SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Creating Pixmap (%dx%d) buffers", width, height);
-    windowdata->back_buffer = 0;
-    windowdata->queued_buffer = 1;
-    windowdata->front_buffer = 2;
+    SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Creating %d Pixmap (%dx%d) buffers", windowdata->num_buffers, width, height);
 
     // Populate pixmap definitions
-    displaydata->stride = MALI_ALIGN(width * 4, 64);
-    for (i = 0; i < 3; i++) {
-        MALI_EGL_Surface *surf = &windowdata->surface[i];
+    stride = MALI_ALIGN(width * windowdata->bytes_per_pixel, 64);
+    for (i = MALI_SET_FIRST(set); i < MALI_SET_FIRST(set) + windowdata->num_buffers; i++) {
+        surf = &windowdata->surface[i];
         surf->pixmap = (mali_pixmap){
             .width = width,
             .height = height,
             .planes[0] = (mali_plane){
-                .stride = displaydata->stride,
-                .size = displaydata->stride * height,
+                .stride = stride,
+                .size = stride * height,
                 .offset = 0 },
             .planes[1] = (mali_plane){},
             .planes[2] = (mali_plane){},
@@ -292,68 +333,212 @@ MALI_EGL_InitPixmapSurfaces(_THIS, SDL_Window *window)
             .handles = { -1, -1, -1 },
             .drm_fourcc = {
                 .dataspace = 0,
-                .format = DRM_FORMAT_ARGB8888,
+                .format = windowdata->drm_format,
                 .modifier = 0
             }
         };
 
-        /* Allocate framebuffer data */
-        allocation_data = (struct ion_allocation_data){
-            .len = surf->pixmap.planes[0].size,
-            .heap_id_mask = (1 << ION_HEAP_TYPE_DMA),
-            .flags = 1 << ION_FLAG_CACHED
-        };
+        /* Back it with an ION buffer, reusing a released one when possible */
+        surf->egl_surface = EGL_NO_SURFACE;
+        surf->egl_fence = EGL_NO_SYNC;
+        surf->fence_fd = -1;
+        if (MALI_PoolAcquire(displaydata, surf) < 0) {
+            return -1;
+        }
 
-        io = ioctl(displaydata->ion_fd, ION_IOC_ALLOC, &allocation_data);
-        if (io != 0) {
-            SDL_SetError("mali-fbdev: Unable to create backing ION buffers");
-            return EGL_NO_SURFACE;
+#if SDL_VIDEO_DRIVER_MALI_SIM
+        surf->egl_surface = MALI_Sim_CreatePixmapSurface(_this, surf->pixmap_handle, surf_attribs);
+#else
+        surf->egl_surface = _this->egl_data->eglCreatePixmapSurface(
+            _this->egl_data->egl_display,
+            _this->egl_data->egl_config,
+            surf->pixmap_handle,
+            surf_attribs);
+#endif
+        if (surf->egl_surface == EGL_NO_SURFACE) {
+            return SDL_EGL_SetError("mali-fbdev: Unable to create EGL window surface", "eglCreatePixmapSurface");
         }
+    }
 
-        /* Export DMA_BUF handle for the framebuffer */
-        ion_data = (struct ion_fd_data){
-            .handle = allocation_data.handle
-        };
+    return 0;
+}
 
-        io = ioctl(displaydata->ion_fd, ION_IOC_SHARE, &ion_data);
-        if (io != 0) {
-            SDL_SetError("mali-fbdev: Failure exporting ION buffer handle");
-            return EGL_NO_SURFACE;
-        }
+/* Frees whatever was allocated of a buffer set, nobody may be using it anymore. */
+static void
+MALI_EGL_FreeBufferSet(_THIS, SDL_WindowData *windowdata, int set)
+{
+    SDL_DisplayData *displaydata = SDL_GetDisplayDriverData(0);
+    EGLSurface current_surface;
+    EGLContext current_context;
+    MALI_EGL_Surface *surf;
+    int i;
 
-        /* Recall fd and handle for teardown later */
-        surf->dmabuf_handle = allocation_data.handle;
-        surf->dmabuf_fd = ion_data.fd;
-        SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Created ION buffer %d (fd: %d)\n", surf->dmabuf_handle, surf->dmabuf_fd);
+    // Disable current surface
+    current_context = (EGLContext)SDL_GL_GetCurrentContext();
+    current_surface = _this->egl_data->eglGetCurrentSurface(EGL_DRAW);
 
-        /* Create Pixmap Surface using DMA_BUF framebuffer fd */
-        surf->pixmap.handles[0] = ion_data.fd;
+    for (i = MALI_SET_FIRST(set); i < MALI_SET_FIRST(set) + MALI_MAX_BUFFERS; i++) {
+        surf = &windowdata->surface[i];
+        if (surf->dmabuf_fd < 0)
+            continue;
 
-        surf->pixmap_handle = displaydata->egl_create_pixmap_ID_mapping(&surf->pixmap);
-        SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Created pixmap handle %p\n", (void *)surf->pixmap_handle);
-        if ((int)surf->pixmap_handle < 0) {
-            SDL_EGL_SetError("mali-fbdev: Unable to create EGL window surface", "egl_create_pixmap_ID_mapping");
-            return EGL_NO_SURFACE;
+        if ((current_surface != EGL_NO_SURFACE) && (surf->egl_surface == current_surface)) {
+            SDL_EGL_MakeCurrent(_this, EGL_NO_SURFACE, current_context);
+            current_surface = EGL_NO_SURFACE;
         }
 
-        surf->egl_surface = _this->egl_data->eglCreatePixmapSurface(
-            _this->egl_data->egl_display,
-            _this->egl_data->egl_config,
-            surf->pixmap_handle,
-            surf_attribs);
-        if (surf->egl_surface == EGL_NO_SURFACE) {
-            SDL_EGL_SetError("mali-fbdev: Unable to create EGL window surface", "eglCreatePixmapSurface");
-            return EGL_NO_SURFACE;
+        SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "MALI_DestroyWindow: Destroying surface %d.", i);
+        if (surf->egl_fence != EGL_NO_SYNC) {
+            _this->egl_data->eglDestroySyncKHR(_this->egl_data->egl_display, surf->egl_fence);
+            surf->egl_fence = EGL_NO_SYNC;
         }
+        if (surf->fence_fd >= 0) {
+            close(surf->fence_fd);
+            surf->fence_fd = -1;
+        }
+        if (surf->egl_surface != EGL_NO_SURFACE)
+            _this->egl_data->eglDestroySurface(_this->egl_data->egl_display, surf->egl_surface);
 
-        surf->egl_fence = EGL_NO_SYNC;
+        /* The ION buffer and its pixmap mapping go back to the pool */
+        MALI_PoolRelease(displaydata, surf);
+        surf->dmabuf_fd = -1;
+    }
+}
+
+/*
+ * An exact 5/6/5 GL config request gets 16-bit buffers, which halves the
+ * memory bandwidth of both rendering and blitting. SDL's config selection
+ * favors 24-bit configs even then, so look for a matching one here.
+ */
+static void
+MALI_EGL_ChoosePixmapFormat(_THIS, SDL_WindowData *windowdata)
+{
+    EGLint attribs[] = {
+        EGL_SURFACE_TYPE, MALI_PIXMAP_SURFACE_BIT,
+        EGL_RENDERABLE_TYPE, 0,
+        EGL_RED_SIZE, 5,
+        EGL_GREEN_SIZE, 6,
+        EGL_BLUE_SIZE, 5,
+        EGL_ALPHA_SIZE, 0,
+        EGL_DEPTH_SIZE, _this->gl_config.depth_size,
+        EGL_STENCIL_SIZE, _this->gl_config.stencil_size,
+        EGL_NONE
+    };
+    SDL_DisplayData *displaydata = SDL_GetDisplayDriverData(0);
+    EGLConfig configs[64];
+    EGLint count = 0, red, green, blue, alpha, i;
+
+    windowdata->drm_format = DRM_FORMAT_ARGB8888;
+    windowdata->bytes_per_pixel = 4;
+
+    /* Frames the CPU presents are copied as they are, they follow the screen */
+    if (windowdata->soft) {
+        if (displaydata->softfb.bpp != 2)
+            return;
+    } else if (_this->gl_config.red_size != 5 || _this->gl_config.green_size != 6 ||
+        _this->gl_config.blue_size != 5 || _this->gl_config.alpha_size > 0) {
+        return;
+    }
+
+    /* Stay compatible with the contexts the chosen config was picked for */
+    _this->egl_data->eglGetConfigAttrib(_this->egl_data->egl_display, _this->egl_data->egl_config, EGL_RENDERABLE_TYPE, &attribs[3]);
+    if (!_this->egl_data->eglChooseConfig(_this->egl_data->egl_display, attribs, configs, SDL_arraysize(configs), &count))
+        return;
+
+    /* Larger configs match the minimum sizes too, and sort first */
+    for (i = 0; i < count; i++) {
+        _this->egl_data->eglGetConfigAttrib(_this->egl_data->egl_display, configs[i], EGL_RED_SIZE, &red);
+        _this->egl_data->eglGetConfigAttrib(_this->egl_data->egl_display, configs[i], EGL_GREEN_SIZE, &green);
+        _this->egl_data->eglGetConfigAttrib(_this->egl_data->egl_display, configs[i], EGL_BLUE_SIZE, &blue);
+        _this->egl_data->eglGetConfigAttrib(_this->egl_data->egl_display, configs[i], EGL_ALPHA_SIZE, &alpha);
+        if (red == 5 && green == 6 && blue == 5 && alpha == 0) {
+            _this->egl_data->egl_config = configs[i];
+            windowdata->drm_format = DRM_FORMAT_RGB565;
+            windowdata->bytes_per_pixel = 2;
+            SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Using RGB565 buffers");
+            return;
+        }
     }
+}
+
+static EGLSurface *
+MALI_EGL_InitPixmapSurfaces(_THIS, SDL_Window *window)
+{
+    SDL_DisplayData *displaydata;
+    SDL_WindowData *windowdata; 
+    const char *capture;
+    int first;
+
+    windowdata = window->driverdata;
+    displaydata = SDL_GetDisplayDriverData(0);
+
+    _this->gl_config.multisamplebuffers = 0;
+    _this->gl_config.multisamplesamples = 0;
+    _this->egl_data->egl_surfacetype = MALI_PIXMAP_SURFACE_BIT;
+    if (SDL_EGL_ChooseConfig(_this) != 0) {
+        SDL_SetError("mali-fbdev: Unable to find a suitable EGL config");
+        return EGL_NO_SURFACE;
+    }
+    MALI_EGL_ChoosePixmapFormat(_this, windowdata);
+
+    /*
+     * SDL_MALI_BUFFERS: Number of buffers the window renders into, from 2
+     * (double buffering, lowest latency) to 4 (most headroom for GPU spikes).
+     * Defaults to triple buffering.
+     */
+    windowdata->num_buffers = MALI_GetHintInt("SDL_MALI_BUFFERS", 3);
+    windowdata->num_buffers = SDL_clamp(windowdata->num_buffers, 2, MALI_MAX_BUFFERS);
+
+    /* The CPU copies frames out before the swap returns, there's nothing to queue */
+    if (windowdata->soft)
+        windowdata->num_buffers = 1;
+
+    windowdata->buffer_set = 0;
+    windowdata->resize_w = window->w;
+    windowdata->resize_h = window->h;
+    SDL_AtomicSet(&windowdata->resize_state, MALI_RESIZE_IDLE);
+    if (MALI_EGL_AllocBufferSet(_this, windowdata, windowdata->buffer_set, window->w, window->h) < 0) {
+        return EGL_NO_SURFACE;
+    }
+
+    first = MALI_SET_FIRST(windowdata->buffer_set);
+    windowdata->back_buffer = first;
+    windowdata->front_buffer = first + windowdata->num_buffers - 1;
+    SDL_AtomicSet(&windowdata->queued_buffer, MALI_BUFFER_EMPTY);
+    SDL_AtomicSet(&windowdata->free_buffers, (((1 << windowdata->num_buffers) - 1) << first) & ~(1 << windowdata->back_buffer) & ~(1 << windowdata->front_buffer));
+    SDL_AtomicSet(&windowdata->release_seq, 0);
 
     /* Acquire an entry point to the glFlush function used to flush the buffered commands on "swap". */
     windowdata->glFlush = SDL_GL_GetProcAddress("glFlush");
+    windowdata->glFinish = SDL_GL_GetProcAddress("glFinish");
+
+    /*
+     * SDL_MALI_NATIVE_FENCE: "1" (default) exports frame fences as sync files
+     * when EGL_ANDROID_native_fence_sync is there, so the blitter can poll() on
+     * them alongside its wakeups instead of blocking in EGL.
+     */
+    windowdata->native_fence = displaydata->blitter && _this->egl_data->eglDupNativeFenceFDANDROID &&
+        SDL_EGL_HasExtension(_this, SDL_EGL_DISPLAY_EXTENSION, "EGL_ANDROID_native_fence_sync") &&
+        MALI_GetHintInt("SDL_MALI_NATIVE_FENCE", 1);
+
+    /*
+     * SDL_MALI_CAPTURE: File or named pipe to record the presented frames to,
+     * as Y4M when the name ends in ".y4m" and raw frames otherwise. See
+     * SDL_MaliStartCapture. Only one window at a time records there, windows
+     * stacked over it would truncate the same file.
+     */
+    capture = SDL_GetHint("SDL_MALI_CAPTURE");
+    if (displaydata->blitter && capture && *capture && !displaydata->capture_window) {
+        if (MALI_CaptureStart(windowdata, capture) < 0) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "MALI_EGL_InitPixmapSurfaces: %s", SDL_GetError());
+        } else {
+            displaydata->capture_window = window;
+        }
+    }
 
     /* Reconfigure the blitter now. */
-    MALI_BlitterReconfigure(_this, window, displaydata->blitter);
+    if (displaydata->blitter)
+        MALI_BlitterReconfigure(_this, window, displaydata->blitter);
 
     /* Done. */
     return windowdata->surface[windowdata->back_buffer].egl_surface;
@@ -364,47 +549,148 @@ MALI_EGL_DeinitPixmapSurfaces(_THIS, SDL_Window *window)
 {
     SDL_WindowData *data;
     SDL_DisplayData *displaydata;
-    EGLSurface current_surface;
-    EGLContext current_context;
+    int set;
 
     data = window->driverdata;
     displaydata = SDL_GetDisplayDriverData(0);
-    if (!displaydata->blitter)
+    if (!displaydata->blitter) {
+        /* Only OpenGL ES windows the CPU presents have pixmaps then */
+        if (data->soft && (window->flags & SDL_WINDOW_OPENGL)) {
+            MALI_UnmapWindowFramebuffer(data);
+            for (set = 0; set < MALI_BUFFER_SETS; set++) {
+                MALI_EGL_FreeBufferSet(_this, data, set);
+            }
+            MALI_Soft_GLES_Quit(_this, window);
+        }
         return;
+    }
+
+    // Let a background resize run to completion
+    if (data->resize_thread) {
+        SDL_WaitThread(data->resize_thread, NULL);
+        data->resize_thread = NULL;
+    }
     
     // Tear down the device resources first
     MALI_BlitterRelease(_this, window, displaydata->blitter);
+    MALI_CaptureStop(data);
+    if (displaydata->capture_window == window)
+        displaydata->capture_window = NULL;
+    MALI_UnmapWindowFramebuffer(data);
 
     SDL_LockMutex(displaydata->blitter->mutex);
+    for (set = 0; set < MALI_BUFFER_SETS; set++) {
+        MALI_EGL_FreeBufferSet(_this, data, set);
+    }
+    SDL_AtomicSet(&data->resize_state, MALI_RESIZE_IDLE);
+    SDL_UnlockMutex(displaydata->blitter->mutex);
+}
 
-    // Disable current surface
-    current_context = (EGLContext)SDL_GL_GetCurrentContext();
-    current_surface = _this->egl_data->eglGetCurrentSurface(EGL_DRAW);
+/* Allocates the next buffer set off the render thread. */
+static int SDLCALL
+MALI_ResizeThread(void *data)
+{
+    SDL_Window *window = (SDL_Window *)data;
+    SDL_WindowData *windowdata = window->driverdata;
+    SDL_VideoDevice *_this = SDL_GetVideoDevice();
+    int set = windowdata->buffer_set ^ 1;
+
+    if (MALI_EGL_AllocBufferSet(_this, windowdata, set, windowdata->resize_w, windowdata->resize_h) < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Resizing to %dx%d failed: %s",
+            windowdata->resize_w, windowdata->resize_h, SDL_GetError());
+        MALI_EGL_FreeBufferSet(_this, windowdata, set);
+        SDL_AtomicSet(&windowdata->resize_state, MALI_RESIZE_IDLE);
+        return -1;
+    }
 
-    for (int i = 0; i < SDL_arraysize(data->surface); i++) {
-        struct ion_handle_data handle_data;
-        if (data->surface[i].dmabuf_fd < 0)
-            continue;
+    SDL_AtomicSet(&windowdata->resize_state, MALI_RESIZE_READY);
+    return 0;
+}
 
-        if ((current_surface != EGL_NO_SURFACE) && (data->surface[i].egl_surface == current_surface)) {
-            SDL_EGL_MakeCurrent(_this, EGL_NO_SURFACE, current_context);
-            current_surface = EGL_NO_SURFACE;
-        }
+/* Moves the render thread over to the freshly allocated buffer set. */
+static void
+MALI_SwitchBufferSet(SDL_WindowData *windowdata)
+{
+    int first, set_mask, mask;
 
-        SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "MALI_DestroyWindow: Destroying surface %d.", i);
-        _this->egl_data->eglDestroySurface(_this->egl_data->egl_display, data->surface[i].egl_surface);
-        displaydata->egl_destroy_pixmap_ID_mapping(data->surface[i].pixmap_handle);
-        close(data->surface[i].dmabuf_fd);
+    windowdata->buffer_set ^= 1;
+    first = MALI_SET_FIRST(windowdata->buffer_set);
+    set_mask = ((1 << windowdata->num_buffers) - 1) << first;
+    windowdata->back_buffer = first;
 
-        handle_data = (struct ion_handle_data){
-            .handle = data->surface[i].dmabuf_handle
-        };
+    /* The blitter still holds on to a buffer of the old set, all of the new one is ours. */
+    do {
+        mask = SDL_AtomicGet(&windowdata->free_buffers);
+    } while (!SDL_AtomicCAS(&windowdata->free_buffers, mask, (mask & ~set_mask) | (set_mask & ~(1 << first))));
 
-        ioctl(displaydata->ion_fd, ION_IOC_FREE, &handle_data);
-        data->surface[i].dmabuf_fd = -1;
+    SDL_AtomicSet(&windowdata->resize_state, MALI_RESIZE_SWITCHED);
+}
+
+/* Frees the old buffer set once nothing can be reading it anymore. */
+static SDL_bool
+MALI_RetireBufferSet(_THIS, SDL_WindowData *windowdata)
+{
+    int set = windowdata->buffer_set ^ 1, i;
+    MALI_EGL_Surface *surf;
+
+    /* Frames the blitter never picked up might still be rendering. */
+    for (i = MALI_SET_FIRST(set); i < MALI_SET_FIRST(set) + windowdata->num_buffers; i++) {
+        surf = &windowdata->surface[i];
+        if (surf->egl_fence != EGL_NO_SYNC &&
+            _this->egl_data->eglClientWaitSyncKHR(_this->egl_data->egl_display, surf->egl_fence, 0, 0) != EGL_CONDITION_SATISFIED_KHR)
+            return SDL_FALSE;
     }
 
-    SDL_UnlockMutex(displaydata->blitter->mutex);
+    MALI_EGL_FreeBufferSet(_this, windowdata, set);
+    return SDL_TRUE;
+}
+
+/* Advances a background resize, called from the render thread. */
+static void
+MALI_UpdateResize(_THIS, SDL_Window *window, SDL_WindowData *windowdata)
+{
+    int state = SDL_AtomicGet(&windowdata->resize_state);
+    int w, h;
+
+    if (state != MALI_RESIZE_PREPARING && windowdata->resize_thread) {
+        SDL_WaitThread(windowdata->resize_thread, NULL);
+        windowdata->resize_thread = NULL;
+    }
+
+    MALI_PoolTrim(SDL_GetDisplayDriverData(0));
+
+    if (state == MALI_RESIZE_RETIRED && MALI_RetireBufferSet(_this, windowdata)) {
+        state = MALI_RESIZE_IDLE;
+        SDL_AtomicSet(&windowdata->resize_state, state);
+    }
+
+    /* Only one resize in flight, the most recent size is picked up once it's done. */
+    MALI_GetRenderSize(window, windowdata, &w, &h);
+    if (state == MALI_RESIZE_IDLE && (w != windowdata->resize_w || h != windowdata->resize_h)) {
+        windowdata->resize_w = w;
+        windowdata->resize_h = h;
+        SDL_AtomicSet(&windowdata->resize_state, MALI_RESIZE_PREPARING);
+        windowdata->resize_thread = SDL_CreateThread(MALI_ResizeThread, "MALI_ResizeThread", window);
+        if (windowdata->resize_thread == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Unable to start resize thread: %s", SDL_GetError());
+            SDL_AtomicSet(&windowdata->resize_state, MALI_RESIZE_IDLE);
+        }
+    }
+}
+
+void
+MALI_FinishResize(_THIS, SDL_Window *window)
+{
+    SDL_WindowData *windowdata = window->driverdata;
+
+    MALI_UpdateResize(_this, window, windowdata);
+    if (windowdata->resize_thread) {
+        SDL_WaitThread(windowdata->resize_thread, NULL);
+        windowdata->resize_thread = NULL;
+    }
+
+    if (SDL_AtomicGet(&windowdata->resize_state) == MALI_RESIZE_READY)
+        MALI_SwitchBufferSet(windowdata);
 }
 
 int
@@ -414,6 +700,7 @@ MALI_CreateWindow(_THIS, SDL_Window * window)
     SDL_VideoDisplay *display = SDL_GetDisplayForWindow(window);
     SDL_DisplayData *displaydata;
     EGLContext egl_context;
+    int i;
 
     displaydata = SDL_GetDisplayDriverData(0);
 
@@ -425,14 +712,47 @@ MALI_CreateWindow(_THIS, SDL_Window * window)
 
     /* Setup driver data for this window */
     window->driverdata = windowdata;
+    for (i = 0; i < (int)SDL_arraysize(windowdata->surface); i++) {
+        windowdata->surface[i].dmabuf_fd = -1;
+        windowdata->surface[i].map_fd = -1;
+        windowdata->surface[i].fence_fd = -1;
+    }
+    windowdata->buffer_released = SDL_CreateSemaphore(0);
+    windowdata->swap_damage.full = SDL_TRUE;
+    windowdata->pending_damage.full = SDL_TRUE;
+    MALI_StatsInit(&windowdata->stats);
+
+    /* Without the blitter, windows that don't use OpenGL ES are presented by the CPU. */
+    windowdata->soft = (displaydata->blitter == NULL) && !(window->flags & SDL_WINDOW_OPENGL);
+
+    /* Rotated OpenGL ES too, as long as the screen takes the GPU's pixels as they are */
+    if ((displaydata->blitter == NULL) && (window->flags & SDL_WINDOW_OPENGL) && displaydata->rotation != 0) {
+        if (MALI_Soft_GLES_Init(_this, window) == 0) {
+            windowdata->soft = SDL_TRUE;
+        } else {
+            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: OpenGL ES won't be rotated: %s", SDL_GetError());
+        }
+    }
 
     /* Use the entire screen when the blitter isn't enabled or the selected
        resolution doesn't make any sense. */
-    if ((displaydata->blitter == NULL) || (window->w < 32 || window->h < 32)) {
+    if ((displaydata->blitter == NULL) && !windowdata->soft) {
+        /* OpenGL ES renders straight to the screen, unrotated */
+        SDL_SendWindowEvent(window, SDL_WINDOWEVENT_RESIZED,
+                            displaydata->native_display.width, displaydata->native_display.height);
+    } else if (((displaydata->blitter == NULL) && (window->flags & SDL_WINDOW_OPENGL))
+        || (window->w < 32 || window->h < 32)) {
+        /* Rotated OpenGL ES covers the screen all the same */
         SDL_SendWindowEvent(window, SDL_WINDOWEVENT_RESIZED,
                             display->current_mode.w, display->current_mode.h);
     }
 
+    if (windowdata->soft && !(window->flags & SDL_WINDOW_OPENGL)) {
+        SDL_SetMouseFocus(window);
+        SDL_SetKeyboardFocus(window);
+        return 0;
+    }
+
     /* OpenGL ES is the law here */
     window->flags |= SDL_WINDOW_OPENGL;
     if (!_this->egl_data) {
@@ -449,13 +769,18 @@ MALI_CreateWindow(_THIS, SDL_Window * window)
         _this->gl_config.driver_loaded = 1;
     }
 
-    /* If the blitter is required, we will manually create the EGL Surface resources using the ION allocator
-       and some reverse engineered mali internals */
-    if (displaydata->blitter) {
+    /* If the blitter or the CPU presents, we will manually create the EGL Surface resources using the ION
+       allocator and some reverse engineered mali internals */
+    if (displaydata->blitter || windowdata->soft) {
+#if SDL_VIDEO_DRIVER_MALI_SIM
+        displaydata->egl_create_pixmap_ID_mapping = MALI_Sim_CreatePixmapMapping;
+        displaydata->egl_destroy_pixmap_ID_mapping = MALI_Sim_DestroyPixmapMapping;
+#else
         displaydata->egl_create_pixmap_ID_mapping = SDL_EGL_GetProcAddress(_this, "egl_create_pixmap_ID_mapping");
         displaydata->egl_destroy_pixmap_ID_mapping = SDL_EGL_GetProcAddress(_this, "egl_destroy_pixmap_ID_mapping");
+#endif
         if (!displaydata->egl_create_pixmap_ID_mapping || !displaydata->egl_destroy_pixmap_ID_mapping) {
-            MALI_VideoQuit(_this);
+            MALI_DestroyWindow(_this, window);
             return SDL_SetError("mali-fbdev: Can't find mali pixmap entrypoints");
         }
 
@@ -464,19 +789,20 @@ MALI_CreateWindow(_THIS, SDL_Window * window)
         windowdata->egl_surface = SDL_EGL_CreateSurface(_this, (NativeWindowType) &displaydata->native_display);
     }
 
+    /* Only this window's resources go, the display keeps serving the others */
     if (windowdata->egl_surface == EGL_NO_SURFACE) {
-        MALI_VideoQuit(_this);
+        MALI_DestroyWindow(_this, window);
         return SDL_SetError("mali-fbdev: Can't create EGL window surface");
     }
 
     /* Set the current surface NOW. */
     egl_context = (EGLContext)SDL_GL_GetCurrentContext();
     if (SDL_EGL_MakeCurrent(_this, windowdata->egl_surface, egl_context) != 0) {
-        MALI_VideoQuit(_this);
+        MALI_DestroyWindow(_this, window);
         return SDL_SetError("mali-fbdev: Can't set EGL context");
     }
 
-    /* One window, it always has focus */
+    /* The newest window goes on top and takes the focus */
     SDL_SetMouseFocus(window);
     SDL_SetKeyboardFocus(window);
 
@@ -487,17 +813,32 @@ MALI_CreateWindow(_THIS, SDL_Window * window)
 void MALI_DestroyWindow(_THIS, SDL_Window *window)
 {
     SDL_WindowData *data;
+    SDL_DisplayData *displaydata = SDL_GetDisplayDriverData(0);
+    SDL_Window *top;
     data = window->driverdata;
     
     if (data) {
-        MALI_EGL_DeinitPixmapSurfaces(_this, window);
+        /* Windows that failed to load EGL never got any surfaces */
+        if (_this->egl_data)
+            MALI_EGL_DeinitPixmapSurfaces(_this, window);
         if (data->egl_surface != EGL_NO_SURFACE) {
             SDL_EGL_DestroySurface(_this, data->egl_surface);
             data->egl_surface = EGL_NO_SURFACE;
         }
+        MALI_StatsQuit(&data->stats);
+        SDL_DestroySemaphore(data->buffer_released);
         SDL_free(data);
     }
     window->driverdata = NULL;
+
+    /* The focus goes back to the window now on top */
+    if (displaydata->blitter && !SDL_GetKeyboardFocus()) {
+        top = MALI_Blitter_GetTopWindow(displaydata->blitter);
+        if (top) {
+            SDL_SetMouseFocus(top);
+            SDL_SetKeyboardFocus(top);
+        }
+    }
 }
 
 void
@@ -505,9 +846,32 @@ MALI_SetWindowTitle(_THIS, SDL_Window * window)
 {
 }
 
+/*
+ * Tells the blitter where a window goes when it's stacked over another one,
+ * fullscreen windows cover the whole display.
+ */
+static void
+MALI_PlaceWindow(_THIS, SDL_Window * window, SDL_bool visible, float opacity)
+{
+    SDL_DisplayData *displaydata = SDL_GetDisplayDriverData(0);
+    SDL_VideoDisplay *display = SDL_GetDisplayForWindow(window);
+    SDL_Rect rect = { window->x, window->y, window->w, window->h };
+
+    if (!displaydata->blitter || !window->driverdata)
+        return;
+
+    if (window->flags & SDL_WINDOW_FULLSCREEN) {
+        rect.x = rect.y = 0;
+        rect.w = display->current_mode.w;
+        rect.h = display->current_mode.h;
+    }
+    MALI_Blitter_PlaceWindow(displaydata->blitter, window, &rect, visible, opacity);
+}
+
 void
 MALI_SetWindowPosition(_THIS, SDL_Window * window)
 {
+    MALI_PlaceWindow(_this, window, (window->flags & SDL_WINDOW_SHOWN) != 0, window->opacity);
 }
 
 void
@@ -516,7 +880,6 @@ MALI_SetWindowSize(_THIS, SDL_Window * window)
     SDL_WindowData *windowdata;
     SDL_VideoDisplay *display;
     SDL_DisplayData *displaydata;
-    EGLContext egl_context;
 
     windowdata = window->driverdata;
     display = SDL_GetDisplayForWindow(window);
@@ -524,11 +887,14 @@ MALI_SetWindowSize(_THIS, SDL_Window * window)
 
     /*
      * Switch to a fullscreen resolution whenever:
-     * - We are not using the blitter
+     * - We are not using the blitter, for OpenGL ES windows, rotated or not
      * - A fullscreen was requested
      * - The window resolution requested doesn't make any sense
      */
-    if ((displaydata->blitter == NULL)
+    if ((displaydata->blitter == NULL) && !windowdata->soft) {
+        SDL_SendWindowEvent(window, SDL_WINDOWEVENT_RESIZED,
+                            displaydata->native_display.width, displaydata->native_display.height);
+    } else if (((displaydata->blitter == NULL) && (window->flags & SDL_WINDOW_OPENGL))
         || (window->w < 32 || window->h < 32)
         || ((window->flags & SDL_WINDOW_FULLSCREEN) == SDL_WINDOW_FULLSCREEN)) {
         SDL_SendWindowEvent(window, SDL_WINDOWEVENT_RESIZED,
@@ -536,18 +902,12 @@ MALI_SetWindowSize(_THIS, SDL_Window * window)
     }
 
     /*
-     * If we're using the blitter, we might need to signal for a surface reconfiguration
-     * if the dimensions of our surface changed.
+     * If we're using the blitter, buffers of the new size are allocated in the
+     * background; the old ones keep presenting until the next swap after that.
      */
     if (displaydata->blitter) {
-        if ((displaydata->blitter->plane_width == window->w)
-         && (displaydata->blitter->plane_height == window->h))
-            return;
-
-        egl_context = (EGLContext)SDL_GL_GetCurrentContext();
-        MALI_EGL_DeinitPixmapSurfaces(_this, window);
-        windowdata->egl_surface = MALI_EGL_InitPixmapSurfaces(_this, window);
-        SDL_EGL_MakeCurrent(_this, windowdata->egl_surface, egl_context);
+        MALI_UpdateResize(_this, window, windowdata);
+        MALI_PlaceWindow(_this, window, (window->flags & SDL_WINDOW_SHOWN) != 0, window->opacity);
     }
 }
 
@@ -560,11 +920,34 @@ MALI_SetWindowFullscreen(_THIS, SDL_Window *window, SDL_VideoDisplay *display, S
 void
 MALI_ShowWindow(_THIS, SDL_Window * window)
 {
+    MALI_PlaceWindow(_this, window, SDL_TRUE, window->opacity);
 }
 
 void
 MALI_HideWindow(_THIS, SDL_Window * window)
 {
+    MALI_PlaceWindow(_this, window, SDL_FALSE, window->opacity);
+}
+
+void
+MALI_RaiseWindow(_THIS, SDL_Window * window)
+{
+    SDL_DisplayData *displaydata = SDL_GetDisplayDriverData(0);
+
+    if (!displaydata->blitter || !window->driverdata)
+        return;
+
+    MALI_Blitter_RaiseWindow(displaydata->blitter, window);
+    SDL_SetMouseFocus(window);
+    SDL_SetKeyboardFocus(window);
+}
+
+/* Only stacked windows blend with what's below them */
+int
+MALI_SetWindowOpacity(_THIS, SDL_Window * window, float opacity)
+{
+    MALI_PlaceWindow(_this, window, (window->flags & SDL_WINDOW_SHOWN) != 0, opacity);
+    return 0;
 }
 
 int
@@ -586,6 +969,176 @@ MALI_GLES_GetSwapInterval(_THIS)
     return _this->egl_data->egl_swapinterval;
 }
 
+static void
+MALI_AddDamage(MALI_Damage *damage, const MALI_Damage *other)
+{
+    if (other->full)
+        damage->full = SDL_TRUE;
+    else
+        SDL_UnionRect(&damage->rect, &other->rect, &damage->rect);
+}
+
+/*
+ * Hands the damage of a frame the blitter drops on to a newer one, either the
+ * buffer given or with to negative, the frame in the mailbox or the next one
+ * queued.
+ */
+void
+MALI_CarryDamage(SDL_WindowData *windata, int from, int to)
+{
+    MALI_Damage *damage = &windata->pending_damage;
+    int queued;
+
+    SDL_AtomicLock(&windata->damage_lock);
+    if (to >= 0) {
+        damage = &windata->surface[to].damage;
+    } else {
+        queued = SDL_AtomicGet(&windata->queued_buffer);
+        if (queued & MALI_BUFFER_FRESH)
+            damage = &windata->surface[queued & MALI_BUFFER_INDEX_MASK].damage;
+    }
+    MALI_AddDamage(damage, &windata->surface[from].damage);
+    SDL_AtomicUnlock(&windata->damage_lock);
+}
+
+int
+MALI_AcquireBuffer(SDL_WindowData *windata)
+{
+    int first = MALI_SET_FIRST(windata->buffer_set);
+    int set_mask = ((1 << windata->num_buffers) - 1) << first;
+    int i, best, mask, prev;
+
+    for (;;) {
+        mask = SDL_AtomicGet(&windata->free_buffers);
+        if (mask & set_mask) {
+            /* Prefer the buffer released the longest ago, the GPU is most likely done reading it. */
+            best = -1;
+            for (i = first; i < first + windata->num_buffers; i++) {
+                if ((mask & (1 << i)) && (best < 0 || (Sint32)(windata->surface[i].released - windata->surface[best].released) < 0))
+                    best = i;
+            }
+
+            if (SDL_AtomicCAS(&windata->free_buffers, mask, mask & ~(1 << best)))
+                return best;
+
+            continue;
+        }
+
+        /*
+         * Nothing free, this only happens when double buffering: wait for the blitter to pick up our frame.
+         * If it's stalled, take the frame back rather than deadlocking.
+         */
+        if (SDL_SemWaitTimeout(windata->buffer_released, MALI_BUFFER_TIMEOUT) == SDL_MUTEX_TIMEDOUT) {
+            SDL_AtomicLock(&windata->damage_lock);
+            prev = SDL_AtomicSet(&windata->queued_buffer, MALI_BUFFER_EMPTY);
+            if (prev & MALI_BUFFER_FRESH)
+                MALI_AddDamage(&windata->pending_damage, &windata->surface[prev & MALI_BUFFER_INDEX_MASK].damage);
+            SDL_AtomicUnlock(&windata->damage_lock);
+
+            if (prev & MALI_BUFFER_FRESH) {
+                SDL_AtomicIncRef(&windata->stats.dropped);
+                if (MALI_BUFFER_SET(prev & MALI_BUFFER_INDEX_MASK) == windata->buffer_set)
+                    return prev & MALI_BUFFER_INDEX_MASK;
+            }
+        }
+    }
+}
+
+void
+MALI_QueueBuffer(_THIS, SDL_Window *window, const MALI_Damage *damage)
+{
+    SDL_WindowData *windata = (SDL_WindowData *)window->driverdata;
+    SDL_DisplayData *displaydata = SDL_GetDisplayDriverData(0);
+    MALI_EGL_Surface *surface = &windata->surface[windata->back_buffer];
+    const mali_pixmap *old_pixmap, *pixmap;
+    int prev;
+
+    /* Let the blitter know what changed, including frames taken back before it saw them */
+    SDL_AtomicLock(&windata->damage_lock);
+    surface->damage = windata->pending_damage;
+    MALI_AddDamage(&surface->damage, damage);
+    windata->pending_damage.full = SDL_FALSE;
+    SDL_zero(windata->pending_damage.rect);
+
+    /* Post the back buffer to the mailbox, taking whatever was in it back */
+    prev = SDL_AtomicSet(&windata->queued_buffer, windata->back_buffer | MALI_BUFFER_FRESH);
+    if (prev & MALI_BUFFER_FRESH)
+        MALI_AddDamage(&surface->damage, &windata->surface[prev & MALI_BUFFER_INDEX_MASK].damage);
+    SDL_AtomicUnlock(&windata->damage_lock);
+
+    SDL_AtomicIncRef(&windata->stats.submitted);
+    MALI_BlitterWake(displaydata->blitter);
+
+    /* The blitter never got to see the previous frame, it's dropped. */
+    if (prev & MALI_BUFFER_FRESH)
+        SDL_AtomicIncRef(&windata->stats.dropped);
+
+    /* With vsync the application still runs at the display's pace, only interval 0 lets it run free */
+    if (_this->egl_data->egl_swapinterval != 0)
+        MALI_VblankThrottle(&displaydata->vblank, &windata->paced_vblank);
+
+    /* A mapped framebuffer switches sets when the window surface is recreated. */
+    if (SDL_AtomicGet(&windata->resize_state) == MALI_RESIZE_READY && !windata->framebuffer) {
+        old_pixmap = &windata->surface[MALI_SET_FIRST(windata->buffer_set)].pixmap;
+        MALI_SwitchBufferSet(windata);
+        pixmap = &windata->surface[MALI_SET_FIRST(windata->buffer_set)].pixmap;
+
+        /*
+         * The drawable follows the window a few frames late, and with dynamic
+         * resolution, also on its own. Nothing else tells the application.
+         */
+        if (pixmap->width != old_pixmap->width || pixmap->height != old_pixmap->height)
+            SDL_SendWindowEvent(window, SDL_WINDOWEVENT_SIZE_CHANGED, window->w, window->h);
+    } else if ((prev & MALI_BUFFER_FRESH) && MALI_BUFFER_SET(prev & MALI_BUFFER_INDEX_MASK) == windata->buffer_set) {
+        windata->back_buffer = prev & MALI_BUFFER_INDEX_MASK;
+    } else {
+        windata->back_buffer = MALI_AcquireBuffer(windata);
+    }
+
+    MALI_DynResUpdate(window, windata);
+    MALI_UpdateResize(_this, window, windata);
+}
+
+void
+MALI_ReleaseBuffer(SDL_WindowData *windata, int buffer)
+{
+    int mask;
+
+    /* The blitter and the capture thread both release buffers */
+    windata->surface[buffer].released = (Uint32)SDL_AtomicAdd(&windata->release_seq, 1) + 1;
+    do {
+        mask = SDL_AtomicGet(&windata->free_buffers);
+    } while (!SDL_AtomicCAS(&windata->free_buffers, mask, mask | (1 << buffer)));
+
+    /* With more buffers, the render thread never waits for one. */
+    if (windata->num_buffers == 2)
+        SDL_SemPost(windata->buffer_released);
+}
+
+SDL_WindowData *
+MALI_GetWindowData(SDL_Window *window)
+{
+    SDL_VideoDevice *_this = SDL_GetVideoDevice();
+
+    if (!_this || SDL_strcmp(_this->name, "mali") != 0) {
+        SDL_SetError("Video subsystem is not using the mali driver");
+        return NULL;
+    }
+    if (!window || window->magic != &_this->window_magic || !window->driverdata) {
+        SDL_SetError("Invalid window");
+        return NULL;
+    }
+
+    return (SDL_WindowData *)window->driverdata;
+}
+
+int
+MALI_GetHintInt(const char *name, int default_value)
+{
+    const char *hint = SDL_GetHint(name);
+    return (hint && *hint) ? SDL_atoi(hint) : default_value;
+}
+
 /*****************************************************************************/
 /* SDL Window Manager function                                               */
 /*****************************************************************************/
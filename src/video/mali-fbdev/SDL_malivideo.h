@@ -41,6 +41,13 @@
 
 #include "mali.h"
 #include "ion.h"
+#include "SDL_malistats.h"
+#include "SDL_malipool.h"
+#include "SDL_malivblank.h"
+#include "SDL_malidynres.h"
+#include "SDL_malisoftfb.h"
+#include "SDL_malicapture.h"
+#include "SDL_malisim.h"
 
 typedef struct SDL_DisplayData
 {
@@ -48,35 +55,141 @@ typedef struct SDL_DisplayData
     struct MALI_Blitter *blitter;
     fbdev_window_s native_display;
     int rotation;
-    unsigned long stride;
     unsigned long w_align;
     unsigned long h_align;
     NativePixmapType (*egl_create_pixmap_ID_mapping)(mali_pixmap *);
     NativePixmapType (*egl_destroy_pixmap_ID_mapping)(int id);
+    MALI_BufferPool pool;
+    int refresh_mhz;
+    MALI_VblankClock vblank;
+    MALI_SoftFb softfb;
+    SDL_Window *capture_window; /* recording to SDL_MALI_CAPTURE */
 } SDL_DisplayData;
 
+/* Window region that changed, in window coordinates */
+typedef struct MALI_Damage
+{
+    SDL_bool full;
+    SDL_Rect rect;
+} MALI_Damage;
+
 typedef struct MALI_EGL_Surface
 {
     // A pixmap is backed by multiple ION allocated backbuffers, EGL fences, etc.
     EGLImageKHR egl_image;
     GLuint texture;
     EGLSyncKHR egl_fence;
+    int fence_fd;               /* sync file of egl_fence, -1 when not exported */
     EGLSurface egl_surface;
     NativePixmapType pixmap_handle;
     mali_pixmap pixmap;
     int dmabuf_fd;
     int dmabuf_handle;
+    MALI_PoolBuffer *buffer;
+    MALI_FrameTiming timing;
+    Uint32 released;
+
+    /* Changes since the frame shown before, including frames dropped in between */
+    MALI_Damage damage;
+
+    /* CPU mapping for the window framebuffer, see SDL_maliframebuffer.c */
+    void *map;
+    int map_fd;
+    SDL_Rect stale;
 } MALI_EGL_Surface;
 
+/*
+ * The queued buffer is a mailbox shared between the render and the blitter
+ * thread: it holds the index of the last submitted surface tagged with
+ * MALI_BUFFER_FRESH, or MALI_BUFFER_EMPTY. Each side swaps it atomically, so
+ * the newest frame always wins and a frame still waiting in there when the
+ * next one arrives is taken back by the render thread as dropped.
+ *
+ * Buffers the blitter is done with go back to the render thread through the
+ * free_buffers mask; the one released the longest ago is reused first. Frames
+ * a capture was still copying are released by the capture thread instead.
+ */
+#define MALI_MAX_BUFFERS        4
+#define MALI_BUFFER_EMPTY       0x000
+#define MALI_BUFFER_FRESH       0x100
+#define MALI_BUFFER_INDEX_MASK  0x0FF
+#define MALI_BUFFER_TIMEOUT     100
+
+/*
+ * Resizing allocates a second set of buffers in the background while the
+ * current one keeps presenting. Both sets share the index space above, so the
+ * set a frame belongs to is implied by its index: the render thread moves on
+ * to the new set on the next swap, and the blitter follows once it picks up a
+ * frame from it. The old set is freed when the blitter let go of it and all of
+ * its fences signaled.
+ */
+#define MALI_BUFFER_SETS        2
+#define MALI_SET_FIRST(set)     ((set) * MALI_MAX_BUFFERS)
+#define MALI_BUFFER_SET(index)  ((index) / MALI_MAX_BUFFERS)
+
+enum
+{
+    MALI_RESIZE_IDLE,       /* one buffer set in use */
+    MALI_RESIZE_PREPARING,  /* the other set is being allocated */
+    MALI_RESIZE_READY,      /* the other set is ready, switched to on the next swap */
+    MALI_RESIZE_SWITCHED,   /* the render thread switched, the blitter may still show the old set */
+    MALI_RESIZE_RETIRED     /* the blitter switched too, the old set can be freed */
+};
+
 typedef struct SDL_WindowData
 {
     EGLSurface egl_surface;
-    int back_buffer;
-    int queued_buffer;
-    int front_buffer;
-
-    MALI_EGL_Surface surface[3];
+    int num_buffers;
+    int back_buffer;            /* owned by the render thread */
+    SDL_atomic_t queued_buffer; /* mailbox, see above */
+    int front_buffer;           /* owned by the blitter thread */
+    SDL_atomic_t free_buffers;  /* mask of buffers released by the blitter */
+    SDL_sem *buffer_released;   /* signaled on release when double buffered */
+    SDL_atomic_t release_seq;   /* orders releases, from the blitter and capture threads */
+    Uint64 paced_vblank;        /* owned by the render thread, see MALI_VblankThrottle */
+
+    MALI_FrameStats stats;
+
+    /* Damage of the next swap, see SDL_MaliSetSwapDamage */
+    SDL_bool has_swap_damage;
+    MALI_Damage swap_damage;
+
+    /*
+     * Guards the damage of queued frames. The render thread posts to the
+     * mailbox under it, so a dropped frame's damage always ends up on a frame
+     * that is still to be shown: the frame replacing it, or with the mailbox
+     * empty, the next one queued through pending_damage.
+     */
+    SDL_SpinLock damage_lock;
+    MALI_Damage pending_damage;
+
+    MALI_EGL_Surface surface[MALI_MAX_BUFFERS * MALI_BUFFER_SETS];
+    int buffer_set;             /* set the render thread draws into */
+    SDL_atomic_t resize_state;
+    SDL_Thread *resize_thread;
+    int resize_w, resize_h;     /* size of the last set allocated */
+
+    MALI_DynamicResolution dynres;
+
+    /* Owned by the blitter thread while stacked over another window */
+    int stack_set;              /* buffer set imported, -1 when none */
+    SDL_bool stack_shown;       /* front_buffer holds a frame */
+    SDL_bool stack_fresh;       /* front_buffer wasn't presented yet */
+
+    /* Frame capture, see SDL_MaliStartCapture */
+    SDL_SpinLock capture_lock;
+    MALI_Capture *capture;
+
+    SDL_bool framebuffer;       /* the surfaces are mapped as the window framebuffer */
+    SDL_bool soft;              /* presented by the CPU, from a single pixmap with OpenGL ES */
+    void *soft_pixels;
+    int soft_pitch;
+    SDL_bool framebuffer_preserve;
+    SDL_bool native_fence;      /* fences are exported as sync files */
+    Uint32 drm_format;          /* pixel format of the window buffers */
+    int bytes_per_pixel;
     void (*glFlush)(void);
+    void (*glFinish)(void);
 } SDL_WindowData;
 
 /****************************************************************************/
@@ -95,10 +208,21 @@ void MALI_SetWindowSize(_THIS, SDL_Window * window);
 void MALI_SetWindowFullscreen(_THIS, SDL_Window * window, SDL_VideoDisplay * display, SDL_bool fullscreen);
 void MALI_ShowWindow(_THIS, SDL_Window * window);
 void MALI_HideWindow(_THIS, SDL_Window * window);
+void MALI_RaiseWindow(_THIS, SDL_Window * window);
+int MALI_SetWindowOpacity(_THIS, SDL_Window * window, float opacity);
 void MALI_DestroyWindow(_THIS, SDL_Window * window);
 int MALI_GLES_SetSwapInterval(_THIS, int interval);
 int MALI_GLES_GetSwapInterval(_THIS);
 
+/* Driver helpers */
+SDL_WindowData *MALI_GetWindowData(SDL_Window *window);
+int MALI_GetHintInt(const char *name, int default_value);
+int MALI_AcquireBuffer(SDL_WindowData *windata);
+void MALI_QueueBuffer(_THIS, SDL_Window *window, const MALI_Damage *damage);
+void MALI_FinishResize(_THIS, SDL_Window *window);
+void MALI_ReleaseBuffer(SDL_WindowData *windata, int buffer);
+void MALI_CarryDamage(SDL_WindowData *windata, int from, int to);
+
 /* Window manager function */
 SDL_bool MALI_GetWindowWMInfo(_THIS, SDL_Window * window,
                              struct SDL_SysWMinfo *info);
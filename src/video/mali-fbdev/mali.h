@@ -23,6 +23,7 @@
 
 #define DRM_FORMAT_ARGB8888	fourcc_code('A', 'R', '2', '4')
 #define DRM_FORMAT_XRGB8888	fourcc_code('X', 'R', '2', '4')
+#define DRM_FORMAT_RGB565	fourcc_code('R', 'G', '1', '6')
 
 
 #define MALI_ALIGN(val, align)  (((val) + (align) - 1) & ~((align) - 1))
@@ -592,6 +592,263 @@ int surface_testBlitBlendLoop(void *arg)
     return TEST_COMPLETED;
 }
 
+/**
+ * @brief Tests that the alpha blitters give the same result for whole rows as for single pixels.
+ *
+ * Blits of 1 pixel wide columns go through the C code of the blitters, their
+ * SIMD versions only handle vectors of pixels and pass the rest of each row on.
+ */
+int surface_testBlitAlphaColumns(void *arg)
+{
+    const Uint32 formats[] = {
+        SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_ABGR8888, SDL_PIXELFORMAT_RGBA8888, SDL_PIXELFORMAT_BGRA8888,
+        SDL_PIXELFORMAT_RGB888, SDL_PIXELFORMAT_BGR888, SDL_PIXELFORMAT_RGB565, SDL_PIXELFORMAT_RGB555
+    };
+    const int width = 67, height = 3;
+    SDL_Surface *src, *whole, *columns;
+    SDL_Rect srcrect, dstrect;
+    Uint32 pixel;
+    int i, j, mode, x, y, ret, bpp;
+
+    for (i = 0; i < (int)SDL_arraysize(formats); i++) {
+        for (j = 0; j < (int)SDL_arraysize(formats); j++) {
+            /* Modes: per pixel alpha, per surface alpha of 128 and random, per surface alpha with a colorkey */
+            for (mode = 0; mode < 4; mode++) {
+                src = SDL_CreateRGBSurfaceWithFormat(0, width, height, 0, formats[i]);
+                whole = SDL_CreateRGBSurfaceWithFormat(0, width, height, 0, formats[j]);
+                columns = SDL_CreateRGBSurfaceWithFormat(0, width, height, 0, formats[j]);
+                SDLTest_AssertCheck(src && whole && columns, "Verify surfaces are not NULL");
+                if (!src || !whole || !columns) {
+                    SDL_FreeSurface(src);
+                    SDL_FreeSurface(whole);
+                    SDL_FreeSurface(columns);
+                    return TEST_ABORTED;
+                }
+
+                for (x = 0; x < src->pitch * height; x++) {
+                    ((Uint8 *)src->pixels)[x] = SDLTest_RandomUint8();
+                }
+                for (x = 0; x < whole->pitch * height; x++) {
+                    ((Uint8 *)whole->pixels)[x] = ((Uint8 *)columns->pixels)[x] = SDLTest_RandomUint8();
+                }
+                /* Make sure there are transparent and opaque pixels */
+                if (src->format->BytesPerPixel == 4) {
+                    for (y = 0; y < height; y++) {
+                        for (x = 0; x < width; x += 3) {
+                            Uint32 *p = (Uint32 *)((Uint8 *)src->pixels + y * src->pitch) + x;
+                            *p = (x % 2) ? (*p | src->format->Amask) : (*p & ~src->format->Amask);
+                        }
+                    }
+                }
+
+                SDL_SetSurfaceBlendMode(src, SDL_BLENDMODE_BLEND);
+                if (mode > 0) {
+                    SDL_SetSurfaceAlphaMod(src, mode == 1 ? 128 : SDLTest_RandomIntegerInRange(1, 254));
+                    if (mode == 3) {
+                        /* Use the color of one pixel as the key, and repeat it */
+                        bpp = src->format->BytesPerPixel;
+                        pixel = 0;
+                        SDL_memcpy(&pixel, (Uint8 *)src->pixels + bpp, bpp);
+                        for (x = 1; x < width; x += 5) {
+                            SDL_memcpy((Uint8 *)src->pixels + src->pitch + x * bpp, &pixel, bpp);
+                        }
+                        SDL_SetColorKey(src, SDL_TRUE, pixel);
+                    }
+                }
+
+                ret = SDL_BlitSurface(src, NULL, whole, NULL);
+                SDLTest_AssertCheck(ret == 0, "Verify result from SDL_BlitSurface, expected: 0, got: %i", ret);
+                for (x = 0; x < width; x++) {
+                    srcrect.x = dstrect.x = x;
+                    srcrect.y = dstrect.y = 0;
+                    srcrect.w = dstrect.w = 1;
+                    srcrect.h = dstrect.h = height;
+                    SDL_BlitSurface(src, &srcrect, columns, &dstrect);
+                }
+
+                ret = 0;
+                for (y = 0; y < height; y++) {
+                    ret |= SDL_memcmp((Uint8 *)whole->pixels + y * whole->pitch,
+                                      (Uint8 *)columns->pixels + y * columns->pitch,
+                                      width * whole->format->BytesPerPixel);
+                }
+                SDLTest_AssertCheck(ret == 0, "Verify blit from %s to %s in mode %d matches pixel by pixel",
+                                    SDL_GetPixelFormatName(formats[i]), SDL_GetPixelFormatName(formats[j]), mode);
+
+                SDL_FreeSurface(src);
+                SDL_FreeSurface(whole);
+                SDL_FreeSurface(columns);
+            }
+        }
+    }
+
+    return TEST_COMPLETED;
+}
+
+/**
+ * @brief Tests the rounding of per pixel alpha blits between ARGB8888 surfaces.
+ *
+ * The SSE4.1, AVX2 and NEON blitters divide by 255 and round like the C code.
+ * Without SSE4.1 the MMX and 3DNow! blitters are used instead, they divide by
+ * 256 and give 0xFE7F007E here, one less in blue than the C code.
+ */
+int surface_testBlitAlphaRounding(void *arg)
+{
+    const int width = 19;
+    SDL_Surface *src, *dst;
+    Uint32 pixel;
+    int x, ret;
+
+    src = SDL_CreateRGBSurfaceWithFormat(0, width, 1, 0, SDL_PIXELFORMAT_ARGB8888);
+    dst = SDL_CreateRGBSurfaceWithFormat(0, width, 1, 0, SDL_PIXELFORMAT_ARGB8888);
+    SDLTest_AssertCheck(src && dst, "Verify surfaces are not NULL");
+    if (!src || !dst) {
+        SDL_FreeSurface(src);
+        SDL_FreeSurface(dst);
+        return TEST_ABORTED;
+    }
+
+    SDL_FillRect(src, NULL, 0x80FF0000);
+    SDL_FillRect(dst, NULL, 0xFF0000FF);
+    SDL_SetSurfaceBlendMode(src, SDL_BLENDMODE_BLEND);
+    ret = SDL_BlitSurface(src, NULL, dst, NULL);
+    SDLTest_AssertCheck(ret == 0, "Verify result from SDL_BlitSurface, expected: 0, got: %i", ret);
+
+    for (x = 0; x < width; x++) {
+        pixel = ((Uint32 *)dst->pixels)[x];
+        if (pixel != 0xFE7F007F && !(pixel == 0xFE7F007E && !SDL_HasSSE41())) {
+            break;
+        }
+    }
+    SDLTest_AssertCheck(x == width, "Verify blended pixels, expected: 0xFE7F007F, got: 0x%08" SDL_PRIX32 " at x=%d",
+                        pixel, x < width ? x : width - 1);
+
+    SDL_FreeSurface(src);
+    SDL_FreeSurface(dst);
+    return TEST_COMPLETED;
+}
+
+/* Reads a pixel the way the blitters do, 24-bit ones in byte order */
+static Uint32 surface_getPixel(SDL_Surface *surface, int x, int y)
+{
+    const Uint8 *p = (const Uint8 *)surface->pixels + y * surface->pitch + x * surface->format->BytesPerPixel;
+
+    switch (surface->format->BytesPerPixel) {
+    case 2:
+        return *(const Uint16 *)p;
+    case 3:
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+        return p[0] | (p[1] << 8) | (p[2] << 16);
+#else
+        return p[2] | (p[1] << 8) | (p[0] << 16);
+#endif
+    default:
+        return *(const Uint32 *)p;
+    }
+}
+
+/**
+ * @brief Tests the conversion blitters between formats against SDL_GetRGBA() and SDL_MapRGBA().
+ *
+ * Rows are wide enough for the SIMD versions of the blitters, which only handle
+ * vectors of pixels and pass the rest of each row on to C code. The unused bits
+ * of destinations without alpha aren't compared.
+ */
+int surface_testBlitConversion(void *arg)
+{
+    const Uint32 formats[] = {
+        SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_ABGR8888, SDL_PIXELFORMAT_RGBA8888, SDL_PIXELFORMAT_BGRA8888,
+        SDL_PIXELFORMAT_RGB888, SDL_PIXELFORMAT_BGR888, SDL_PIXELFORMAT_RGB24, SDL_PIXELFORMAT_BGR24,
+        SDL_PIXELFORMAT_RGB565, SDL_PIXELFORMAT_RGB555
+    };
+    const int width = 67, height = 5;
+    SDL_Surface *src, *dst, *orig;
+    SDL_Rect srcrect, dstrect;
+    Uint32 key = 0, pixel, expected, actual, mask;
+    Uint8 r, g, b, a;
+    int i, j, mode, x, y, ret, bad;
+
+    for (i = 0; i < (int)SDL_arraysize(formats); i++) {
+        for (j = 0; j < (int)SDL_arraysize(formats); j++) {
+            /* 16-bit sources are widened through lookup tables, which round on their own */
+            if (SDL_BYTESPERPIXEL(formats[i]) == 2 && SDL_BYTESPERPIXEL(formats[j]) != 2) {
+                continue;
+            }
+
+            /* Modes: plain, with a colorkey, and both again from and to odd offsets */
+            for (mode = 0; mode < 4; mode++) {
+                src = SDL_CreateRGBSurfaceWithFormat(0, width, height, 0, formats[i]);
+                dst = SDL_CreateRGBSurfaceWithFormat(0, width, height, 0, formats[j]);
+                orig = SDL_CreateRGBSurfaceWithFormat(0, width, height, 0, formats[j]);
+                SDLTest_AssertCheck(src && dst && orig, "Verify surfaces are not NULL");
+                if (!src || !dst || !orig) {
+                    SDL_FreeSurface(src);
+                    SDL_FreeSurface(dst);
+                    SDL_FreeSurface(orig);
+                    return TEST_ABORTED;
+                }
+
+                for (x = 0; x < src->pitch * height; x++) {
+                    ((Uint8 *)src->pixels)[x] = SDLTest_RandomUint8();
+                }
+                for (x = 0; x < dst->pitch * height; x++) {
+                    ((Uint8 *)dst->pixels)[x] = ((Uint8 *)orig->pixels)[x] = SDLTest_RandomUint8();
+                }
+
+                SDL_SetSurfaceBlendMode(src, SDL_BLENDMODE_NONE);
+                if (mode & 1) {
+                    /* Use the color of one pixel as the key, and repeat it */
+                    key = surface_getPixel(src, 1, 0);
+                    for (x = 1; x < width; x += 5) {
+                        SDL_memcpy((Uint8 *)src->pixels + src->pitch + x * src->format->BytesPerPixel,
+                                   (Uint8 *)src->pixels + src->format->BytesPerPixel, src->format->BytesPerPixel);
+                    }
+                    SDL_SetColorKey(src, SDL_TRUE, key);
+                }
+
+                srcrect.x = (mode & 2) ? 1 : 0;
+                srcrect.y = 0;
+                srcrect.w = width - 3;
+                srcrect.h = height;
+                dstrect.x = (mode & 2) ? 2 : 0;
+                dstrect.y = 0;
+                dstrect.w = srcrect.w;
+                dstrect.h = height;
+                ret = SDL_BlitSurface(src, &srcrect, dst, &dstrect);
+                SDLTest_AssertCheck(ret == 0, "Verify result from SDL_BlitSurface, expected: 0, got: %i", ret);
+
+                mask = dst->format->Rmask | dst->format->Gmask | dst->format->Bmask | dst->format->Amask;
+                bad = 0;
+                for (y = 0; y < height; y++) {
+                    for (x = 0; x < srcrect.w; x++) {
+                        pixel = surface_getPixel(src, srcrect.x + x, y);
+                        if ((mode & 1) && (pixel & ~src->format->Amask) == (key & ~src->format->Amask)) {
+                            expected = surface_getPixel(orig, dstrect.x + x, y);
+                        } else {
+                            SDL_GetRGBA(pixel, src->format, &r, &g, &b, &a);
+                            expected = SDL_MapRGBA(dst->format, r, g, b, a);
+                        }
+                        actual = surface_getPixel(dst, dstrect.x + x, y);
+                        if ((actual & mask) != (expected & mask)) {
+                            if (bad++ == 0) {
+                                SDLTest_LogError("Pixel %d,%d: got 0x%08x, expected 0x%08x", dstrect.x + x, y, actual, expected);
+                            }
+                        }
+                    }
+                }
+                SDLTest_AssertCheck(bad == 0, "Verify blit from %s to %s in mode %d, %d pixels differ",
+                                    SDL_GetPixelFormatName(formats[i]), SDL_GetPixelFormatName(formats[j]), mode, bad);
+
+                SDL_FreeSurface(src);
+                SDL_FreeSurface(dst);
+                SDL_FreeSurface(orig);
+            }
+        }
+    }
+
+    return TEST_COMPLETED;
+}
+
 int surface_testOverflow(void *arg)
 {
     char buf[1024];
@@ -815,6 +1072,18 @@ static const SDLTest_TestCaseReference surfaceTest12 = {
     (SDLTest_TestCaseFp)surface_testBlitBlendMod, "surface_testBlitBlendMod", "Tests blitting routines with mod blending mode.", TEST_ENABLED
 };
 
+static const SDLTest_TestCaseReference surfaceTest13 = {
+    (SDLTest_TestCaseFp)surface_testBlitAlphaColumns, "surface_testBlitAlphaColumns", "Tests that alpha blits of whole rows match single pixels.", TEST_ENABLED
+};
+
+static const SDLTest_TestCaseReference surfaceTest14 = {
+    (SDLTest_TestCaseFp)surface_testBlitConversion, "surface_testBlitConversion", "Tests blits between pixel formats against a per pixel conversion.", TEST_ENABLED
+};
+
+static const SDLTest_TestCaseReference surfaceTest15 = {
+    (SDLTest_TestCaseFp)surface_testBlitAlphaRounding, "surface_testBlitAlphaRounding", "Tests the rounding of per pixel alpha blits.", TEST_ENABLED
+};
+
 static const SDLTest_TestCaseReference surfaceTestOverflow = {
     surface_testOverflow, "surface_testOverflow", "Test overflow detection.", TEST_ENABLED
 };
@@ -823,7 +1092,7 @@ static const SDLTest_TestCaseReference surfaceTestOverflow = {
 static const SDLTest_TestCaseReference *surfaceTests[] = {
     &surfaceTest1, &surfaceTest2, &surfaceTest3, &surfaceTest4, &surfaceTest5,
     &surfaceTest6, &surfaceTest7, &surfaceTest8, &surfaceTest9, &surfaceTest10,
-    &surfaceTest11, &surfaceTest12, &surfaceTestOverflow, NULL
+    &surfaceTest11, &surfaceTest12, &surfaceTest13, &surfaceTest14, &surfaceTest15, &surfaceTestOverflow, NULL
 };
 
 /* Surface test suite (global) */
@@ -0,0 +1,227 @@
+/*
+  Copyright (C) 1997-2023 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Drives the mali-fbdev swap pipeline and reports throughput, latency and
+ * dropped frames. Built with SDL_MALI_SIM it runs on a desktop, e.g.:
+ *
+ *   SDL_VIDEODRIVER=mali ./testmalibench --frames 600 --work 8 --jitter 12
+ *
+ * Each frame busy-waits for the given amount of "rendering" on top of a
+ * clear, the jitter adds a random amount up to that much more so frames
+ * miss their vblank now and then. With --stacked, a second, half transparent
+ * window is shown centered over the first one and redrawn along with it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SDL.h"
+#include "SDL_opengles2.h"
+
+#if defined(__LINUX__) && !defined(__ANDROID__)
+
+static void
+usage(const char *argv0)
+{
+    SDL_Log("Usage: %s [--frames N] [--buffers 2-4] [--vsync 0|1] [--work MS] [--jitter MS]"
+            " [--size WxH] [--stacked WxH] [--max-dropped PERCENT]", argv0);
+}
+
+static void
+busy_wait(double ms)
+{
+    Uint64 end = SDL_GetPerformanceCounter() + (Uint64)(ms * SDL_GetPerformanceFrequency() / 1000.0);
+
+    while (SDL_GetPerformanceCounter() < end) {
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    PFNGLCLEARCOLORPROC glClearColor_;
+    PFNGLCLEARPROC glClear_;
+    SDL_Window *window, *stacked = NULL;
+    SDL_GLContext context;
+    SDL_MaliFrameStats stats;
+    SDL_Event event;
+    int frames = 600, vsync = 1, w = 0, h = 0, stacked_w = 0, stacked_h = 0, i;
+    double work = 0.0, jitter = 0.0, max_dropped = -1.0, swap, swap_max = 0.0, swap_total = 0.0, seconds, dropped;
+    const char *buffers = NULL;
+    char count[16];
+    Uint64 start, before;
+
+    for (i = 1; i < argc; i++) {
+        if (i + 1 < argc && SDL_strcmp(argv[i], "--frames") == 0) {
+            frames = SDL_atoi(argv[++i]);
+        } else if (i + 1 < argc && SDL_strcmp(argv[i], "--buffers") == 0) {
+            buffers = argv[++i];
+        } else if (i + 1 < argc && SDL_strcmp(argv[i], "--vsync") == 0) {
+            vsync = SDL_atoi(argv[++i]);
+        } else if (i + 1 < argc && SDL_strcmp(argv[i], "--work") == 0) {
+            work = SDL_atof(argv[++i]);
+        } else if (i + 1 < argc && SDL_strcmp(argv[i], "--jitter") == 0) {
+            jitter = SDL_atof(argv[++i]);
+        } else if (i + 1 < argc && SDL_strcmp(argv[i], "--size") == 0) {
+            if (SDL_sscanf(argv[++i], "%dx%d", &w, &h) != 2) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (i + 1 < argc && SDL_strcmp(argv[i], "--stacked") == 0) {
+            if (SDL_sscanf(argv[++i], "%dx%d", &stacked_w, &stacked_h) != 2) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (i + 1 < argc && SDL_strcmp(argv[i], "--max-dropped") == 0) {
+            max_dropped = SDL_atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (frames <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    /* Keep the timings of the whole run, not just the most recent frames */
+    SDL_snprintf(count, sizeof(count), "%d", frames);
+    SDL_SetHint("SDL_MALI_STATS_FRAMES", count);
+    if (buffers)
+        SDL_SetHint("SDL_MALI_BUFFERS", buffers);
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't initialize SDL: %s", SDL_GetError());
+        return 1;
+    }
+
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+
+    window = SDL_CreateWindow("testmalibench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                              w, h, SDL_WINDOW_OPENGL | (w && h ? 0 : SDL_WINDOW_FULLSCREEN_DESKTOP));
+    if (!window) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create window: %s", SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+
+    if (stacked_w > 0 && stacked_h > 0) {
+        stacked = SDL_CreateWindow("testmalibench stacked", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                                   stacked_w, stacked_h, SDL_WINDOW_OPENGL);
+        if (!stacked) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create stacked window: %s", SDL_GetError());
+            SDL_Quit();
+            return 1;
+        }
+        SDL_SetWindowOpacity(stacked, 0.5f);
+    }
+
+    context = SDL_GL_CreateContext(window);
+    if (!context) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create context: %s", SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+    SDL_GL_SetSwapInterval(vsync);
+
+    glClearColor_ = (PFNGLCLEARCOLORPROC)SDL_GL_GetProcAddress("glClearColor");
+    glClear_ = (PFNGLCLEARPROC)SDL_GL_GetProcAddress("glClear");
+    if (!glClearColor_ || !glClear_) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't load GL functions: %s", SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+
+    SDL_GetWindowSize(window, &w, &h);
+    SDL_Log("Running %d frames at %dx%d, vsync %d, %.1f ms of work plus up to %.1f ms of jitter",
+            frames, w, h, vsync, work, jitter);
+
+    start = SDL_GetPerformanceCounter();
+    for (i = 0; i < frames; i++) {
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT)
+                frames = i;
+        }
+
+        glClearColor_((i & 0xFF) / 255.0f, ((i >> 8) & 0xFF) / 255.0f, 0.5f, 1.0f);
+        glClear_(GL_COLOR_BUFFER_BIT);
+        busy_wait(work + jitter * (rand() / (double)RAND_MAX));
+
+        before = SDL_GetPerformanceCounter();
+        SDL_GL_SwapWindow(window);
+        swap = (double)(SDL_GetPerformanceCounter() - before) * 1000.0 / SDL_GetPerformanceFrequency();
+        swap_total += swap;
+        swap_max = SDL_max(swap_max, swap);
+
+        if (stacked) {
+            SDL_GL_MakeCurrent(stacked, context);
+            glClearColor_(1.0f, (i & 1) ? 1.0f : 0.0f, 0.0f, 1.0f);
+            glClear_(GL_COLOR_BUFFER_BIT);
+            SDL_GL_SwapWindow(stacked);
+            SDL_GL_MakeCurrent(window, context);
+        }
+    }
+    seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    /* Let the blitter catch up with the last frame */
+    SDL_Delay(100);
+
+    if (SDL_MaliGetFrameStats(window, &stats) < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't get frame stats: %s", SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+
+    dropped = stats.submitted ? 100.0 * stats.dropped / stats.submitted : 0.0;
+    SDL_Log("Throughput: %.1f frames/s submitted, %.1f frames/s presented over %.2f s",
+            stats.submitted / seconds, stats.presented / seconds, seconds);
+    SDL_Log("Frames: %u submitted, %u presented, %u dropped (%.1f%%)",
+            stats.submitted, stats.presented, stats.dropped, dropped);
+    SDL_Log("Swap call: %.2f ms avg, %.2f ms max", frames ? swap_total / frames : 0.0, swap_max);
+    SDL_Log("Latency (us, %u frames):  min %6u  avg %6u  p99 %6u", stats.samples, stats.latency.min, stats.latency.avg, stats.latency.p99);
+    SDL_Log("Fence (us):               min %6u  avg %6u  p99 %6u", stats.fence.min, stats.fence.avg, stats.fence.p99);
+    SDL_Log("Present (us):             min %6u  avg %6u  p99 %6u", stats.present.min, stats.present.avg, stats.present.p99);
+    SDL_Log("Interval (us):            min %6u  avg %6u  p99 %6u", stats.interval.min, stats.interval.avg, stats.interval.p99);
+
+    if (stacked && SDL_MaliGetFrameStats(stacked, &stats) == 0) {
+        SDL_Log("Stacked window: %u submitted, %u presented, %u dropped",
+                stats.submitted, stats.presented, stats.dropped);
+    }
+
+    SDL_GL_DeleteContext(context);
+    if (stacked)
+        SDL_DestroyWindow(stacked);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+
+    if (max_dropped >= 0.0 && dropped > max_dropped) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Dropped %.1f%% of the frames, more than %.1f%%", dropped, max_dropped);
+        return 1;
+    }
+    return 0;
+}
+
+#else
+
+int
+main(int argc, char *argv[])
+{
+    SDL_Log("No mali-fbdev support on this platform\n");
+    return 1;
+}
+
+#endif /* __LINUX__ */
+
+/* vi: set ts=4 sw=4 expandtab: */